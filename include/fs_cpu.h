@@ -0,0 +1,84 @@
+#ifndef FREESTANDING_CPU_H
+#define FREESTANDING_CPU_H
+
+
+#include "fs_int.h"
+
+
+#define FS_CPU_SSE2             ((unsigned)1 << 0)
+#define FS_CPU_SSSE3            ((unsigned)1 << 1)
+#define FS_CPU_AVX2             ((unsigned)1 << 2)
+#define FS_CPU_AVX512BW         ((unsigned)1 << 3)
+
+
+/* x86-64 with GCC compatible inline asm, vector extensions and target attributes,
+ * define FS_NO_SIMD or FS_PROFILE_SIZE to keep everything scalar */
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(FS_NO_SIMD) && !defined(FS_PROFILE_SIZE)
+#  define FS_CPU_X86_64
+#endif
+
+
+
+#ifdef FS_CPU_X86_64
+
+static FS_MAYBE_UNUSED void fs_cpuid(fs_u32 leaf, fs_u32 subleaf, fs_u32 regs[4])
+{
+    __asm__ __volatile__ ("cpuid"
+        : "=a"(regs[0]), "=b"(regs[1]), "=c"(regs[2]), "=d"(regs[3])
+        : "a"(leaf), "c"(subleaf)
+    );
+}
+
+
+/* the extended register state that the OS saves on a context switch */
+static FS_MAYBE_UNUSED fs_u32 fs_xgetbv0(void)
+{
+    fs_u32 lo, hi;
+    __asm__ __volatile__ ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    (void)hi;
+    return lo;
+}
+
+
+/* returns the FS_CPU_* features of the running CPU that the OS also supports */
+static FS_MAYBE_UNUSED unsigned int fs_cpu_features(void)
+{
+    fs_u32 regs[4];
+    fs_u32 max_leaf, xcr0 = 0;
+    unsigned int features = 0;
+
+    fs_cpuid(0, 0, regs);
+    max_leaf = regs[0];
+    if (max_leaf < 1)
+        return 0;
+
+    fs_cpuid(1, 0, regs);
+    if (regs[3] & ((fs_u32)1 << 26)) features |= FS_CPU_SSE2;
+    if (regs[2] & ((fs_u32)1 << 9)) features |= FS_CPU_SSSE3;
+    if (regs[2] & ((fs_u32)1 << 27)) /* OSXSAVE */
+        xcr0 = fs_xgetbv0();
+
+    /* ymm state saved */
+    if (max_leaf >= 7 && (xcr0 & 0x6) == 0x6)
+    {
+        fs_cpuid(7, 0, regs);
+        if (regs[1] & ((fs_u32)1 << 5))
+            features |= FS_CPU_AVX2;
+
+        /* AVX-512F and BW, with the opmask and zmm state saved */
+        if ((xcr0 & 0xE6) == 0xE6
+        && (regs[1] & ((fs_u32)1 << 16)) && (regs[1] & ((fs_u32)1 << 30)))
+            features |= FS_CPU_AVX512BW;
+    }
+    return features;
+}
+
+#else
+
+#  define fs_cpu_features() 0u
+
+#endif /* FS_CPU_X86_64 */
+
+
+
+#endif /* FREESTANDING_CPU_H */
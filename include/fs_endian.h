@@ -3,41 +3,101 @@
 
 
 #include "fs_int.h"
+#include "fs_cpu.h"
 
+#define FS_ENDIAN_LITTLE ((fs_u32)0x03020100)
+#define FS_ENDIAN_BIG ((fs_u32)0x00010203)
+#define FS_ENDIAN_PDP ((fs_u32)0x01000302)
+#define FS_ENDIAN_HONEYWELL ((fs_u32)0x02030001)
+
+
+/* 
+ * FS_ENDIAN_HOST is the byte order when the compiler tells it, 
+ * so that FS_ENDIANNESS() is a constant and the other branches are dropped, 
+ * define it to one of the above to set it for other compilers 
+ */
+#ifndef FS_ENDIAN_HOST
+#  if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) \
+    && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#    define FS_ENDIAN_HOST FS_ENDIAN_LITTLE
+#  elif defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) \
+    && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#    define FS_ENDIAN_HOST FS_ENDIAN_BIG
+#  elif defined(__BYTE_ORDER__) && defined(__ORDER_PDP_ENDIAN__) \
+    && __BYTE_ORDER__ == __ORDER_PDP_ENDIAN__
+#    define FS_ENDIAN_HOST FS_ENDIAN_PDP
+#  elif defined(_M_IX86) || defined(_M_X64) || defined(_M_AMD64) || defined(_M_ARM) \
+    || defined(_M_ARM64) || defined(__i386__) || defined(__x86_64__)
+#    define FS_ENDIAN_HOST FS_ENDIAN_LITTLE
+#  endif
+#endif /* FS_ENDIAN_HOST */
+
+
+#ifdef FS_ENDIAN_HOST
+#  define FS_ENDIANNESS() (FS_ENDIAN_HOST)
+#else
+/* unknown compilers probe the byte order at runtime */
 static const union {
     fs_u8 bytes[4];
     fs_u32 u32;
 } s_fs_internal_endian_test = {{0, 1, 2, 3}};
 
+#  define FS_ENDIANNESS() ((s_fs_internal_endian_test).u32)
+#endif /* FS_ENDIAN_HOST */
+
+#define FS_ENDIAN_IS(endian_type) (FS_ENDIANNESS() == (endian_type))
 
-#define FS_ENDIAN_LITTLE ((fs_u32)0x03020100)
-#define FS_ENDIAN_BIG ((fs_u32)0x000102030)
-#define FS_ENDIAN_PDP ((fs_u32)0x01000302)
-#define FS_ENDIAN_HONEYWELL ((fs_u32)0x02030001)
 
 
-#define FS_ENDIAN_IS(endian_type) ((s_fs_internal_endian_test).u32 == (endian_type))
-#define FS_ENDIANNESS() ((s_fs_internal_endian_test).u32)
+/* GCC 4.8 and clang have __builtin_bswap16/32/64, which compile to a single instruction */
+#if defined(__clang__) \
+    || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 8)))
+#  define FS_ENDIAN_BUILTINS
+#endif
 
+/* bulk conversions of at least this many bytes use the vector kernels */
+#define FS_ENDIAN_VECTOR_MIN 64
 
 
-static fs_u32 fs_endian_bswap32(fs_u32 n)
+
+static FS_MAYBE_UNUSED fs_u16 fs_endian_bswap16(fs_u16 n)
 {
-    fs_u32 ret;
-    fs_u8 *pn = (fs_u8*)&n;
-    fs_u8 *pr = (fs_u8*)&ret;
+#ifdef FS_ENDIAN_BUILTINS
+    return __builtin_bswap16(n);
+#else
+    return (fs_u16)(((n << 8) & 0xFF00) | ((n >> 8) & 0x00FF));
+#endif /* FS_ENDIAN_BUILTINS */
+}
+
 
-    pr[0] = pn[3];
-    pr[1] = pn[2];
-    pr[2] = pn[1];
-    pr[3] = pn[0];
-    return ret;
+static FS_MAYBE_UNUSED fs_u32 fs_endian_bswap32(fs_u32 n)
+{
+#ifdef FS_ENDIAN_BUILTINS
+    return __builtin_bswap32(n);
+#else
+    n = ((n << 8) & 0xFF00FF00) | ((n >> 8) & 0x00FF00FF);
+    return ((n << 16) & 0xFFFF0000) | ((n >> 16) & 0x0000FFFF);
+#endif /* FS_ENDIAN_BUILTINS */
 }
 
 
-static void fs_endian_bswap(void *bytes, fs_size count)
+#ifdef FS_64BIT_DEFINED
+static FS_MAYBE_UNUSED fs_u64 fs_endian_bswap64(fs_u64 n)
 {
-    fs_size i = 0; 
+#ifdef FS_ENDIAN_BUILTINS
+    return __builtin_bswap64(n);
+#else
+    n = ((n << 8) & 0xFF00FF00FF00FF00llu) | ((n >> 8) & 0x00FF00FF00FF00FFllu);
+    n = ((n << 16) & 0xFFFF0000FFFF0000llu) | ((n >> 16) & 0x0000FFFF0000FFFFllu);
+    return (n << 32) | (n >> 32);
+#endif /* FS_ENDIAN_BUILTINS */
+}
+#endif /* FS_64BIT_DEFINED */
+
+
+static FS_MAYBE_UNUSED void fs_endian_bswap(void *bytes, fs_size count)
+{
+    fs_size i = 0;
     fs_u8 *bptr = bytes;
     for (; i < count/2; i += 1)
     {
@@ -49,55 +109,229 @@ static void fs_endian_bswap(void *bytes, fs_size count)
 
 
 
-static void fs_endian_host_to_little(fs_u8 *buf, fs_size count, unsigned int elem_size)
+
+/*
+ * the bulk kernels, in place over arrays that need not be aligned:
+ * reversing the bytes of each element (big endian),
+ * reversing the 16 bit words of each element (PDP),
+ * and swapping the bytes of each 16 bit word (Honeywell), which is a 16 bit byte swap
+ */
+
+#ifdef FS_CPU_X86_64
+
+typedef char fs_internal_endian_v16 __attribute__((vector_size(16), may_alias));
+typedef char fs_internal_endian_v16u __attribute__((vector_size(16), may_alias, aligned(1)));
+typedef char fs_internal_endian_v32 __attribute__((vector_size(32), may_alias));
+typedef char fs_internal_endian_v32u __attribute__((vector_size(32), may_alias, aligned(1)));
+
+/* FS_CPU_* features, ~0u until detected */
+static unsigned int s_fs_internal_endian_features = ~0u;
+
+
+/* returns the number of bytes swapped, a multiple of 16 */
+__attribute__((target("ssse3")))
+static FS_MAYBE_UNUSED fs_size fs_internal_bswap_ssse3(fs_u8 *buf, fs_size bytes, unsigned int elem_size)
 {
+    fs_internal_endian_v16 shuffle;
+    fs_size i;
+
+    for (i = 0; i < 16; i += 1)
+        shuffle[i] = (char)((i & ~(fs_size)(elem_size - 1)) + (elem_size - 1 - (i & (elem_size - 1))));
+    for (i = 0; i + 16 <= bytes; i += 16)
+    {
+        *(fs_internal_endian_v16u *)(buf + i) = __builtin_ia32_pshufb128(
+            *(fs_internal_endian_v16u *)(buf + i), shuffle);
+    }
+    return i;
+}
+
+
+/* the shuffle works within 16 byte lanes, so the pattern is the same in both */
+__attribute__((target("avx2")))
+static FS_MAYBE_UNUSED fs_size fs_internal_bswap_avx2(fs_u8 *buf, fs_size bytes, unsigned int elem_size)
+{
+    fs_internal_endian_v32 shuffle;
+    fs_size i;
+
+    for (i = 0; i < 32; i += 1)
+        shuffle[i] = (char)(((i & 15) & ~(fs_size)(elem_size - 1)) + (elem_size - 1 - (i & (elem_size - 1))));
+    for (i = 0; i + 32 <= bytes; i += 32)
+    {
+        *(fs_internal_endian_v32u *)(buf + i) = __builtin_ia32_pshufb256(
+            *(fs_internal_endian_v32u *)(buf + i), shuffle);
+    }
+    return i;
+}
+
+#endif /* FS_CPU_X86_64 */
+
+
+#ifdef __GNUC__
+typedef fs_u16 fs_internal_u16u __attribute__((aligned(1), may_alias));
+typedef fs_u32 fs_internal_u32u __attribute__((aligned(1), may_alias));
+#  ifdef FS_64BIT_DEFINED
+typedef fs_u64 fs_internal_u64u __attribute__((aligned(1), may_alias));
+#  endif /* FS_64BIT_DEFINED */
+#endif /* __GNUC__ */
+
+
+/* reverses the bytes of count elements of elem_size 2, 4 or 8 */
+static FS_MAYBE_UNUSED void fs_internal_bswap_array(void *buf, fs_size count, unsigned int elem_size)
+{
+    fs_u8 *bytes = buf;
     fs_size i = 0;
-    union {
-        fs_u32 *dwptr;
-        fs_u8 *byteptr;
-    } cvt;
+    fs_size n = count * elem_size;
+
+#ifdef FS_CPU_X86_64
+    if (n >= FS_ENDIAN_VECTOR_MIN)
+    {
+        if (~0u == s_fs_internal_endian_features)
+            s_fs_internal_endian_features = fs_cpu_features();
+        if (s_fs_internal_endian_features & FS_CPU_AVX2)
+            i = fs_internal_bswap_avx2(bytes, n, elem_size);
+        else if (s_fs_internal_endian_features & FS_CPU_SSSE3)
+            i = fs_internal_bswap_ssse3(bytes, n, elem_size);
+    }
+#endif /* FS_CPU_X86_64 */
+
+#ifdef __GNUC__
+    switch (elem_size)
+    {
+    case 2:
+        for (; i < n; i += 2)
+            *(fs_internal_u16u *)(bytes + i) = fs_endian_bswap16(*(fs_internal_u16u *)(bytes + i));
+        return;
+    case 4:
+        for (; i < n; i += 4)
+            *(fs_internal_u32u *)(bytes + i) = fs_endian_bswap32(*(fs_internal_u32u *)(bytes + i));
+        return;
+#  ifdef FS_64BIT_DEFINED
+    case 8:
+        for (; i < n; i += 8)
+            *(fs_internal_u64u *)(bytes + i) = fs_endian_bswap64(*(fs_internal_u64u *)(bytes + i));
+        return;
+#  endif /* FS_64BIT_DEFINED */
+    }
+#endif /* __GNUC__ */
+
+    for (; i < n; i += elem_size)
+        fs_endian_bswap(bytes + i, elem_size);
+}
+
+
+/* reverses the 16 bit words of count elements of elem_size 4 or 8 */
+static FS_MAYBE_UNUSED void fs_internal_wswap_array(void *buf, fs_size count, unsigned int elem_size)
+{
+    fs_u8 *bytes = buf;
+    fs_size i = 0;
+    unsigned int lo, hi;
+    fs_u8 tmp;
+
+    for (; i < count * elem_size; i += elem_size)
+    {
+        for (lo = 0, hi = elem_size - 2; lo < hi; lo += 2, hi -= 2)
+        {
+            tmp = bytes[i + lo];
+            bytes[i + lo] = bytes[i + hi];
+            bytes[i + hi] = tmp;
+            tmp = bytes[i + lo + 1];
+            bytes[i + lo + 1] = bytes[i + hi + 1];
+            bytes[i + hi + 1] = tmp;
+        }
+    }
+}
+
+
+/* to little endian when to_big is 0, to big endian otherwise, the conversions back are the same */
+static FS_MAYBE_UNUSED void fs_internal_endian_convert(void *buf, fs_size count,
+    unsigned int elem_size, int to_big)
+{
+    if (elem_size < 2)
+        return;
 
     switch (FS_ENDIANNESS())
     {
     default:
-    case FS_ENDIAN_LITTLE: break;
+    case FS_ENDIAN_LITTLE:
+        if (to_big)
+            fs_internal_bswap_array(buf, count, elem_size);
+        break;
+
     case FS_ENDIAN_BIG:
-        for (; i < count * elem_size; i += elem_size)
-            fs_endian_bswap(&buf[i], elem_size);
+        if (!to_big)
+            fs_internal_bswap_array(buf, count, elem_size);
         break;
 
-    case FS_ENDIAN_PDP: /* u32 only */
-        if (elem_size == sizeof(fs_u32))
-        {
-            for (; i < count * sizeof(fs_u32); i += sizeof(fs_u32))
-            {
-                fs_u32 dword;
-
-                cvt.byteptr = &buf[i];
-                dword = *cvt.dwptr;
-                *cvt.dwptr = ((dword << 16) & 0xFFFF0000) 
-                    | ((dword >> 16) & 0x0000FFFF);
-            }
-        }
+    /* 16 bit words are little endian, in big endian order */
+    case FS_ENDIAN_PDP:
+        if (to_big)
+            fs_internal_bswap_array(buf, count * (elem_size / 2), 2);
+        else fs_internal_wswap_array(buf, count, elem_size);
         break;
 
-    case FS_ENDIAN_HONEYWELL: /* u32 only */
-        if (elem_size == sizeof(fs_u32))
-        {
-            for (; i < count * sizeof(fs_u32); i += sizeof(fs_u32))
-            {
-                fs_u32 dword;
-
-                cvt.byteptr = &buf[i];
-                dword = *cvt.dwptr;
-                *cvt.dwptr = ((dword << 8) & 0xFF00FF00)
-                    | ((dword >> 8) & 0x00FF00FF);
-            }
-        }
+    /* 16 bit words are big endian, in little endian order */
+    case FS_ENDIAN_HONEYWELL:
+        if (to_big)
+            fs_internal_wswap_array(buf, count, elem_size);
+        else fs_internal_bswap_array(buf, count * (elem_size / 2), 2);
         break;
     }
 }
 
 
-#endif /* FREE_STANDING_ENDIAN_H */
 
+
+/*
+ * converts count elements of buf in place from host byte order to little endian,
+ * which is also the conversion from little endian back to host byte order.
+ * buf does not have to be aligned
+ */
+static FS_MAYBE_UNUSED void fs_endian_host_to_little16(void *buf, fs_size count)
+{
+    fs_internal_endian_convert(buf, count, 2, 0);
+}
+
+static FS_MAYBE_UNUSED void fs_endian_host_to_little32(void *buf, fs_size count)
+{
+    fs_internal_endian_convert(buf, count, 4, 0);
+}
+
+static FS_MAYBE_UNUSED void fs_endian_host_to_little64(void *buf, fs_size count)
+{
+    fs_internal_endian_convert(buf, count, 8, 0);
+}
+
+
+/* the same for big endian */
+static FS_MAYBE_UNUSED void fs_endian_host_to_big16(void *buf, fs_size count)
+{
+    fs_internal_endian_convert(buf, count, 2, 1);
+}
+
+static FS_MAYBE_UNUSED void fs_endian_host_to_big32(void *buf, fs_size count)
+{
+    fs_internal_endian_convert(buf, count, 4, 1);
+}
+
+static FS_MAYBE_UNUSED void fs_endian_host_to_big64(void *buf, fs_size count)
+{
+    fs_internal_endian_convert(buf, count, 8, 1);
+}
+
+
+/* count elements of elem_size 2, 4 or 8, other sizes are reversed on big endian hosts only */
+static FS_MAYBE_UNUSED void fs_endian_host_to_little(fs_u8 *buf, fs_size count, unsigned int elem_size)
+{
+    fs_size i = 0;
+
+    if (2 == elem_size || 4 == elem_size || 8 == elem_size)
+        fs_internal_endian_convert(buf, count, elem_size, 0);
+    else if (FS_ENDIAN_IS(FS_ENDIAN_BIG))
+    {
+        for (; i < count * elem_size; i += elem_size)
+            fs_endian_bswap(&buf[i], elem_size);
+    }
+}
+
+
+#endif /* FREE_STANDING_ENDIAN_H */
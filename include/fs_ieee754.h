@@ -28,17 +28,25 @@ typedef union fs_internal_f32_u32
 } fs_fu32;
 
 
+/* returns true if floating point endian is different from integer endian, false otherwise, 
+ * a constant when the compiler tells the layout of floats */
+#if (defined(__FLOAT_WORD_ORDER__) && defined(__BYTE_ORDER__) \
+    && __FLOAT_WORD_ORDER__ == __BYTE_ORDER__) \
+    || defined(_M_IX86) || defined(_M_X64) || defined(_M_AMD64) \
+    || defined(__i386__) || defined(__x86_64__)
+#  define FS_FLOAT_ENDIAN_DIFFER() 0
+#else
 static const fs_fu32 s_fs_internal_float_endian_test = { 2.0 }; /* 0x40000000 in hex */
 
-/* returns true if floating point endian is different from integer endian, false otherwise */
-#define FS_FLOAT_ENDIAN_DIFFER() \
+#  define FS_FLOAT_ENDIAN_DIFFER() \
     (s_fs_internal_float_endian_test.u32 < 0x00008000)
+#endif
 
 
 
 
 
-static int fs_exp_of_float(float f)
+static FS_MAYBE_UNUSED int fs_exp_of_float(float f)
 {
     fs_fu32 cvt;
     fs_u8 exponent;
@@ -57,7 +65,7 @@ static int fs_exp_of_float(float f)
 
 
 
-static int fs_exp_of_double(double d)
+static FS_MAYBE_UNUSED int fs_exp_of_double(double d)
 {
     fs_u32 exponent;
     if (sizeof(d) == sizeof(float))
@@ -104,7 +112,7 @@ static int fs_exp_of_double(double d)
 }
 
 
-static int fs_exp_of_ldouble(long double ld)
+static FS_MAYBE_UNUSED int fs_exp_of_ldouble(long double ld)
 {
     fs_u32 exponent;
     if (sizeof(ld) == 8) /* 64 bit */
@@ -124,6 +132,53 @@ static int fs_exp_of_ldouble(long double ld)
 
 
 
+/* returns nonzero if the sign bit of d is set, for -0.0 and negative NaNs too */
+static FS_MAYBE_UNUSED int fs_sign_of_double(double d)
+{
+    union {
+        double d;
+        fs_u32 u32[sizeof(double) / sizeof(fs_u32)];
+    } cvt;
+    cvt.d = d;
+
+    if (FS_FLOAT_ENDIAN_DIFFER())
+        fs_endian_bswap(cvt.u32, sizeof cvt.u32);
+    if (FS_ENDIAN_IS(FS_ENDIAN_LITTLE))
+        return (int)(cvt.u32[1] >> (FS_F64_SIGN_POS - 32));
+    return (int)(cvt.u32[0] >> (FS_F64_SIGN_POS - 32));
+}
+
+
+/* assembles a double from its sign, biased exponent, 
+ * and the high 20 and low 32 bits of its mantissa */
+static FS_MAYBE_UNUSED double fs_double_from_parts(int negative, fs_u32 exponent, 
+    fs_u32 mantissa_hi, fs_u32 mantissa_lo)
+{
+    union {
+        double d;
+        fs_u32 u32[sizeof(double) / sizeof(fs_u32)];
+    } cvt;
+    fs_u32 hi = ((fs_u32)(0 != negative) << (FS_F64_SIGN_POS - 32))
+        | ((exponent & FS_F64_EXP) << (FS_F64_EXP_POS - 32))
+        | (mantissa_hi & 0xFFFFF);
+
+    if (FS_ENDIAN_IS(FS_ENDIAN_LITTLE))
+    {
+        cvt.u32[0] = mantissa_lo;
+        cvt.u32[1] = hi;
+    }
+    else 
+    {
+        cvt.u32[0] = hi;
+        cvt.u32[1] = mantissa_lo;
+    }
+
+    if (FS_FLOAT_ENDIAN_DIFFER())
+        fs_endian_bswap(cvt.u32, sizeof cvt.u32);
+    return cvt.d;
+}
+
+
 
 
 #endif /* FREESTANDING_IEEE_754_H */
@@ -37,7 +37,7 @@ typedef int fs_i16;
 #  if ULONG_MAX == 0xfffffffflu
 typedef unsigned long fs_u32;
 typedef long fs_i32;
-#  elif ULONG_MAX == 0xfffffffflu
+#  elif UINT_MAX == 0xffffffffu
 typedef unsigned int fs_u32;
 typedef int fs_i32;
 #  else
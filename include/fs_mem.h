@@ -1,8 +1,200 @@
 #ifndef FREESTANDING_MEM_H
 #define FREESTANDING_MEM_H
 
+
+#include "fs_int.h"
+#include "fs_standard.h"
+#include "fs_cpu.h"
+
+
 #define FS_STATIC_ARRAYSIZE(s_arr) (sizeof(s_arr) / sizeof((s_arr)[0]))
 
 
-#endif /* FREESTANDING_MEM_H */
 
+/*
+ * memcpy, memset, memchr and strnlen for builds without libc.
+ * they go a word (fs_size) at a time once the pointers are aligned,
+ * and 16 bytes at a time on x86-64, where every CPU has SSE2
+ */
+
+#ifdef __GNUC__
+typedef fs_size fs_mem_word __attribute__((may_alias));
+#else
+typedef fs_size fs_mem_word;
+#endif /* __GNUC__ */
+
+/* targets that load and store unaligned words at full speed */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__))
+#  define FS_MEM_UNALIGNED
+typedef fs_size fs_mem_word_u __attribute__((may_alias, aligned(1)));
+#endif
+
+#ifdef FS_CPU_X86_64
+#  define FS_MEM_SSE2
+typedef char fs_mem_v16 __attribute__((vector_size(16), may_alias));
+typedef char fs_mem_v16u __attribute__((vector_size(16), may_alias, aligned(1)));
+#endif /* FS_CPU_X86_64 */
+
+/* FS_MEM_HAS_ZERO(x) is nonzero if any byte of x is 0 */
+#define FS_MEM_ONES             ((fs_size)-1 / 0xFF)
+#define FS_MEM_HIGHS            (FS_MEM_ONES * 0x80)
+#define FS_MEM_HAS_ZERO(x)      (((x) - FS_MEM_ONES) & ~(x) & FS_MEM_HIGHS)
+#define FS_MEM_MISALIGNMENT(p)  ((uintptr_t)(p) & (sizeof(fs_size) - 1))
+
+/* fs_strnlen() reads the whole aligned word or vector that holds the terminator,
+ * which is past the end of the string, but never in another page */
+#if defined(__SANITIZE_ADDRESS__)
+#  define FS_MEM_SCAN __attribute__((no_sanitize_address))
+#else
+#  define FS_MEM_SCAN
+#endif
+
+
+
+static FS_MAYBE_UNUSED void *fs_memcpy(void *dst, const void *src, fs_size n)
+{
+    fs_u8 *d = dst;
+    const fs_u8 *s = src;
+
+#ifdef FS_MEM_SSE2
+    /* the last vector overlaps the one before it */
+    if (n >= 16)
+    {
+        for (; n > 16; n -= 16, d += 16, s += 16)
+            *(fs_mem_v16u *)d = *(const fs_mem_v16u *)s;
+        *(fs_mem_v16u *)(d + n - 16) = *(const fs_mem_v16u *)(s + n - 16);
+        return dst;
+    }
+#endif /* FS_MEM_SSE2 */
+
+    if (n >= 2 * sizeof(fs_size) && FS_MEM_MISALIGNMENT(d) == FS_MEM_MISALIGNMENT(s))
+    {
+        for (; FS_MEM_MISALIGNMENT(d); n -= 1)
+            *d++ = *s++;
+        for (; n >= sizeof(fs_size); n -= sizeof(fs_size), d += sizeof(fs_size), s += sizeof(fs_size))
+            *(fs_mem_word *)d = *(const fs_mem_word *)s;
+    }
+#ifdef FS_MEM_UNALIGNED
+    else for (; n >= sizeof(fs_size); n -= sizeof(fs_size), d += sizeof(fs_size), s += sizeof(fs_size))
+        *(fs_mem_word_u *)d = *(const fs_mem_word_u *)s;
+#endif /* FS_MEM_UNALIGNED */
+
+    for (; n; n -= 1)
+        *d++ = *s++;
+    return dst;
+}
+
+
+static FS_MAYBE_UNUSED void *fs_memset(void *dst, int c, fs_size n)
+{
+    fs_u8 *d = dst;
+    const fs_size word = FS_MEM_ONES * (fs_u8)c;
+
+#ifdef FS_MEM_SSE2
+    if (n >= 16)
+    {
+        const fs_mem_v16 zeros = {0};
+        const fs_mem_v16 chars = zeros + (char)c;
+        for (; n > 16; n -= 16, d += 16)
+            *(fs_mem_v16u *)d = chars;
+        *(fs_mem_v16u *)(d + n - 16) = chars;
+        return dst;
+    }
+#endif /* FS_MEM_SSE2 */
+
+    if (n >= 2 * sizeof(fs_size))
+    {
+        for (; FS_MEM_MISALIGNMENT(d); n -= 1)
+            *d++ = (fs_u8)c;
+        for (; n >= sizeof(fs_size); n -= sizeof(fs_size), d += sizeof(fs_size))
+            *(fs_mem_word *)d = word;
+    }
+    for (; n; n -= 1)
+        *d++ = (fs_u8)c;
+    return dst;
+}
+
+
+/* only reads the n bytes of s */
+static FS_MAYBE_UNUSED void *fs_memchr(const void *s, int c, fs_size n)
+{
+    const fs_u8 *p = s;
+    const fs_u8 ch = (fs_u8)c;
+    const fs_size pattern = FS_MEM_ONES * ch;
+
+#ifdef FS_MEM_SSE2
+    const fs_mem_v16 zeros = {0};
+    const fs_mem_v16 chars = zeros + (char)ch;
+    unsigned int mask;
+
+    for (; n >= 16; n -= 16, p += 16)
+    {
+        mask = (unsigned int)__builtin_ia32_pmovmskb128(*(const fs_mem_v16u *)p == chars);
+        if (mask)
+            return (void *)(p + __builtin_ctz(mask));
+    }
+#endif /* FS_MEM_SSE2 */
+
+    for (; n && FS_MEM_MISALIGNMENT(p); n -= 1, p += 1)
+    {
+        if (ch == *p)
+            return (void *)p;
+    }
+    for (; n >= sizeof(fs_size); n -= sizeof(fs_size), p += sizeof(fs_size))
+    {
+        if (FS_MEM_HAS_ZERO(*(const fs_mem_word *)p ^ pattern))
+            break;
+    }
+    for (; n; n -= 1, p += 1)
+    {
+        if (ch == *p)
+            return (void *)p;
+    }
+    return NULL;
+}
+
+
+/* the length of s, but at most limit */
+FS_MEM_SCAN
+static FS_MAYBE_UNUSED fs_size fs_strnlen(const char *s, fs_size limit)
+{
+    fs_size i = 0;
+
+#ifdef FS_MEM_SSE2
+    /* aligned vectors, starting from the one that holds s */
+    const char *p = (const char *)((uintptr_t)s & ~(uintptr_t)15);
+    const fs_mem_v16 zeros = {0};
+    unsigned int mask;
+
+    if (0 == limit)
+        return 0;
+    mask = (unsigned int)__builtin_ia32_pmovmskb128(*(const fs_mem_v16 *)p == zeros) >> (s - p);
+    if (mask)
+        return (fs_size)__builtin_ctz(mask) < limit ? (fs_size)__builtin_ctz(mask) : limit;
+    for (i = 16 - (fs_size)(s - p); i < limit; i += 16)
+    {
+        p += 16;
+        mask = (unsigned int)__builtin_ia32_pmovmskb128(*(const fs_mem_v16 *)p == zeros);
+        if (mask)
+            return i + __builtin_ctz(mask) < limit ? i + __builtin_ctz(mask) : limit;
+    }
+    return limit;
+#else
+    for (; i < limit && FS_MEM_MISALIGNMENT(s + i); i += 1)
+    {
+        if (0 == s[i])
+            return i;
+    }
+    for (; i < limit; i += sizeof(fs_size))
+    {
+        if (FS_MEM_HAS_ZERO(*(const fs_mem_word *)(s + i)))
+            break;
+    }
+    for (; i < limit && s[i]; i += 1)
+    {}
+    return i < limit ? i : limit;
+#endif /* FS_MEM_SSE2 */
+}
+
+
+#endif /* FREESTANDING_MEM_H */
@@ -0,0 +1,70 @@
+#ifndef FREESTANDING_PACK_H
+#define FREESTANDING_PACK_H
+
+
+#include <stdarg.h>
+#include "fs_int.h"
+
+
+/*
+ * binary records described by a format, like Python's struct.pack:
+ *  <, >, !, =   the byte order of the fields that follow: little endian, 
+ *               big endian, network (big endian) and host, the default is <
+ *  u8, u16, u32, u64   unsigned integers
+ *  i8, i16, i32, i64   signed integers, the same bytes as the unsigned ones
+ *  f32, f64     IEEE 754 float and double
+ *  Ns           N bytes as they are
+ *  Nx           N zero bytes, skipped when unpacking
+ * a count before a number field makes it an array: 4u16 is four u16 in a row, 
+ * arrays are converted with the bulk kernels of fs_endian.h. 
+ * whitespace is ignored, "<u32 4u16 f64 16s" is a valid format. 
+ *
+ * fs_pack() takes the value of each single number field: int for 8 and 16 bit fields, 
+ * fs_u32 or fs_i32 for 32 bit fields, fs_u64 or fs_i64 for 64 bit fields (which need 
+ * FS_64BIT_DEFINED), double for f32 and f64, and a pointer to the elements for arrays 
+ * and s fields. fs_unpack() takes a pointer to where each field is stored: fs_u8 *, 
+ * fs_u16 *, fs_u32 *, fs_u64 * or their signed types, float *, double *, and void * for s. 
+ * x fields take no argument.
+ *
+ * both return the size of the record, or -1 if fmt is invalid. 
+ * if the record is larger than bufsz, nothing is written or read, 
+ * so fs_pack(NULL, 0, fmt) returns the size
+ */
+int fs_pack(void *buf, fs_size bufsz, const char *fmt, ...);
+int fs_vpack(void *buf, fs_size bufsz, const char *fmt, va_list ap);
+int fs_unpack(const void *buf, fs_size bufsz, const char *fmt, ...);
+int fs_vunpack(const void *buf, fs_size bufsz, const char *fmt, va_list ap);
+
+
+
+/* a field of a compiled format */
+typedef struct fs_pack_field
+{
+    unsigned char type;
+    unsigned char order;
+    unsigned char elem_size;
+    unsigned char is_array; /* has a count, even if it is 1 */
+    fs_size count;
+} fs_pack_field;
+
+/* a format parsed once by fs_pack_compile(), into fields the caller provides */
+typedef struct fs_pack_format
+{
+    const fs_pack_field *fields;
+    int field_count;
+    int size;
+} fs_pack_format;
+
+
+/* 
+ * parses fmt into at most max_fields fields, 
+ * returns the number of fields, or -1 if fmt is invalid or has more fields 
+ */
+int fs_pack_compile(fs_pack_format *format, fs_pack_field *fields, int max_fields, const char *fmt);
+
+/* fs_pack() and fs_unpack() with a compiled format */
+int fs_pack_compiled(void *buf, fs_size bufsz, const fs_pack_format *format, ...);
+int fs_unpack_compiled(const void *buf, fs_size bufsz, const fs_pack_format *format, ...);
+
+
+#endif /* FREESTANDING_PACK_H */
@@ -5,9 +5,477 @@
 #include <stdarg.h>
 #include "fs_int.h"
 
+
+/* a string that is not null terminated, see %v */
+typedef struct fs_slice
+{
+    const char *ptr;
+    fs_size len;
+} fs_slice;
+
+
+/* a parsed conversion specification, for internal use */
+typedef struct fs_internal_conv_spec
+{
+    unsigned int flags;
+    int minw;
+    int precision;
+    int l_count;
+    int conv;
+} fs_internal_conv_spec;
+
+#ifdef FS_64BIT_DEFINED
+typedef long long fs_internal_sec;
+#else
+typedef long fs_internal_sec;
+#endif /* FS_64BIT_DEFINED */
+
+/* the argument of a conversion, for internal use */
+typedef union fs_internal_conv_arg
+{
+    long ld;
+    unsigned long lu;
+#ifdef FS_64BIT_DEFINED
+    long long lld;
+    unsigned long long llu;
+#endif /* FS_64BIT_DEFINED */
+    double f;
+    long double lf;
+    const void *ptr;
+    int *n;
+    int chr;
+    struct {
+        const char *s;
+        long len; /* -1 until measured */
+    } str;
+    struct {
+        fs_internal_sec sec;
+        long usec;
+    } time;
+    struct {
+        fs_internal_sec value;
+        int scale;
+    } fixed;
+} fs_internal_conv_arg;
+
+typedef struct fs_internal_conv
+{
+    fs_internal_conv_spec spec;
+    fs_internal_conv_arg arg;
+} fs_internal_conv;
+
+
+/* state of a format that is written out in pieces,
+ * see fs_format_begin() */
+typedef struct fs_format_state
+{
+    const char *fmtptr;
+    va_list *ap;
+    fs_internal_conv conv;  /* the conversion that did not fit, if pending */
+    fs_size conv_done;      /* how much of it has been written */
+    fs_size resume_ret;     /* the output offset it can pick up again from, */
+    fs_size resume_src;     /* and how much of its source that is past */
+    int pending;
+    int done;
+    fs_size ret;            /* total bytes written so far */
+} fs_format_state;
+
+
+
+/*
+ * conversions besides the standard ones:
+ *   %k    ISO 8601 UTC timestamp, YYYY-MM-DDTHH:MM:SS.ffffff, from an int 
+ *         (long for %lk, long long for %llk) of seconds since the epoch
+ *         followed by a long of microseconds, precision is the number 
+ *         of fraction digits (6 by default, 0 drops the '.')
+ *   %j    fixed point decimal of a scaled integer, from an int (long for %lj, 
+ *         long long for %llj) followed by an int scale, the value is 
+ *         integer / 10^scale: 12345 with a scale of 2 is 123.45.
+ *         precision is the number of fraction digits, the scale by default, 
+ *         fewer are rounded half away from zero. flags and width are like %d.
+ *         a scale past +-40 prints nothing, a precision past 40 is cut to 40.
+ *         note that C99 has j as the intmax_t length modifier: here %jd is
+ *         %j followed by a literal 'd', and reads an int and a scale
+ *   %I4   IPv4 address, a.b.c.d, from a pointer to its 4 bytes in network order
+ *   %I6   IPv6 address in RFC 5952 form like inet_ntop, 
+ *         from a pointer to its 16 bytes in network order
+ *   %v    string slice, from an fs_size length followed by a pointer, 
+ *         %#v from a const fs_slice *. exactly that many bytes are copied,
+ *         null characters included, precision can only shorten it
+ *   %q    string escaped for the inside of a JSON string: \" \\ \b \f \n \r \t 
+ *         and \u00XX for the other control characters (%Q for uppercase XX),
+ *         %#q escapes for a C string literal instead, with \a \v and 
+ *         3 digit octal. precision limits the bytes read, width pads the result
+ *   %r    base64 with '=' padding, from an fs_size length followed by a pointer 
+ *         to the bytes, %#r uses the URL and filename safe alphabet (- and _).
+ *         precision limits the bytes read
+ *   %y    lazy string, from a const fs_lazy *, see below
+ *
+ * conversions that are never used can be compiled out of fs_vsnprintf,
+ * their arguments are still read so that the ones after them line up:
+ *   FS_NO_FLOAT     %f and %g print nothing
+ *   FS_NO_LONGLONG  %lld, %llu and %llx go through the long paths, cut to long
+ *   FS_NO_PTR       %p prints nothing
+ * and the same for the extensions, which FS_NO_EXTENSIONS drops all at once:
+ *   FS_NO_TIMESTAMP %k prints nothing
+ *   FS_NO_FIXED     %j prints nothing
+ *   FS_NO_IPADDR    %I4 and %I6 print nothing
+ *   FS_NO_SLICE     %v prints nothing
+ *   FS_NO_ESCAPE    %q prints nothing, and its kernels are dropped
+ *   FS_NO_BASE64    %r prints nothing, and its kernels are dropped
+ *   FS_NO_LAZY      %y prints nothing
+ *   FS_NO_CUSTOM    there is no fs_register_conversion, 
+ *                   unknown letters read no argument as in C
+ *   FS_NO_IOV       there is no fs_snprintf_iov or fs_vsnprintf_iov
+ *
+ * building with FS_FORMAT_CACHE (needs the __atomic builtins) makes 
+ * fs_vsnprintf keep the parsed specs of recent formats, keyed by the 
+ * address of the format. a hit only checks the length of the format, 
+ * and that every spec still starts with '%' and ends with the same letter 
+ * at the same place, so a format rewritten in place that keeps these 
+ * (like "%5d" to "%6d") is formatted with the old specs. with the cache 
+ * every format passed to fs_vsnprintf should keep its address and text, 
+ * like a string literal
+ */
+#ifdef FS_NO_EXTENSIONS
+#  ifndef FS_NO_TIMESTAMP
+#    define FS_NO_TIMESTAMP
+#  endif
+#  ifndef FS_NO_FIXED
+#    define FS_NO_FIXED
+#  endif
+#  ifndef FS_NO_IPADDR
+#    define FS_NO_IPADDR
+#  endif
+#  ifndef FS_NO_SLICE
+#    define FS_NO_SLICE
+#  endif
+#  ifndef FS_NO_ESCAPE
+#    define FS_NO_ESCAPE
+#  endif
+#  ifndef FS_NO_BASE64
+#    define FS_NO_BASE64
+#  endif
+#  ifndef FS_NO_LAZY
+#    define FS_NO_LAZY
+#  endif
+#  ifndef FS_NO_CUSTOM
+#    define FS_NO_CUSTOM
+#  endif
+#  ifndef FS_NO_IOV
+#    define FS_NO_IOV
+#  endif
+#endif /* FS_NO_EXTENSIONS */
+
 int fs_snprintf(char *buf, fs_size bufsz, const char *fmt, ...);
 int fs_vsnprintf(char *buf, fs_size bufsz, const char *fmt, va_list ap);
+/* same as fs_snprintf, but the length is not limited to INT_MAX */
+fs_size fs_snprintf_sz(char *buf, fs_size bufsz, const char *fmt, ...);
+fs_size fs_vsnprintf_sz(char *buf, fs_size bufsz, const char *fmt, va_list ap);
 
+/* 
+ * single value conversions in the spirit of std::to_chars,
+ * using the same digit generation as fs_snprintf. 
+ * they write to [first, last) without a null terminator 
+ * and return the end of what was written, or NULL if it does not fit.
+ * fs_to_chars_hex is lowercase without a prefix, 
+ * fs_to_chars_f64 is like %.*f, a negative precision is the default 6.
+ * it writes inf, nan, -inf and -nan as such and keeps the sign of -0.0.
+ * it returns NULL for what it cannot convert exactly: a precision past 19 
+ * (9 without 64 bit integers), or a magnitude of 2^64 or more (2^32)
+ */
+char *fs_to_chars_u32(char *first, char *last, fs_u32 value);
+char *fs_to_chars_i32(char *first, char *last, fs_i32 value);
+#ifdef FS_64BIT_DEFINED
+char *fs_to_chars_u64(char *first, char *last, fs_u64 value);
+char *fs_to_chars_i64(char *first, char *last, fs_i64 value);
+char *fs_to_chars_hex(char *first, char *last, fs_u64 value);
+#else
+char *fs_to_chars_hex(char *first, char *last, fs_u32 value);
+#endif /* FS_64BIT_DEFINED */
+char *fs_to_chars_f64(char *first, char *last, double value, int precision);
+
+/* like fs_snprintf, but stops at the first literal or conversion 
+ * that does not fit instead of computing the full length,
+ * returns the number of bytes written (without the null terminator) 
+ * and sets *truncated if the output was cut off, truncated may be NULL */
+int fs_snprintf_trunc(char *buf, fs_size bufsz, int *truncated, const char *fmt, ...);
+int fs_vsnprintf_trunc(char *buf, fs_size bufsz, int *truncated, const char *fmt, va_list ap);
+
+
+/*
+ * formats fmt in pieces through buffers of any size,
+ * ap must stay valid until the format is done:
+ *
+ *     va_start(ap, fmt);
+ *     fs_format_begin(&state, fmt, &ap);
+ *     while (!fs_format_done(&state))
+ *         uart_send(txbuf, fs_format_resume(&state, txbuf, sizeof txbuf));
+ *     va_end(ap);
+ *
+ * fs_format_resume() fills buf completely unless the format ends,
+ * and does not null terminate it.
+ * a conversion cut off by the end of buf continues in the next call.
+ * %q and %r continue from where they were cut off, the other conversions
+ * are generated again from their start, with the part already written dropped.
+ * that is cheap for numbers, padding and %s, but a long %y or custom conversion
+ * cut into n pieces is produced n times, O(n^2) in total */
+void fs_format_begin(fs_format_state *state, const char *fmt, va_list *ap);
+fs_size fs_format_resume(fs_format_state *state, char *buf, fs_size bufsz);
+int fs_format_done(const fs_format_state *state);
+
+
+
+/* 
+ * custom conversions, bound to a free lowercase letter 
+ * (the uppercase letter is the same conversion with FS_CONV_UPPER).
+ * the argument is a pointer to whatever the conversion formats,
+ * the callback writes through w straight into the output.
+ * width is applied around what it writes, 
+ * when right aligned the callback is first run on a writer that only counts.
+ * precision is up to the callback, as is the meaning of the flags
+ */
+typedef struct fs_writer fs_writer;
+
+#define FS_CONV_SPACE   ((unsigned)1 << 0)  /* ' ' */
+#define FS_CONV_LEFT    ((unsigned)1 << 1)  /* '-' */
+#define FS_CONV_PLUS    ((unsigned)1 << 2)  /* '+' */
+#define FS_CONV_ZERO    ((unsigned)1 << 3)  /* '0' */
+#define FS_CONV_ALT     ((unsigned)1 << 4)  /* '#' */
+#define FS_CONV_UPPER   ((unsigned)1 << 6)  /* uppercase letter */
+
+typedef struct fs_conv_spec
+{
+    int conv;           /* the lowercase letter */
+    unsigned int flags; /* FS_CONV_* */
+    int width;
+    int precision;      /* -1 if not given */
+    int length;         /* 1 for 'l', 2 for 'll' */
+} fs_conv_spec;
+
+typedef void (*fs_conversion)(fs_writer *w, 
+    const fs_conv_spec *spec, const void *arg, void *ctx);
+
+#ifndef FS_NO_CUSTOM
+/* binds letter to fn, a NULL fn unbinds it. not thread safe, register at init.
+ * returns -1 if the letter is not lowercase or is already used by fs_snprintf */
+int fs_register_conversion(int letter, fs_conversion fn, void *ctx);
+#endif /* FS_NO_CUSTOM */
+/* bounded writes, for use inside a conversion */
+void fs_writer_write(fs_writer *w, const char *s, fs_size len);
+void fs_writer_pad(fs_writer *w, char ch, fs_size count);
+/* nonzero once nothing more can be written and the full length is not needed,
+ * which is only in fs_snprintf_trunc and fs_format_resume. 
+ * ask only when there is more to write, a nonzero answer marks
+ * the conversion as cut off */
+int fs_writer_full(fs_writer *w);
+
+
+/* 
+ * a string for %y that is costly to produce, such as a stack trace,
+ * produce() writes it through w, and can stop once fs_writer_full(w).
+ * in fs_snprintf_trunc and fs_format_resume, the string counts as cut off
+ * if a write did not fit or produce() stopped on fs_writer_full(w),
+ * so a string that fills the buffer exactly is not. asking before 
+ * the costly part keeps a full buffer cheap. the other functions 
+ * need the full length. right aligned width calls it twice
+ */
+typedef struct fs_lazy
+{
+    void (*produce)(fs_writer *w, void *ctx);
+    void *ctx;
+} fs_lazy;
+
+
+
+/* 
+ * the code paths for literal scanning, string lengths, copying, 
+ * padding and digit generation, from slowest to fastest.
+ * the first fs_snprintf call picks the best one the CPU supports,
+ * call fs_snprintf_dispatch() at init to do it up front, which is required
+ * with threads on compilers without the __atomic builtins.
+ * beyond x86-64 with GCC or clang, FS_KERNELS_SWAR is the lookup table kernels.
+ * FS_PROFILE_SIZE (see fs_standard.h) builds FS_KERNELS_SCALAR alone 
+ * and drops the digit tables, the output is the same
+ */
+#define FS_KERNELS_SCALAR   0
+#define FS_KERNELS_SWAR     1
+#define FS_KERNELS_SSE2     2
+#define FS_KERNELS_AVX2     3
+#define FS_KERNELS_AVX512   4
+
+/* picks the kernels with cpuid, returns their level */
+int fs_snprintf_dispatch(void);
+/* picks level, or the best supported one below it, returns the level picked */
+int fs_snprintf_set_kernels(int level);
 
-#endif /* FREESTANDING_SNPRINTF_H */
 
+
+/* an output that can grow, 
+ * grow() makes room for at least need bytes after buf + used, 
+ * moving buf if it has to, and returns 0 if it cannot */
+typedef struct fs_sink
+{
+    char *buf;
+    fs_size size;
+    fs_size used;
+    int (*grow)(struct fs_sink *sink, fs_size need);
+    void *ctx;
+} fs_sink;
+
+/* appends to the sink, nothing is null terminated, 
+ * returns the length of the full output like fs_snprintf_sz. 
+ * if grow() failed less than that was appended, which sink->used shows */
+fs_size fs_sink_printf(fs_sink *sink, const char *fmt, ...);
+fs_size fs_sink_vprintf(fs_sink *sink, const char *fmt, va_list ap);
+
+
+#ifndef FS_IOV_MIN_REF
+#  define FS_IOV_MIN_REF 256
+#endif
+
+/* laid out like struct iovec, so an array of them can go to writev */
+typedef struct fs_iovec
+{
+    void *iov_base;
+    fs_size iov_len;
+} fs_iovec;
+
+/* 
+ * formats into iov for writev or sendmsg, without a null terminator.
+ * literals and conversions are written to scratch, 
+ * but %s and %v arguments of at least FS_IOV_MIN_REF bytes are put in iov 
+ * as they are, so they must outlive iov.
+ * returns the number of iov entries used, 
+ * or -1 if the output did not fit in scratch 
+ */
+#ifndef FS_NO_IOV
+int fs_snprintf_iov(fs_iovec *iov, int iovcnt, 
+    char *scratch, fs_size scratchsz, const char *fmt, ...);
+int fs_vsnprintf_iov(fs_iovec *iov, int iovcnt, 
+    char *scratch, fs_size scratchsz, const char *fmt, va_list ap);
+#endif /* FS_NO_IOV */
+
+
+
+#if !defined(FREESTANDING_TRULY) && (defined(__unix__) || defined(__APPLE__))
+#  define FS_MMAP_SINK
+#endif
+
+#ifdef FS_MMAP_SINK
+#  ifndef FS_MMAP_SINK_STRIDE
+#    define FS_MMAP_SINK_STRIDE ((fs_size)64 << 20)
+#  endif
+
+/* 
+ * a sink that writes straight into a file through a window of mmap, 
+ * the window is moved forward by stride bytes whenever it fills up.
+ * 32 bit targets need a 64 bit off_t (_FILE_OFFSET_BITS=64) for files over 2 GiB 
+ */
+typedef struct fs_mmap_sink
+{
+    fs_sink sink;
+    int fd;
+    fs_size base; /* file offset of sink.buf */
+    fs_size stride;
+} fs_mmap_sink;
+
+/* creates or truncates the file at path, stride of 0 is FS_MMAP_SINK_STRIDE,
+ * returns 0 on success, -1 on failure */
+int fs_mmap_sink_open(fs_mmap_sink *m, const char *path, fs_size stride);
+/* unmaps and trims the file to the bytes written */
+int fs_mmap_sink_close(fs_mmap_sink *m);
+#endif /* FS_MMAP_SINK */
+
+
+
+#ifndef FS_PARALLEL_MAX_WORKERS
+#  define FS_PARALLEL_MAX_WORKERS 64
+#endif
+#define FS_PARALLEL_BAD_FORMAT ((fs_size)-1)
+
+/* runs job(ctx, i) for every i in [0, count), in any order and on any thread,
+ * and returns once all of them are finished */
+typedef void (*fs_parallel_for)(void *sched, fs_size count, 
+    void (*job)(void *ctx, fs_size i), void *ctx);
+
+/*
+ * formats every element of array with fmt into one contiguous buffer, 
+ * the output is the same as formatting the elements one after another.
+ * fmt must have exactly one conversion, which reads its argument from array:
+ * int/long/long long for %d %u %x, double or long double for %f %g, 
+ * const char * for %s and %q, fs_slice for %v and %r, 
+ * const void * for %p, const fs_lazy * for %y and char for %c.
+ * the elements are split between workers, which measure their slice,
+ * then write it at its offset, both rounds are run through run(sched, ...), 
+ * or serially if run is NULL.
+ * returns the full length like fs_vsnprintf, 
+ * or FS_PARALLEL_BAD_FORMAT if fmt is not usable 
+ */
+fs_size fs_format_parallel(char *buf, fs_size bufsz, const char *fmt,
+    const void *array, fs_size count, unsigned int workers,
+    fs_parallel_for run, void *sched);
+
+
+
+#ifdef FS_STATS
+/*
+ * counters of where formatting time goes, opt-in with -DFS_STATS.
+ * every conversion is counted by its letter, and every format
+ * by its address in fs_vsnprintf, fs_vsnprintf_trunc, fs_sink_vprintf
+ * and fs_vsnprintf_iov (conversions in fs_format_resume count once per piece).
+ * bytes are the full output, truncations are calls whose output did not
+ * all fit, length queries with a buffer of 0 included.
+ * cycles come from FS_STATS_CLOCK(), rdtsc on x86,
+ * define it to a clock of your own elsewhere, or cycles stay 0.
+ * histogram splits the calls by their cycles in powers of 2, 
+ * so a rare slow call is not lost in the total: histogram[0] counts 
+ * the calls under 32 cycles, histogram[i] those of 2^(i+4) to 2^(i+5) - 1,
+ * and the last one all from 2^19 on
+ */
+#ifndef FS_STATS_FORMATS
+#  define FS_STATS_FORMATS 64 /* must be a power of 2 */
+#endif
+
+/* the conv array is indexed by the lowercase letter - 'a', then these */
+#define FS_STATS_PERCENT    26
+#define FS_STATS_IP4        27
+#define FS_STATS_IP6        28
+#define FS_STATS_CONVS      29
+
+#define FS_STATS_BUCKETS    16
+
+#ifdef FS_64BIT_DEFINED
+typedef fs_u64 fs_stats_count;
+#else
+typedef unsigned long fs_stats_count;
+#endif /* FS_64BIT_DEFINED */
+
+typedef struct fs_stats_entry
+{
+    fs_stats_count calls;
+    fs_stats_count bytes;
+    fs_stats_count truncations;
+    fs_stats_count cycles;
+    fs_stats_count histogram[FS_STATS_BUCKETS];
+} fs_stats_entry;
+
+typedef struct fs_stats
+{
+    fs_stats_entry conv[FS_STATS_CONVS];
+    /* a NULL fmt is an unused slot,
+     * formats that find no free slot are added to other_formats */
+    struct {
+        const char *fmt;
+        fs_stats_entry stats;
+    } formats[FS_STATS_FORMATS];
+    fs_stats_entry other_formats;
+} fs_stats;
+
+/* copies the counters, each is read on its own while others may be counting */
+void fs_stats_snapshot(fs_stats *out);
+void fs_stats_reset(void);
+#endif /* FS_STATS */
+
+
+#endif /* FREESTANDING_SNPRINTF_H */
@@ -0,0 +1,28 @@
+#ifndef FREESTANDING_SSCANF_H
+#define FREESTANDING_SSCANF_H
+
+
+#include <stdarg.h>
+#include "fs_int.h"
+
+
+/*
+ * reads formatted input from str like sscanf, with the conversions of fs_vsnprintf() 
+ * that have a standard scanf meaning: 
+ *  %d, %i (any base like fs_strtoul() with base 0), %u, %x, %X: int *, unsigned *, 
+ *      long * with l, long long * with ll
+ *  %f, %g and their capitals: float *, double * with l, long double * with ll
+ *  %s: char *, a run of non space characters, null terminated
+ *  %c: char *, width characters or 1, not null terminated
+ *  %p: void **, hexadecimal with an optional 0x prefix
+ *  %n: int *, the characters read so far, long * with l, long long * with ll
+ *  %%: a '%'
+ * '*' after the '%' reads without storing, a width limits the characters read. 
+ * whitespace in fmt matches any amount of whitespace, other characters match themselves. 
+ * returns the number of values stored, or -1 if the input ended before the first conversion
+ */
+int fs_sscanf(const char *str, const char *fmt, ...);
+int fs_vsscanf(const char *str, const char *fmt, va_list ap);
+
+
+#endif /* FREESTANDING_SSCANF_H */
@@ -36,6 +36,63 @@
 
 
 
+/* FS_PROFILE_SPEED, the default, spends code and lookup tables on speed,
+ * FS_PROFILE_SIZE keeps the compact loops and no SIMD for small targets */
+#if defined(FS_PROFILE_SPEED) && defined(FS_PROFILE_SIZE)
+#  error "define only one of FS_PROFILE_SPEED and FS_PROFILE_SIZE"
+#elif !defined(FS_PROFILE_SIZE) && !defined(FS_PROFILE_SPEED)
+#  define FS_PROFILE_SPEED
+#endif
+
+
+
+/* for static functions in headers that not every includer calls */
+#ifdef __GNUC__
+#  define FS_MAYBE_UNUSED __attribute__((unused))
+#else
+#  define FS_MAYBE_UNUSED
+#endif /* __GNUC__ */
+
+
+
+/* va_copy is C99, older compilers spell it __va_copy or not at all,
+ * then define FS_VA_LIST_ARRAY where va_list is an array type, 
+ * the plain assignment does not compile for those */
+#if defined(va_copy)
+#  define FS_VA_COPY(dst, src) va_copy(dst, src)
+#elif defined(__va_copy)
+#  define FS_VA_COPY(dst, src) __va_copy(dst, src)
+#elif defined(__GNUC__)
+#  define FS_VA_COPY(dst, src) __builtin_va_copy(dst, src)
+#elif defined(FS_VA_LIST_ARRAY)
+/* both decay to a pointer to the first element, even when src is a parameter */
+#  define FS_VA_COPY(dst, src) \
+    fs_va_copy_bytes((unsigned char*)(dst), (const unsigned char*)(src), sizeof(va_list))
+
+FS_MAYBE_UNUSED static void fs_va_copy_bytes(unsigned char *dst, const unsigned char *src, unsigned long n)
+{
+    for (; n; n -= 1)
+        *dst++ = *src++;
+}
+#else
+#  define FS_VA_COPY(dst, src) ((dst) = (src))
+#endif /* va_copy */
+
+
+
+/* the C locale isspace and isdigit, without needing <ctype.h> */
+FS_MAYBE_UNUSED static int fs_is_space(char ch)
+{
+    return ' ' == ch || ('\t' <= ch && ch <= '\r');
+}
+
+FS_MAYBE_UNUSED static int fs_is_digit(char ch)
+{
+    return '0' <= ch && ch <= '9';
+}
+
+
+
 #ifndef NULL
 #  define NULL ((void*)0)
 #endif /* NULL */
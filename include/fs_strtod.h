@@ -0,0 +1,21 @@
+#ifndef FREESTANDING_STRTOD_H
+#define FREESTANDING_STRTOD_H
+
+
+#include "fs_int.h"
+
+
+/*
+ * converts the decimal number at the start of str to the nearest double, 
+ * ties to even, like strtod: leading whitespace, an optional sign, 
+ * digits with an optional '.' and an optional exponent, or inf, infinity, nan 
+ * and nan(chars) in any case. hexadecimal floats are not parsed. 
+ * the result overflows to inf and underflows to 0 without setting errno. 
+ * if endptr is not NULL it is set past the number, or to str if there was none, 
+ * then 0 is returned. 
+ * double must be IEEE 754 binary64
+ */
+double fs_strtod(const char *str, char **endptr);
+
+
+#endif /* FREESTANDING_STRTOD_H */
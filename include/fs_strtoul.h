@@ -0,0 +1,24 @@
+#ifndef FREESTANDING_STRTOUL_H
+#define FREESTANDING_STRTOUL_H
+
+
+#include "fs_int.h"
+
+
+/*
+ * converts the number at the start of str like strtoul: leading whitespace, 
+ * an optional sign that negates the result, then digits of base 2 to 36, 
+ * or base 0 for a 0x prefix as hexadecimal, a leading 0 as octal and decimal otherwise. 
+ * returns ULONG_MAX on overflow without setting errno. 
+ * if endptr is not NULL it is set past the number, or to str if there was none, 
+ * then 0 is returned
+ */
+unsigned long fs_strtoul(const char *str, char **endptr, int base);
+
+#ifdef FS_64BIT_DEFINED
+/* fs_strtoul() for unsigned long long, ULLONG_MAX on overflow */
+unsigned long long fs_strtoull(const char *str, char **endptr, int base);
+#endif /* FS_64BIT_DEFINED */
+
+
+#endif /* FREESTANDING_STRTOUL_H */
@@ -0,0 +1,543 @@
+#include <stdarg.h>
+#include "../include/fs_int.h"
+#include "../include/fs_pack.h"
+#include "../include/fs_standard.h"
+#include "../include/fs_endian.h"
+#include "../include/fs_ieee754.h"
+#include "../include/fs_mem.h"
+
+
+
+#ifdef DEBUG_TEST
+#  define PACK_TEST
+#endif /* DEBUG_TEST */
+
+
+
+#define PACK_UINT       0
+#define PACK_INT        1
+#define PACK_FLOAT      2
+#define PACK_BYTES      3
+#define PACK_PAD        4
+
+#define ORDER_LITTLE    0
+#define ORDER_BIG       1
+#define ORDER_HOST      2
+
+
+
+/* 
+ * parses the next field of fmt, *order is the byte order so far, 
+ * returns the rest of fmt, or NULL at the end and on errors, which set *error 
+ */
+static const char *parse_field(const char *fmt, unsigned char *order, 
+    fs_pack_field *field, int *error)
+{
+    fs_size count = 0;
+    unsigned int bits = 0;
+    int type;
+
+    for (;; fmt += 1)
+    {
+        switch (*fmt)
+        {
+        case ' ': case '\t': case '\n': case '\r': continue;
+        case '<': *order = ORDER_LITTLE; continue;
+        case '>': 
+        case '!': *order = ORDER_BIG; continue;
+        case '=': *order = ORDER_HOST; continue;
+        case '\0': return NULL;
+        }
+        break;
+    }
+
+    field->is_array = fs_is_digit(*fmt);
+    for (; fs_is_digit(*fmt); fmt += 1)
+    {
+        count = count * 10 + (fs_size)(*fmt - '0');
+        if (count > INT_MAX)
+            goto invalid;
+    }
+    if (!field->is_array)
+        count = 1;
+
+    type = *fmt;
+    if (type)
+        fmt += 1;
+    for (; fs_is_digit(*fmt); fmt += 1)
+    {
+        bits = bits * 10 + (unsigned)(*fmt - '0');
+        if (bits > 64)
+            goto invalid;
+    }
+
+    switch (type)
+    {
+    case 'u': 
+    case 'i':
+        field->type = ('u' == type) ? PACK_UINT : PACK_INT;
+        if (8 != bits && 16 != bits && 32 != bits && 64 != bits)
+            goto invalid;
+#ifndef FS_64BIT_DEFINED
+        /* the single value could not be passed */
+        if (64 == bits && !field->is_array)
+            goto invalid;
+#endif /* FS_64BIT_DEFINED */
+        break;
+    case 'f':
+        field->type = PACK_FLOAT;
+        if (32 != bits && 64 != bits)
+            goto invalid;
+        break;
+    case 's':
+    case 'x':
+        field->type = ('s' == type) ? PACK_BYTES : PACK_PAD;
+        if (0 != bits)
+            goto invalid;
+        bits = 8;
+        break;
+    default: 
+        goto invalid;
+    }
+
+    field->order = *order;
+    field->elem_size = (unsigned char)(bits / 8);
+    field->count = count;
+    return fmt;
+
+invalid:
+    *error = 1;
+    return NULL;
+}
+
+
+/* adds the size of field to *size, returns 0 if the record gets larger than INT_MAX */
+static int add_field_size(int *size, const fs_pack_field *field)
+{
+    if (field->count > (fs_size)(INT_MAX - *size) / field->elem_size)
+        return 0;
+    *size += (int)(field->count * field->elem_size);
+    return 1;
+}
+
+
+/* the size of the record of fmt, or -1 if fmt is invalid */
+static int format_size(const char *fmt)
+{
+    fs_pack_field field;
+    unsigned char order = ORDER_LITTLE;
+    int error = 0;
+    int size = 0;
+
+    while (NULL != (fmt = parse_field(fmt, &order, &field, &error)))
+    {
+        if (!add_field_size(&size, &field))
+            return -1;
+    }
+    return error ? -1 : size;
+}
+
+
+
+
+/* 
+ * converts count elements of a field in buf between host and the field's byte order, 
+ * floats whose bytes are reversed from the integers are put in integer order first 
+ */
+static void convert_field(fs_u8 *buf, const fs_pack_field *field, int to_host)
+{
+    const int reverse_floats = PACK_FLOAT == field->type && FS_FLOAT_ENDIAN_DIFFER() 
+        && ORDER_HOST != field->order;
+    fs_size i;
+
+    if (reverse_floats && !to_host)
+    {
+        for (i = 0; i < field->count; i += 1)
+            fs_endian_bswap(buf + i * field->elem_size, field->elem_size);
+    }
+
+    switch (field->order)
+    {
+    case ORDER_LITTLE:
+        switch (field->elem_size)
+        {
+        case 2: fs_endian_host_to_little16(buf, field->count); break;
+        case 4: fs_endian_host_to_little32(buf, field->count); break;
+        case 8: fs_endian_host_to_little64(buf, field->count); break;
+        }
+        break;
+    case ORDER_BIG:
+        switch (field->elem_size)
+        {
+        case 2: fs_endian_host_to_big16(buf, field->count); break;
+        case 4: fs_endian_host_to_big32(buf, field->count); break;
+        case 8: fs_endian_host_to_big64(buf, field->count); break;
+        }
+        break;
+    }
+
+    if (reverse_floats && to_host)
+    {
+        for (i = 0; i < field->count; i += 1)
+            fs_endian_bswap(buf + i * field->elem_size, field->elem_size);
+    }
+}
+
+
+static void pack_field(fs_u8 *dst, const fs_pack_field *field, va_list *ap)
+{
+    if (PACK_PAD == field->type)
+    {
+        fs_memset(dst, 0, field->count);
+        return;
+    }
+    if (PACK_BYTES == field->type || field->is_array)
+    {
+        fs_memcpy(dst, va_arg(*ap, const void *), field->count * field->elem_size);
+        if (PACK_BYTES != field->type)
+            convert_field(dst, field, 0);
+        return;
+    }
+
+    switch (field->elem_size)
+    {
+    case 1: 
+        dst[0] = (fs_u8)va_arg(*ap, int); 
+        return;
+    case 2: 
+    {
+        fs_u16 u16 = (fs_u16)va_arg(*ap, int);
+        fs_memcpy(dst, &u16, sizeof u16);
+    } break;
+    case 4:
+        if (PACK_FLOAT == field->type)
+        {
+            float f = (float)va_arg(*ap, double);
+            fs_memcpy(dst, &f, sizeof f);
+        }
+        else
+        {
+            fs_u32 u32 = va_arg(*ap, fs_u32);
+            fs_memcpy(dst, &u32, sizeof u32);
+        }
+        break;
+    case 8:
+        if (PACK_FLOAT == field->type)
+        {
+            double d = va_arg(*ap, double);
+            fs_memcpy(dst, &d, sizeof d);
+        }
+#ifdef FS_64BIT_DEFINED
+        else
+        {
+            fs_u64 u64 = va_arg(*ap, fs_u64);
+            fs_memcpy(dst, &u64, sizeof u64);
+        }
+#endif /* FS_64BIT_DEFINED */
+        break;
+    }
+    convert_field(dst, field, 0);
+}
+
+
+static void unpack_field(const fs_u8 *src, const fs_pack_field *field, va_list *ap)
+{
+    fs_u8 *dst;
+
+    if (PACK_PAD == field->type)
+        return;
+
+    dst = va_arg(*ap, void *);
+    fs_memcpy(dst, src, field->count * field->elem_size);
+    if (PACK_BYTES != field->type)
+        convert_field(dst, field, 1);
+}
+
+
+
+
+int fs_vpack(void *buf, fs_size bufsz, const char *fmt, va_list ap)
+{
+    fs_u8 *dst = buf;
+    fs_pack_field field;
+    unsigned char order = ORDER_LITTLE;
+    int error = 0;
+    int size = format_size(fmt);
+    va_list args;
+
+    if (size < 0 || (fs_size)size > bufsz)
+        return size;
+
+    FS_VA_COPY(args, ap);
+    while (NULL != (fmt = parse_field(fmt, &order, &field, &error)))
+    {
+        pack_field(dst, &field, &args);
+        dst += field.count * field.elem_size;
+    }
+    va_end(args);
+    return size;
+}
+
+
+int fs_pack(void *buf, fs_size bufsz, const char *fmt, ...)
+{
+    va_list args;
+    int ret;
+
+    va_start(args, fmt);
+    ret = fs_vpack(buf, bufsz, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+
+int fs_vunpack(const void *buf, fs_size bufsz, const char *fmt, va_list ap)
+{
+    const fs_u8 *src = buf;
+    fs_pack_field field;
+    unsigned char order = ORDER_LITTLE;
+    int error = 0;
+    int size = format_size(fmt);
+    va_list args;
+
+    if (size < 0 || (fs_size)size > bufsz)
+        return size;
+
+    FS_VA_COPY(args, ap);
+    while (NULL != (fmt = parse_field(fmt, &order, &field, &error)))
+    {
+        unpack_field(src, &field, &args);
+        src += field.count * field.elem_size;
+    }
+    va_end(args);
+    return size;
+}
+
+
+int fs_unpack(const void *buf, fs_size bufsz, const char *fmt, ...)
+{
+    va_list args;
+    int ret;
+
+    va_start(args, fmt);
+    ret = fs_vunpack(buf, bufsz, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+
+
+
+int fs_pack_compile(fs_pack_format *format, fs_pack_field *fields, int max_fields, const char *fmt)
+{
+    unsigned char order = ORDER_LITTLE;
+    int error = 0;
+    int count = 0;
+    int size = 0;
+    fs_pack_field field;
+
+    while (NULL != (fmt = parse_field(fmt, &order, &field, &error)))
+    {
+        if (count >= max_fields || !add_field_size(&size, &field))
+            return -1;
+        fields[count] = field;
+        count += 1;
+    }
+    if (error)
+        return -1;
+
+    format->fields = fields;
+    format->field_count = count;
+    format->size = size;
+    return count;
+}
+
+
+int fs_pack_compiled(void *buf, fs_size bufsz, const fs_pack_format *format, ...)
+{
+    fs_u8 *dst = buf;
+    va_list args;
+    int i;
+
+    if ((fs_size)format->size > bufsz)
+        return format->size;
+
+    va_start(args, format);
+    for (i = 0; i < format->field_count; i += 1)
+    {
+        pack_field(dst, &format->fields[i], &args);
+        dst += format->fields[i].count * format->fields[i].elem_size;
+    }
+    va_end(args);
+    return format->size;
+}
+
+
+int fs_unpack_compiled(const void *buf, fs_size bufsz, const fs_pack_format *format, ...)
+{
+    const fs_u8 *src = buf;
+    va_list args;
+    int i;
+
+    if ((fs_size)format->size > bufsz)
+        return format->size;
+
+    va_start(args, format);
+    for (i = 0; i < format->field_count; i += 1)
+    {
+        unpack_field(src, &format->fields[i], &args);
+        src += format->fields[i].count * format->fields[i].elem_size;
+    }
+    va_end(args);
+    return format->size;
+}
+
+
+
+
+#ifdef PACK_TEST
+
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+
+
+#ifndef FS_C99
+#  error "at least C99 is required for testing code"
+#endif /* FS_C99 */
+
+
+
+static void check_bytes(const char *what, const fs_u8 *got, const fs_u8 *expected, int size)
+{
+    int i;
+
+    if (memcmp(got, expected, (size_t)size) != 0)
+    {
+        printf("  [ERROR]: %s was", what);
+        for (i = 0; i < size; i += 1)
+            printf(" %02x", got[i]);
+        printf("\n");
+        exit(1);
+    }
+    printf("  test %s passed\n", what);
+}
+
+
+int main(void)
+{
+    static const fs_u8 s_record[] = {
+        0x01,                                           /* u8 */
+        0x34, 0x12,                                     /* u16 */
+        0x12, 0x34, 0x56, 0x78,                         /* >u32 */
+        0xff, 0xfe,                                     /* >i16 -2 */
+        'a', 'b', 'c',                                  /* 3s */
+        0, 0,                                           /* 2x */
+        0x00, 0x00, 0xc0, 0x3f,                         /* <f32 1.5 */
+        0x40, 0x09, 0x21, 0xfb, 0x54, 0x44, 0x2d, 0x18, /* !f64 pi */
+        0x01, 0x00, 0x02, 0x00, 0x03, 0x00,             /* <3u16 */
+        0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02, /* >2u32 */
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, /* >u64 */
+    };
+    const char *fmt = "u8 u16 >u32 i16 3s 2x <f32 !f64 <3u16 >2u32 >u64";
+    const fs_u16 u16s[3] = { 1, 2, 3 };
+    const fs_u32 u32s[2] = { 1, 2 };
+    fs_u8 buf[64];
+    fs_pack_field fields[16];
+    fs_pack_format format;
+    int size = (int)sizeof s_record;
+
+    struct {
+        fs_u8 u8;
+        fs_u16 u16;
+        fs_u32 u32;
+        fs_i16 i16;
+        char s[3];
+        float f32;
+        double f64;
+        fs_u16 u16s[3];
+        fs_u32 u32s[2];
+        fs_u64 u64;
+    } out;
+
+    printf("[INFO]: Now test fs_pack\n");
+    memset(buf, 0xAA, sizeof buf);
+    if (size != fs_pack(buf, sizeof buf, fmt, 1, 0x1234, (fs_u32)0x12345678, -2, "abc", 
+        1.5, 3.14159265358979311600, u16s, u32s, (fs_u64)0x0123456789abcdefllu)
+    || 0xAA != buf[size])
+    {
+        printf("  [ERROR]: fs_pack size\n");
+        exit(1);
+    }
+    check_bytes("fs_pack", buf, s_record, size);
+
+    printf("[INFO]: Now test fs_unpack\n");
+    memset(&out, 0, sizeof out);
+    if (size != fs_unpack(s_record, sizeof s_record, fmt, &out.u8, &out.u16, &out.u32, &out.i16, 
+        out.s, &out.f32, &out.f64, out.u16s, out.u32s, &out.u64)
+    || 1 != out.u8 || 0x1234 != out.u16 || 0x12345678 != out.u32 || -2 != out.i16
+    || memcmp(out.s, "abc", 3) != 0 || 1.5f != out.f32 || 3.14159265358979311600 != out.f64
+    || memcmp(out.u16s, u16s, sizeof u16s) != 0 || memcmp(out.u32s, u32s, sizeof u32s) != 0
+    || 0x0123456789abcdefllu != out.u64)
+    {
+        printf("  [ERROR]: fs_unpack\n");
+        exit(1);
+    }
+    printf("  test fs_unpack passed\n");
+
+    printf("[INFO]: Now test compiled formats\n");
+    memset(buf, 0xAA, sizeof buf);
+    memset(&out, 0, sizeof out);
+    if (11 != fs_pack_compile(&format, fields, 16, fmt) || size != format.size
+    || size != fs_pack_compiled(buf, sizeof buf, &format, 1, 0x1234, (fs_u32)0x12345678, -2, 
+        "abc", 1.5, 3.14159265358979311600, u16s, u32s, (fs_u64)0x0123456789abcdefllu)
+    || size != fs_unpack_compiled(s_record, sizeof s_record, &format, &out.u8, &out.u16, 
+        &out.u32, &out.i16, out.s, &out.f32, &out.f64, out.u16s, out.u32s, &out.u64)
+    || 0x12345678 != out.u32 || 0x0123456789abcdefllu != out.u64 || 3 != out.u16s[2])
+    {
+        printf("  [ERROR]: compiled format\n");
+        exit(1);
+    }
+    check_bytes("fs_pack_compiled", buf, s_record, size);
+
+    printf("[INFO]: Now test errors and sizes\n");
+    if (-1 != fs_pack(buf, sizeof buf, "u12") || -1 != fs_pack(buf, sizeof buf, "f16")
+    || -1 != fs_pack(buf, sizeof buf, "u") || -1 != fs_pack(buf, sizeof buf, "q")
+    || -1 != fs_pack(buf, sizeof buf, "4s8") || -1 != fs_pack(buf, sizeof buf, "99999999999x")
+    || -1 != fs_pack_compile(&format, fields, 2, "u8 u8 u8")
+    || 0 != fs_pack(NULL, 0, "  ") || 22 != fs_pack(NULL, 0, "= 2f64 u16 4x")
+    || 4 != fs_pack(buf, 3, "u32", (fs_u32)1) || 0xAA != buf[size]
+    || 8 != fs_unpack(buf, 7, "f64", &out.f64) || 1.5f != out.f32)
+    {
+        printf("  [ERROR]: errors and sizes\n");
+        exit(1);
+    }
+    printf("  test errors and sizes passed\n");
+
+    {
+        /* arrays long enough for the vector kernels */
+        fs_u32 values[100], back[100];
+        fs_u8 wire[400];
+        int i;
+
+        printf("[INFO]: Now test long arrays\n");
+        for (i = 0; i < 100; i += 1)
+            values[i] = (fs_u32)i * 0x01020304u;
+        if (400 != fs_pack(wire, sizeof wire, ">100u32", values)
+        || 400 != fs_unpack(wire, sizeof wire, ">100u32", back)
+        || memcmp(values, back, sizeof values) != 0
+        || wire[4 * 99] != (fs_u8)(values[99] >> 24) || wire[4 * 99 + 3] != (fs_u8)values[99])
+        {
+            printf("  [ERROR]: long arrays\n");
+            exit(1);
+        }
+        printf("  test long arrays passed\n");
+    }
+
+    printf("All pack tests passed!\n");
+    return 0;
+}
+#endif /* PACK_TEST */
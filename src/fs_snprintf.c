@@ -1,5 +1,12 @@
 
 
+/* the mmap sink needs ftruncate and sysconf, it is on by default 
+ * without FREESTANDING_TRULY and can be asked for with FS_MMAP_SINK */
+#if (defined(FS_MMAP_SINK) || !defined(FREESTANDING_TRULY)) \
+    && (defined(__unix__) || defined(__APPLE__)) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200112L
+#endif
+
 #ifndef FREESTANDING_TRULY
 #  include <errno.h>
 #  include <string.h>
@@ -13,11 +20,21 @@
 #include "../include/fs_endian.h"
 #include "../include/fs_ieee754.h"
 #include "../include/fs_mem.h"
+#include "../include/fs_cpu.h"
+
+#ifdef FS_MMAP_SINK
+#  include <sys/types.h>
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif /* FS_MMAP_SINK */
 
 
 
 #ifdef DEBUG_TEST
 #  define SNPRINTF_TEST
+#elif defined(DEBUG_BENCH)
+#  define SNPRINTF_BENCH
 #endif /* DEBUG_TEST */
 
 
@@ -25,6 +42,12 @@
 #define HEX_BUFSIZE (sizeof(void*) * 2 + 2)
 #define FLT_BUFSIZE 64 /* 32 for decimal, 32 for remainder */
 #define FLT_DEFAULT_PRECISION 6
+#define DATETIME_BUFSIZE 40 /* YYYY-MM-DDTHH:MM:SS, or a longer year */
+#define TIMESTAMP_MAX_PRECISION 6 /* microseconds */
+#define IP4_BUFSIZE 16 /* 255.255.255.255 */
+#define IP6_BUFSIZE 46 /* ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255 */
+#define FIXED_MAX_SCALE 40 /* of %j, also its largest precision */
+#define FIXED_BUFSIZE (DEC_BUFSIZE + 2 * FIXED_MAX_SCALE + 1)
 
 #ifdef FS_64BIT_DEFINED
 #  define FLT_MAX_PRECISION 19 /* (int)log_10(2^64 - 1) */ 
@@ -42,6 +65,13 @@
 #define PRECISION_PROVIDED      ((unsigned)1 << 5)
 #define CAPITALIZED             ((unsigned)1 << 6)
 #define FLT_G_FORMAT            ((unsigned)1 << 7)
+#define WIDTH_FROM_ARG          ((unsigned)1 << 10)
+#define PRECISION_FROM_ARG      ((unsigned)1 << 11)
+
+/* fs_conv_spec.flags are the same bits */
+FS_STATIC_ASSERT(SPACE == FS_CONV_SPACE && PAD_RIGHT == FS_CONV_LEFT && PLUS == FS_CONV_PLUS
+    && ZEROPAD == FS_CONV_ZERO && ALTERNATE_FORM == FS_CONV_ALT && CAPITALIZED == FS_CONV_UPPER,
+    "custom conversion flags");
 
 
 #define VALUE_NEG_POS       8
@@ -50,14 +80,222 @@
 #define VALUE_ZERO          ((unsigned)1 << VALUE_ZERO_POS)
 
 
+/* conversions that are more than one letter */
+#define CONV_IP4                0x104 /* %I4 */
+#define CONV_IP6                0x106 /* %I6 */
+
+
 #define TO_UPPER_FROM_LOWER(ch) ((ch) - 32)
 #define TO_LOWER_FROM_UPPER(ch) ((ch) + 32)
 
 
+/* format_loop status */
+#define FORMAT_DONE             0
+#define FORMAT_STOP_LITERAL     1
+#define FORMAT_STOP_CONV        2
+
+
+
+/* the output of fs_vsnprintf_iov, 
+ * segment is the start of the scratch bytes that are not in iov yet */
+typedef struct fs_iov_state
+{
+    fs_iovec *iov;
+    int count;
+    int max;
+    char *segment;
+} fs_iov_state;
+
+/* where the print_* functions write to, 
+ * left is the space remaining in the buffer, including the null terminator, 
+ * ret is the length of the full output, even the parts that did not fit,
+ * skip is the number of leading bytes to drop, used to resume a conversion,
+ * sink, if not NULL, is asked for more space once the buffer is full,
+ * iov, if not NULL, gets long %s arguments by reference instead of copying them */
+struct fs_writer
+{
+    char *bufptr;
+    fs_size left;
+    fs_size ret;
+    fs_size skip;
+    int stop; /* stop formatting once the buffer is full */
+    int cut;  /* a conversion stopped early with output left, ret is short */
+    fs_size resume_ret; /* the output of the current conversion up to resume_ret */
+    fs_size resume_src; /* came from resume_src bytes of its source, see writer_mark() */
+    fs_sink *sink;
+    fs_iov_state *iov;
+};
+
+
+
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+#  define FS_ATOMICS
+#endif /* __ATOMIC_ACQUIRE */
+
+#if defined(FS_ATOMICS) && (!defined(FS_NO_TIMESTAMP) || defined(FS_FORMAT_CACHE))
+/* 
+ * sequence locks for the caches, the sequence number is odd while 
+ * the data is being written. readers copy the data out and check 
+ * that the number did not move, a writer that finds the lock taken
+ * skips its update instead of waiting
+ */
+static unsigned long seq_read_begin(unsigned long *seq)
+{
+    return __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+}
+
+/* returns nonzero if what was read since seq_read_begin is consistent */
+static int seq_read_end(unsigned long *seq, unsigned long start)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return !(start & 1) && __atomic_load_n(seq, __ATOMIC_RELAXED) == start;
+}
+
+static int seq_write_begin(unsigned long *seq, unsigned long *start)
+{
+    *start = __atomic_load_n(seq, __ATOMIC_RELAXED);
+    if ((*start & 1) || !__atomic_compare_exchange_n(seq, 
+        start, *start + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return 0;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return 1;
+}
+
+static void seq_write_end(unsigned long *seq, unsigned long start)
+{
+    __atomic_store_n(seq, start + 2, __ATOMIC_RELEASE);
+}
+#endif /* FS_ATOMICS */
+
+
 
 static const char s_hexchars[] = "0123456789abcdef";
 static const char s_HEXCHARS[] = "0123456789ABCDEF";
+#if !defined(FS_NO_PTR) || !defined(FS_NO_IPADDR)
 static const char s_nullptr_string[] = "(nil)";
+#endif
+#if defined(FS_PROFILE_SPEED) && !defined(FS_NO_IPADDR)
+/* decimal digits of every byte value, the last char is the length */
+static const char s_byte_dec[256][4] = {
+    {'0', 0, 0, 1}, {'1', 0, 0, 1}, {'2', 0, 0, 1}, {'3', 0, 0, 1},
+    {'4', 0, 0, 1}, {'5', 0, 0, 1}, {'6', 0, 0, 1}, {'7', 0, 0, 1},
+    {'8', 0, 0, 1}, {'9', 0, 0, 1}, {'1', '0', 0, 2}, {'1', '1', 0, 2},
+    {'1', '2', 0, 2}, {'1', '3', 0, 2}, {'1', '4', 0, 2}, {'1', '5', 0, 2},
+    {'1', '6', 0, 2}, {'1', '7', 0, 2}, {'1', '8', 0, 2}, {'1', '9', 0, 2},
+    {'2', '0', 0, 2}, {'2', '1', 0, 2}, {'2', '2', 0, 2}, {'2', '3', 0, 2},
+    {'2', '4', 0, 2}, {'2', '5', 0, 2}, {'2', '6', 0, 2}, {'2', '7', 0, 2},
+    {'2', '8', 0, 2}, {'2', '9', 0, 2}, {'3', '0', 0, 2}, {'3', '1', 0, 2},
+    {'3', '2', 0, 2}, {'3', '3', 0, 2}, {'3', '4', 0, 2}, {'3', '5', 0, 2},
+    {'3', '6', 0, 2}, {'3', '7', 0, 2}, {'3', '8', 0, 2}, {'3', '9', 0, 2},
+    {'4', '0', 0, 2}, {'4', '1', 0, 2}, {'4', '2', 0, 2}, {'4', '3', 0, 2},
+    {'4', '4', 0, 2}, {'4', '5', 0, 2}, {'4', '6', 0, 2}, {'4', '7', 0, 2},
+    {'4', '8', 0, 2}, {'4', '9', 0, 2}, {'5', '0', 0, 2}, {'5', '1', 0, 2},
+    {'5', '2', 0, 2}, {'5', '3', 0, 2}, {'5', '4', 0, 2}, {'5', '5', 0, 2},
+    {'5', '6', 0, 2}, {'5', '7', 0, 2}, {'5', '8', 0, 2}, {'5', '9', 0, 2},
+    {'6', '0', 0, 2}, {'6', '1', 0, 2}, {'6', '2', 0, 2}, {'6', '3', 0, 2},
+    {'6', '4', 0, 2}, {'6', '5', 0, 2}, {'6', '6', 0, 2}, {'6', '7', 0, 2},
+    {'6', '8', 0, 2}, {'6', '9', 0, 2}, {'7', '0', 0, 2}, {'7', '1', 0, 2},
+    {'7', '2', 0, 2}, {'7', '3', 0, 2}, {'7', '4', 0, 2}, {'7', '5', 0, 2},
+    {'7', '6', 0, 2}, {'7', '7', 0, 2}, {'7', '8', 0, 2}, {'7', '9', 0, 2},
+    {'8', '0', 0, 2}, {'8', '1', 0, 2}, {'8', '2', 0, 2}, {'8', '3', 0, 2},
+    {'8', '4', 0, 2}, {'8', '5', 0, 2}, {'8', '6', 0, 2}, {'8', '7', 0, 2},
+    {'8', '8', 0, 2}, {'8', '9', 0, 2}, {'9', '0', 0, 2}, {'9', '1', 0, 2},
+    {'9', '2', 0, 2}, {'9', '3', 0, 2}, {'9', '4', 0, 2}, {'9', '5', 0, 2},
+    {'9', '6', 0, 2}, {'9', '7', 0, 2}, {'9', '8', 0, 2}, {'9', '9', 0, 2},
+    {'1', '0', '0', 3}, {'1', '0', '1', 3}, {'1', '0', '2', 3}, {'1', '0', '3', 3},
+    {'1', '0', '4', 3}, {'1', '0', '5', 3}, {'1', '0', '6', 3}, {'1', '0', '7', 3},
+    {'1', '0', '8', 3}, {'1', '0', '9', 3}, {'1', '1', '0', 3}, {'1', '1', '1', 3},
+    {'1', '1', '2', 3}, {'1', '1', '3', 3}, {'1', '1', '4', 3}, {'1', '1', '5', 3},
+    {'1', '1', '6', 3}, {'1', '1', '7', 3}, {'1', '1', '8', 3}, {'1', '1', '9', 3},
+    {'1', '2', '0', 3}, {'1', '2', '1', 3}, {'1', '2', '2', 3}, {'1', '2', '3', 3},
+    {'1', '2', '4', 3}, {'1', '2', '5', 3}, {'1', '2', '6', 3}, {'1', '2', '7', 3},
+    {'1', '2', '8', 3}, {'1', '2', '9', 3}, {'1', '3', '0', 3}, {'1', '3', '1', 3},
+    {'1', '3', '2', 3}, {'1', '3', '3', 3}, {'1', '3', '4', 3}, {'1', '3', '5', 3},
+    {'1', '3', '6', 3}, {'1', '3', '7', 3}, {'1', '3', '8', 3}, {'1', '3', '9', 3},
+    {'1', '4', '0', 3}, {'1', '4', '1', 3}, {'1', '4', '2', 3}, {'1', '4', '3', 3},
+    {'1', '4', '4', 3}, {'1', '4', '5', 3}, {'1', '4', '6', 3}, {'1', '4', '7', 3},
+    {'1', '4', '8', 3}, {'1', '4', '9', 3}, {'1', '5', '0', 3}, {'1', '5', '1', 3},
+    {'1', '5', '2', 3}, {'1', '5', '3', 3}, {'1', '5', '4', 3}, {'1', '5', '5', 3},
+    {'1', '5', '6', 3}, {'1', '5', '7', 3}, {'1', '5', '8', 3}, {'1', '5', '9', 3},
+    {'1', '6', '0', 3}, {'1', '6', '1', 3}, {'1', '6', '2', 3}, {'1', '6', '3', 3},
+    {'1', '6', '4', 3}, {'1', '6', '5', 3}, {'1', '6', '6', 3}, {'1', '6', '7', 3},
+    {'1', '6', '8', 3}, {'1', '6', '9', 3}, {'1', '7', '0', 3}, {'1', '7', '1', 3},
+    {'1', '7', '2', 3}, {'1', '7', '3', 3}, {'1', '7', '4', 3}, {'1', '7', '5', 3},
+    {'1', '7', '6', 3}, {'1', '7', '7', 3}, {'1', '7', '8', 3}, {'1', '7', '9', 3},
+    {'1', '8', '0', 3}, {'1', '8', '1', 3}, {'1', '8', '2', 3}, {'1', '8', '3', 3},
+    {'1', '8', '4', 3}, {'1', '8', '5', 3}, {'1', '8', '6', 3}, {'1', '8', '7', 3},
+    {'1', '8', '8', 3}, {'1', '8', '9', 3}, {'1', '9', '0', 3}, {'1', '9', '1', 3},
+    {'1', '9', '2', 3}, {'1', '9', '3', 3}, {'1', '9', '4', 3}, {'1', '9', '5', 3},
+    {'1', '9', '6', 3}, {'1', '9', '7', 3}, {'1', '9', '8', 3}, {'1', '9', '9', 3},
+    {'2', '0', '0', 3}, {'2', '0', '1', 3}, {'2', '0', '2', 3}, {'2', '0', '3', 3},
+    {'2', '0', '4', 3}, {'2', '0', '5', 3}, {'2', '0', '6', 3}, {'2', '0', '7', 3},
+    {'2', '0', '8', 3}, {'2', '0', '9', 3}, {'2', '1', '0', 3}, {'2', '1', '1', 3},
+    {'2', '1', '2', 3}, {'2', '1', '3', 3}, {'2', '1', '4', 3}, {'2', '1', '5', 3},
+    {'2', '1', '6', 3}, {'2', '1', '7', 3}, {'2', '1', '8', 3}, {'2', '1', '9', 3},
+    {'2', '2', '0', 3}, {'2', '2', '1', 3}, {'2', '2', '2', 3}, {'2', '2', '3', 3},
+    {'2', '2', '4', 3}, {'2', '2', '5', 3}, {'2', '2', '6', 3}, {'2', '2', '7', 3},
+    {'2', '2', '8', 3}, {'2', '2', '9', 3}, {'2', '3', '0', 3}, {'2', '3', '1', 3},
+    {'2', '3', '2', 3}, {'2', '3', '3', 3}, {'2', '3', '4', 3}, {'2', '3', '5', 3},
+    {'2', '3', '6', 3}, {'2', '3', '7', 3}, {'2', '3', '8', 3}, {'2', '3', '9', 3},
+    {'2', '4', '0', 3}, {'2', '4', '1', 3}, {'2', '4', '2', 3}, {'2', '4', '3', 3},
+    {'2', '4', '4', 3}, {'2', '4', '5', 3}, {'2', '4', '6', 3}, {'2', '4', '7', 3},
+    {'2', '4', '8', 3}, {'2', '4', '9', 3}, {'2', '5', '0', 3}, {'2', '5', '1', 3},
+    {'2', '5', '2', 3}, {'2', '5', '3', 3}, {'2', '5', '4', 3}, {'2', '5', '5', 3},
+};
+#endif /* FS_PROFILE_SPEED && !FS_NO_IPADDR */
+#ifndef FS_NO_BASE64
+static const char s_base64[] = 
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char s_base64_url[] = 
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+#endif /* FS_NO_BASE64 */
+#ifdef FS_PROFILE_SPEED
+static const char s_digits2[] = 
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+#  if !defined(FS_CPU_X86_64) || !defined(FS_NO_PTR)
+/* two hex digits of every byte value, for %p and hex_lut() */
+static const char s_hex2[256][2] = {
+    "00", "01", "02", "03", "04", "05", "06", "07", "08", "09", "0a", "0b", "0c", "0d", "0e", "0f",
+    "10", "11", "12", "13", "14", "15", "16", "17", "18", "19", "1a", "1b", "1c", "1d", "1e", "1f",
+    "20", "21", "22", "23", "24", "25", "26", "27", "28", "29", "2a", "2b", "2c", "2d", "2e", "2f",
+    "30", "31", "32", "33", "34", "35", "36", "37", "38", "39", "3a", "3b", "3c", "3d", "3e", "3f",
+    "40", "41", "42", "43", "44", "45", "46", "47", "48", "49", "4a", "4b", "4c", "4d", "4e", "4f",
+    "50", "51", "52", "53", "54", "55", "56", "57", "58", "59", "5a", "5b", "5c", "5d", "5e", "5f",
+    "60", "61", "62", "63", "64", "65", "66", "67", "68", "69", "6a", "6b", "6c", "6d", "6e", "6f",
+    "70", "71", "72", "73", "74", "75", "76", "77", "78", "79", "7a", "7b", "7c", "7d", "7e", "7f",
+    "80", "81", "82", "83", "84", "85", "86", "87", "88", "89", "8a", "8b", "8c", "8d", "8e", "8f",
+    "90", "91", "92", "93", "94", "95", "96", "97", "98", "99", "9a", "9b", "9c", "9d", "9e", "9f",
+    "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7", "a8", "a9", "aa", "ab", "ac", "ad", "ae", "af",
+    "b0", "b1", "b2", "b3", "b4", "b5", "b6", "b7", "b8", "b9", "ba", "bb", "bc", "bd", "be", "bf",
+    "c0", "c1", "c2", "c3", "c4", "c5", "c6", "c7", "c8", "c9", "ca", "cb", "cc", "cd", "ce", "cf",
+    "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "d8", "d9", "da", "db", "dc", "dd", "de", "df",
+    "e0", "e1", "e2", "e3", "e4", "e5", "e6", "e7", "e8", "e9", "ea", "eb", "ec", "ed", "ee", "ef",
+    "f0", "f1", "f2", "f3", "f4", "f5", "f6", "f7", "f8", "f9", "fa", "fb", "fc", "fd", "fe", "ff",
+};
+static const char s_HEX2[256][2] = {
+    "00", "01", "02", "03", "04", "05", "06", "07", "08", "09", "0A", "0B", "0C", "0D", "0E", "0F",
+    "10", "11", "12", "13", "14", "15", "16", "17", "18", "19", "1A", "1B", "1C", "1D", "1E", "1F",
+    "20", "21", "22", "23", "24", "25", "26", "27", "28", "29", "2A", "2B", "2C", "2D", "2E", "2F",
+    "30", "31", "32", "33", "34", "35", "36", "37", "38", "39", "3A", "3B", "3C", "3D", "3E", "3F",
+    "40", "41", "42", "43", "44", "45", "46", "47", "48", "49", "4A", "4B", "4C", "4D", "4E", "4F",
+    "50", "51", "52", "53", "54", "55", "56", "57", "58", "59", "5A", "5B", "5C", "5D", "5E", "5F",
+    "60", "61", "62", "63", "64", "65", "66", "67", "68", "69", "6A", "6B", "6C", "6D", "6E", "6F",
+    "70", "71", "72", "73", "74", "75", "76", "77", "78", "79", "7A", "7B", "7C", "7D", "7E", "7F",
+    "80", "81", "82", "83", "84", "85", "86", "87", "88", "89", "8A", "8B", "8C", "8D", "8E", "8F",
+    "90", "91", "92", "93", "94", "95", "96", "97", "98", "99", "9A", "9B", "9C", "9D", "9E", "9F",
+    "A0", "A1", "A2", "A3", "A4", "A5", "A6", "A7", "A8", "A9", "AA", "AB", "AC", "AD", "AE", "AF",
+    "B0", "B1", "B2", "B3", "B4", "B5", "B6", "B7", "B8", "B9", "BA", "BB", "BC", "BD", "BE", "BF",
+    "C0", "C1", "C2", "C3", "C4", "C5", "C6", "C7", "C8", "C9", "CA", "CB", "CC", "CD", "CE", "CF",
+    "D0", "D1", "D2", "D3", "D4", "D5", "D6", "D7", "D8", "D9", "DA", "DB", "DC", "DD", "DE", "DF",
+    "E0", "E1", "E2", "E3", "E4", "E5", "E6", "E7", "E8", "E9", "EA", "EB", "EC", "ED", "EE", "EF",
+    "F0", "F1", "F2", "F3", "F4", "F5", "F6", "F7", "F8", "F9", "FA", "FB", "FC", "FD", "FE", "FF",
+};
+#  endif /* !FS_CPU_X86_64 || !FS_NO_PTR */
+#endif /* FS_PROFILE_SPEED */
 
 
 
@@ -66,6 +304,7 @@ static const char s_nullptr_string[] = "(nil)";
 
 static fs_u64 quick_pow10(fs_u64 n)
 {
+#ifdef FS_PROFILE_SPEED
     static fs_u64 lut[] = {
         1, 10, 100, 1000, 10000,
         100000, 
@@ -81,15 +320,23 @@ static fs_u64 quick_pow10(fs_u64 n)
         (fs_u64)1000000000000000,       /* 10^15 */
         (fs_u64)10000000000000000,      /* 10^16 */
         (fs_u64)100000000000000000,     /* 10^17 */
-        (fs_u64)1000000000000000000,    /* 10^19 */
+        (fs_u64)1000000000000000000,    /* 10^18 */
+        (fs_u64)10000000000000000000u,  /* 10^19 */
     };
     return lut[n % FS_STATIC_ARRAYSIZE(lut)];
+#else
+    fs_u64 pow = 1;
+    for (n %= 20; n; n -= 1)
+        pow *= 10;
+    return pow;
+#endif /* FS_PROFILE_SPEED */
 }
 
 #else
 
 static fs_u32 quick_pow10(fs_u32 n)
 {
+#ifdef FS_PROFILE_SPEED
     static fs_u32 lut[] = {
         1, 10, 100, 1000, 10000,
         100000, 
@@ -99,6 +346,12 @@ static fs_u32 quick_pow10(fs_u32 n)
         1000000000, /* 10^9 */
     };
     return lut[n % FS_STATIC_ARRAYSIZE(lut)];
+#else
+    fs_u32 pow = 1;
+    for (n %= 10; n; n -= 1)
+        pow *= 10;
+    return pow;
+#endif /* FS_PROFILE_SPEED */
 }
 
 #endif /* FS_64BIT_DEFINED */
@@ -121,6 +374,7 @@ static int is_upper(char ch)
 }
 
 
+#ifndef FS_NO_FLOAT
 static int g_format_should_use_e(int exponent, int precision, unsigned int flags)
 {
     int threshold = 4; /* default value by the C standard, 10^4 */
@@ -131,6 +385,7 @@ static int g_format_should_use_e(int exponent, int precision, unsigned int flags
     return exponent < -threshold
         || threshold < exponent;
 }
+#endif /* FS_NO_FLOAT */
 
 
 
@@ -149,364 +404,882 @@ static char get_signch(unsigned int flags)
 }
 
 
-/* if limit is 0, this function will act like strlen */
-static unsigned long strlen_up_to(const char *s, unsigned long limit)
-{
-    unsigned long i = 0;
-    if (0 == limit)
-    {
-        while (s[i] != 0) 
-            i += 1;
-        return i;
-    }
-    for (; i < limit; i += 1)
-    {
-        if (s[i] == 0)
-            return i;
-    }
-    return limit;
-}
-
 
+/* 
+ * the hot loops, as a table picked once for the running CPU,
+ * see fs_snprintf_dispatch(). 
+ * digits are written reversed, like print_decimal_l() 
+ */
+#ifdef FS_64BIT_DEFINED
+typedef unsigned long long fs_umax;
+#else
+typedef unsigned long fs_umax;
+#endif /* FS_64BIT_DEFINED */
 
-static void spool_str_rev(char **bufptr, fs_size *left, int *ret, const char *numstr, int len)
+typedef struct fs_kernels
 {
-    int i = len;
-    while (i)
-    {
-        if (*left > 1)
-        {
-            i -= 1;
-            (**bufptr) = numstr[i];
-            (*bufptr) += 1;
-            (*left) -= 1;
-        }
-        else i -= 1;
-        (*ret) += 1;
-    }
-}
+    /* the first '%' or null character in s */
+    const char *(*find_conv)(const char *s);
+    fs_size (*strnlen)(const char *s, fs_size limit);
+    void (*copy)(char *dst, const char *src, fs_size n);
+    void (*fill)(char *dst, char ch, fs_size n);
+    int (*decimal)(char *buf, int bufsz, fs_umax value);
+    int (*hex)(char *buf, int bufsz, fs_umax value, unsigned int capitalized);
+#ifndef FS_NO_ESCAPE
+    /* the first byte in s that escape_str() escapes, null included, or limit */
+    fs_size (*find_escape)(const char *s, fs_size limit, int c_mode);
+#endif /* FS_NO_ESCAPE */
+#ifndef FS_NO_BASE64
+    /* encodes the whole 3 byte groups of src, returns how many bytes it took */
+    fs_size (*base64)(char *dst, const unsigned char *src, fs_size n, int url);
+#endif /* FS_NO_BASE64 */
+} fs_kernels;
+
+/* the table entries of the kernels that can be compiled out */
+#ifdef FS_NO_ESCAPE
+#  define ESCAPE_KERNEL(fn)
+#else
+#  define ESCAPE_KERNEL(fn) fn,
+#endif /* FS_NO_ESCAPE */
+#ifdef FS_NO_BASE64
+#  define BASE64_KERNEL(fn)
+#else
+#  define BASE64_KERNEL(fn) fn,
+#endif /* FS_NO_BASE64 */
 
+/* worst case of the decimal and hex kernels, they fall back to the scalar ones below it */
+#define KERNEL_DIGITS_BUFSIZE ((int)sizeof(fs_umax) * 3)
 
 
-static void spool_str(char **bufptr, fs_size *left, int *ret, 
-    const char *str, int len, unsigned int capitalized)
+static const char *find_conv_scalar(const char *s)
 {
-    int i;
-    for (i = 0; i < len; i += 1, (*ret) += 1)
-    {
-        if (*left > 1)
-        {
-            if (capitalized && is_lower(str[i]))
-                (**bufptr) = TO_UPPER_FROM_LOWER(str[i]);
-            else
-                (**bufptr) = str[i];
-            (*bufptr) += 1;
-            (*left) -= 1;
-        }
-    }
+    while (*s && '%' != *s)
+        s += 1;
+    return s;
 }
 
+/* the length, copies and padding go through fs_mem.h, 
+ * a word at a time and with SSE2 where there is no libc either */
+static fs_size strnlen_scalar(const char *s, fs_size limit)
+{
+    return fs_strnlen(s, limit);
+}
 
+static void copy_scalar(char *dst, const char *src, fs_size n)
+{
+    fs_memcpy(dst, src, n);
+}
 
+static void fill_scalar(char *dst, char ch, fs_size n)
+{
+    fs_memset(dst, (unsigned char)ch, n);
+}
 
-static void print_pad(char **bufptr, fs_size *left, int *ret, char pad, int count)
+static int decimal_scalar(char *buf, int bufsz, fs_umax value)
 {
-    int n = count;
-    while (n--)
+    int len = 0;
+
+    if (value == 0 && bufsz > 0)
     {
-        if (*left > 1)
-        {
-            (**bufptr) = pad;
-            (*bufptr) += 1;
-            (*left) -= 1;
-        }
-        (*ret) += 1;
+        buf[0] = '0';
+        len = 1;
+    }
+    else while (len < bufsz && value)
+    {
+        buf[len] = '0' + (value % 10);
+        value /= 10;
+        len += 1;
     }
+    return len;
 }
 
-
-static void print_num_pad(
-    char **bufptr, fs_size *left, int *ret, 
-    int minw, int precision, unsigned int flags,
-    const char *numstr, int len)
+static int hex_scalar(char *buf, int bufsz, fs_umax value, unsigned int capitalized)
 {
-    int numw = len;
-    char signch = get_signch(flags);
-
-    if (0 == precision && (flags & VALUE_ZERO)) numw = 0;
-    if (numw < precision) numw = precision;
-
+    const char *lut = capitalized ? s_HEXCHARS : s_hexchars;
+    int len = 0;
 
-    if (flags & PAD_RIGHT)
+    if (0 == value && bufsz > 0)
     {
-        /* number left, padding right */
-        /* [sign][zeros][number][spaces] */
-
-        if (signch) /* print the sign ch */
-        {
-            numw += 1;
-            print_pad(bufptr, left, ret, signch, 1);
-        }
-
-
-        /* number */
-        if (precision || !(flags & VALUE_ZERO))
-        {
-            if (len < precision)
-                print_pad(bufptr, left, ret, '0', precision - len);
-            spool_str_rev(bufptr, left, ret, numstr, len);
-        }
-
-
-        /* spaces */
-        if (numw < minw)
-            print_pad(bufptr, left, ret, ' ', minw - numw);
+        buf[0] = '0';
+        len = 1;
     }
-    else
+    else while (value && len < bufsz)
     {
-        /* padding left, number right */
-        /* [spaces][sign][zeros][number] */
-
-        if ((flags & ZEROPAD) && !(flags & PRECISION_PROVIDED) && (numw < minw))
-            numw = minw;
-        else if (signch)
-            numw += 1;
+        buf[len] = lut[value & 0xF]; /* lookup each nibble of a byte */
+        value >>= 4;
+        len += 1;
+    }
+    return len;
+}
 
-        /* space pad */
-        if (numw < minw)
-            print_pad(bufptr, left, ret, ' ', minw - numw);
+#ifndef FS_NO_ESCAPE
+/* control characters, quotes and backslashes, and DEL in C */
+#define NEEDS_ESCAPE(ch, c_mode) ((unsigned char)(ch) < 0x20 \
+    || '"' == (ch) || '\\' == (ch) || ((c_mode) && 0x7F == (ch)))
 
-        /* sign */
-        if (signch)
-        {
-            print_pad(bufptr, left, ret, signch, 1);
-            numw -= 1;
-        }
+static fs_size find_escape_scalar(const char *s, fs_size limit, int c_mode)
+{
+    fs_size i = 0;
+    while (i < limit && !NEEDS_ESCAPE(s[i], c_mode))
+        i += 1;
+    return i;
+}
+#endif /* FS_NO_ESCAPE */
 
-        /* zeros */
-        if (len < numw)
-        {
-            print_pad(bufptr, left, ret, '0', numw - len);
-        }
+#ifndef FS_NO_BASE64
+/* a group of 3 bytes is 4 characters */
+static fs_size base64_scalar(char *dst, const unsigned char *src, fs_size n, int url)
+{
+    const char *lut = url ? s_base64_url : s_base64;
+    unsigned long group;
+    fs_size i;
 
-        if (precision || !(flags & VALUE_ZERO))
-            spool_str_rev(bufptr, left, ret, numstr, len);
+    for (i = 0; i + 3 <= n; i += 3)
+    {
+        group = (unsigned long)src[i] << 16 | (unsigned long)src[i + 1] << 8 | src[i + 2];
+        dst[0] = lut[group >> 18];
+        dst[1] = lut[(group >> 12) & 0x3F];
+        dst[2] = lut[(group >> 6) & 0x3F];
+        dst[3] = lut[group & 0x3F];
+        dst += 4;
     }
+    return i;
 }
+#endif /* FS_NO_BASE64 */
 
+static const fs_kernels s_kernels_scalar = {
+    find_conv_scalar, strnlen_scalar, copy_scalar, fill_scalar, 
+    decimal_scalar, hex_scalar, 
+    ESCAPE_KERNEL(find_escape_scalar) BASE64_KERNEL(base64_scalar)
+};
 
 
-/* prints the reversed version of val into buf */
-static int print_decimal_l(char *buf, int bufsz, unsigned long val)
+#ifdef FS_PROFILE_SPEED
+
+/* two digits per division */
+static int decimal_lut(char *buf, int bufsz, fs_umax value)
 {
     int len = 0;
-    unsigned long value = val;
+    unsigned int r;
 
-    if (value == 0 && bufsz > 0)
+    if (bufsz < KERNEL_DIGITS_BUFSIZE)
+        return decimal_scalar(buf, bufsz, value);
+    while (value >= 100)
     {
-        buf[0] = '0';
-        len = 1;
+        r = (unsigned int)(value % 100) * 2;
+        value /= 100;
+        buf[len] = s_digits2[r + 1];
+        buf[len + 1] = s_digits2[r];
+        len += 2;
     }
-    else while (len < bufsz && value)
+    r = (unsigned int)value * 2;
+    buf[len] = s_digits2[r + 1];
+    len += 1;
+    if (value >= 10)
     {
-        buf[len] = '0' + (value % 10);
-        value /= 10;
+        buf[len] = s_digits2[r];
         len += 1;
     }
-
     return len;
 }
 
 
+#  ifndef FS_CPU_X86_64
 
-static int print_hex_l(char *buf, int bufsz, unsigned long value, unsigned int flags)
+/* a byte at a time */
+static int hex_lut(char *buf, int bufsz, fs_umax value, unsigned int capitalized)
 {
+    const char (*lut)[2] = capitalized ? s_HEX2 : s_hex2;
     int len = 0;
-    unsigned long val = value;
-    const char *lut = s_hexchars;
-    char hex = 'x';
-
-    if (flags & CAPITALIZED)
-    {
-        lut = s_HEXCHARS;
-        hex = 'X';
-    }
+    unsigned int r;
 
-    if (0 == val && bufsz > 0)
+    if (bufsz < KERNEL_DIGITS_BUFSIZE)
+        return hex_scalar(buf, bufsz, value, capitalized);
+    while (value >= 0x100)
     {
-        buf[0] = '0';
-        len = 1;
+        r = (unsigned int)(value & 0xFF);
+        value >>= 8;
+        buf[len] = lut[r][1];
+        buf[len + 1] = lut[r][0];
+        len += 2;
     }
-    else while (val && len < bufsz)
+    r = (unsigned int)value;
+    buf[len] = lut[r][1];
+    len += 1;
+    if (value >= 0x10)
     {
-        buf[len] = lut[val & 0xF];
-        val >>= 4;
+        buf[len] = lut[r][0];
         len += 1;
     }
-
-    if ((flags & ALTERNATE_FORM) && (len + 2 <= bufsz))
-    {
-        buf[len] = hex;
-        buf[len + 1] = '0';
-        len += 2;
-    }
-
     return len;
 }
 
+/* FS_KERNELS_SWAR without x86-64 */
+static const fs_kernels s_kernels_lut = {
+    find_conv_scalar, strnlen_scalar, copy_scalar, fill_scalar, 
+    decimal_lut, hex_lut, 
+    ESCAPE_KERNEL(find_escape_scalar) BASE64_KERNEL(base64_scalar)
+};
+#  endif /* !FS_CPU_X86_64 */
 
+#endif /* FS_PROFILE_SPEED */
 
 
 
+#ifdef FS_CPU_X86_64
 
+typedef fs_size fs_word __attribute__((may_alias));
+typedef fs_size fs_word_u __attribute__((may_alias, aligned(1)));
 
-static void print_num_ld(char **bufptr, fs_size *left, int *ret,
-    long value, int minw, int precision, unsigned int flags)
-{
-    char tmp[DEC_BUFSIZE];
-    unsigned long abs_val;
-    int len;
-    unsigned int flags2 = flags;
+/* has_zero(x) is nonzero if any byte of x is 0 */
+#define SWAR_ONES               ((fs_size)-1 / 0xFF)
+#define SWAR_HIGHS              (SWAR_ONES * 0x80)
+#define SWAR_HAS_ZERO(x)        (((x) - SWAR_ONES) & ~(x) & SWAR_HIGHS)
+#define SWAR_HAS_LESS(x, n)     (((x) - SWAR_ONES * (n)) & ~(x) & SWAR_HIGHS)
+#define SWAR_IS_ALIGNED(p)      (0 == ((uintptr_t)(p) & (sizeof(fs_size) - 1)))
 
-    flags2 |= ((value < 0) << VALUE_NEG_POS);
-    flags2 |= ((value == 0) << VALUE_ZERO_POS);
+/* the scans read past the end of the string, but not past its page */
+#if defined(__SANITIZE_ADDRESS__)
+#  define SCAN_KERNEL __attribute__((no_sanitize_address))
+#else
+#  define SCAN_KERNEL
+#endif
 
-    if (value < 0)
-        abs_val = -value;
-    else
-        abs_val = value;
 
-    len = print_decimal_l(tmp, DEC_BUFSIZE, abs_val);
-    print_num_pad(bufptr, left, ret, minw, precision, flags2,  
-        tmp, len
-    );
-}
+/* aligned words never cross into a page that s does not touch */
+SCAN_KERNEL
+static const char *find_conv_swar(const char *s)
+{
+    const fs_size percents = SWAR_ONES * '%';
+    fs_size word;
 
+    for (; !SWAR_IS_ALIGNED(s); s += 1)
+    {
+        if (0 == *s || '%' == *s)
+            return s;
+    }
+    for (;; s += sizeof(fs_size))
+    {
+        word = *(const fs_word *)s;
+        if (SWAR_HAS_ZERO(word) | SWAR_HAS_ZERO(word ^ percents))
+            return find_conv_scalar(s);
+    }
+}
 
-static void print_num_lu(char **bufptr, fs_size *left, int *ret,
-    unsigned long value, int minw, int precision, unsigned int flags)
+#ifndef FS_NO_ESCAPE
+SCAN_KERNEL
+static fs_size find_escape_swar(const char *s, fs_size limit, int c_mode)
 {
-    char tmp[DEC_BUFSIZE];
-    int len;
-    unsigned int flags2 = flags;
-    flags2 |= ((value == 0) << VALUE_ZERO_POS);
+    const fs_size del = c_mode ? SWAR_ONES * 0x7F : 0;
+    fs_size i = 0;
+    fs_size word;
 
-    len = print_decimal_l(tmp, DEC_BUFSIZE, value);
-    print_num_pad(bufptr, left, ret, minw, precision, flags2,  
-        tmp, len
-    );
+    for (; i < limit && !SWAR_IS_ALIGNED(s + i); i += 1)
+    {
+        if (NEEDS_ESCAPE(s[i], c_mode))
+            return i;
+    }
+    for (; i < limit; i += sizeof(fs_size))
+    {
+        word = *(const fs_word *)(s + i);
+        if (SWAR_HAS_LESS(word, 0x20) | SWAR_HAS_ZERO(word ^ (SWAR_ONES * '"'))
+        | SWAR_HAS_ZERO(word ^ (SWAR_ONES * '\\')) | SWAR_HAS_ZERO(word ^ del))
+            break;
+    }
+    if (i >= limit)
+        return limit;
+    return i + find_escape_scalar(s + i, limit - i, c_mode);
 }
+#endif /* FS_NO_ESCAPE */
 
-
-static void print_num_lx(char **bufptr, fs_size *left, int *ret,
-    unsigned long value, int minw, int precision, unsigned int flags)
+#ifndef FS_NO_BASE64
+/* two groups from each 8 byte load, the loads stay inside src */
+static fs_size base64_swar(char *dst, const unsigned char *src, fs_size n, int url)
 {
-    char tmp[DEC_BUFSIZE];
-    int len;
-    unsigned int flags2 = flags;
-    flags2 |= ((value == 0) << VALUE_ZERO_POS);
+    const char *lut = url ? s_base64_url : s_base64;
+    fs_size i, bits, chars;
+    int k;
 
-    len = print_hex_l(tmp, DEC_BUFSIZE, value, flags2);
-    print_num_pad(bufptr, left, ret, minw, precision, flags2, 
-        tmp, len
-    );
+    for (i = 0; i + 8 <= n; i += 6)
+    {
+        bits = __builtin_bswap64(*(const fs_word_u *)(src + i));
+        chars = 0;
+        for (k = 0; k < 8; k += 1)
+            chars |= (fs_size)(unsigned char)lut[(bits >> (58 - 6 * k)) & 0x3F] << (8 * k);
+        *(fs_word_u *)dst = chars;
+        dst += 8;
+    }
+    return i + base64_scalar(dst, src + i, n - i, url);
 }
+#endif /* FS_NO_BASE64 */
 
 
+/* the 8 nibbles of v as the 8 bytes of a word, lowest nibble first */
+static fs_size hex_spread(fs_u32 v)
+{
+    fs_size x = v;
+    x = (x | (x << 16)) & ((fs_size)-1 / 0xFFFFFFFF * 0xFFFF);
+    x = (x | (x << 8)) & ((fs_size)-1 / 0xFFFF * 0xFF);
+    x = (x | (x << 4)) & (SWAR_ONES * 0x0F);
+    return x;
+}
 
-static void print_str(char **bufptr, fs_size *left, int *ret, 
-    const char *str, int minw, int precision, unsigned int flags)
+/* nibbles to digits, (n + 6) & 0x10 is set for the nibbles past 9 */
+static fs_size hex_digits(fs_size nibbles, unsigned int capitalized)
 {
-    long width;
-    if (flags & PRECISION_PROVIDED)
-        width = strlen_up_to(str, (unsigned long)precision);
-    else 
-        width = strlen_up_to(str, 0);
+    fs_size letters = ((nibbles + SWAR_ONES * 6) & (SWAR_ONES * 0x10)) >> 4;
+    return nibbles + SWAR_ONES * '0' + letters * (capitalized ? 7 : 39);
+}
 
+static int hex_swar(char *buf, int bufsz, fs_umax value, unsigned int capitalized)
+{
+    int len = (int)sizeof(fs_umax) * 2;
+
+    if (bufsz < KERNEL_DIGITS_BUFSIZE)
+        return hex_scalar(buf, bufsz, value, capitalized);
+    *(fs_word_u *)buf = hex_digits(hex_spread((fs_u32)value), capitalized);
+    if (sizeof(fs_umax) > 4)
+        *(fs_word_u *)(buf + 8) = hex_digits(hex_spread((fs_u32)(value >> 16 >> 16)), capitalized);
+    while (len > 1 && '0' == buf[len - 1])
+        len -= 1;
+    return len;
+}
 
-    if ((width < minw) && !(flags & PAD_RIGHT))
-        print_pad(bufptr, left, ret, ' ', minw - width);
+static const fs_kernels s_kernels_swar = {
+    find_conv_swar, strnlen_scalar, copy_scalar, fill_scalar, 
+    decimal_lut, hex_swar, 
+    ESCAPE_KERNEL(find_escape_swar) BASE64_KERNEL(base64_swar)
+};
+
+
+
+typedef char fs_v16 __attribute__((vector_size(16), may_alias));
+typedef char fs_v16u __attribute__((vector_size(16), may_alias, aligned(1)));
+typedef char fs_v32 __attribute__((vector_size(32), may_alias));
+typedef char fs_v32u __attribute__((vector_size(32), may_alias, aligned(1)));
+typedef char fs_v64 __attribute__((vector_size(64), may_alias));
+typedef char fs_v64u __attribute__((vector_size(64), may_alias, aligned(1)));
+typedef unsigned char fs_u8v16 __attribute__((vector_size(16), may_alias));
+typedef unsigned char fs_u8v32 __attribute__((vector_size(32), may_alias));
+typedef unsigned char fs_u8v64 __attribute__((vector_size(64), may_alias));
+
+/* one bit per byte of a comparison result */
+#define MOVEMASK_16(v)  ((fs_size)(unsigned int)__builtin_ia32_pmovmskb128(v))
+#define MOVEMASK_32(v)  ((fs_size)(unsigned int)__builtin_ia32_pmovmskb256(v))
+#define MOVEMASK_64(v)  ((fs_size)__builtin_ia32_cvtb2mask512(v))
+#define FIRST_BIT(mask) ((fs_size)__builtin_ctzll(mask))
+
+
+/* 
+ * find_conv, strnlen, copy and fill for one vector width,
+ * the scans only load aligned vectors, starting from the one that holds s 
+ */
+#define VECTOR_KERNELS(name, isa, width, vec, vecu, uvec, movemask) \
+__attribute__((target(isa))) SCAN_KERNEL \
+static const char *find_conv_##name(const char *s) \
+{ \
+    const char *p = (const char *)((uintptr_t)s & ~(uintptr_t)(width - 1)); \
+    const vec zeros = {0}; \
+    const vec percents = zeros + '%'; \
+    vec v = *(const vec *)p; \
+    fs_size mask = movemask((v == zeros) | (v == percents)) >> (s - p); \
+    if (mask) \
+        return s + FIRST_BIT(mask); \
+    for (;;) \
+    { \
+        p += width; \
+        v = *(const vec *)p; \
+        mask = movemask((v == zeros) | (v == percents)); \
+        if (mask) \
+            return p + FIRST_BIT(mask); \
+    } \
+} \
+\
+__attribute__((target(isa))) SCAN_KERNEL \
+static fs_size strnlen_##name(const char *s, fs_size limit) \
+{ \
+    const char *p = (const char *)((uintptr_t)s & ~(uintptr_t)(width - 1)); \
+    const vec zeros = {0}; \
+    fs_size mask, len; \
+    if (0 == limit) \
+        return 0; \
+    mask = movemask(*(const vec *)p == zeros) >> (s - p); \
+    if (mask) \
+        return FIRST_BIT(mask) < limit ? FIRST_BIT(mask) : limit; \
+    for (len = width - (s - p); len < limit; len += width) \
+    { \
+        p += width; \
+        mask = movemask(*(const vec *)p == zeros); \
+        if (mask) \
+            return len + FIRST_BIT(mask) < limit ? len + FIRST_BIT(mask) : limit; \
+    } \
+    return limit; \
+} \
+\
+/* the last vector overlaps the one before it */ \
+__attribute__((target(isa))) \
+static void copy_##name(char *dst, const char *src, fs_size n) \
+{ \
+    fs_size i; \
+    if (n < width) \
+    { \
+        copy_scalar(dst, src, n); \
+        return; \
+    } \
+    for (i = 0; i + width < n; i += width) \
+        *(vecu *)(dst + i) = *(const vecu *)(src + i); \
+    *(vecu *)(dst + n - width) = *(const vecu *)(src + n - width); \
+} \
+\
+__attribute__((target(isa))) \
+static void fill_##name(char *dst, char ch, fs_size n) \
+{ \
+    const vec zeros = {0}; \
+    const vec chars = zeros + ch; \
+    fs_size i; \
+    if (n < width) \
+    { \
+        fill_scalar(dst, ch, n); \
+        return; \
+    } \
+    for (i = 0; i + width < n; i += width) \
+        *(vecu *)(dst + i) = chars; \
+    *(vecu *)(dst + n - width) = chars; \
+}
 
-    spool_str(bufptr, left, ret, str, width, flags & CAPITALIZED);
+VECTOR_KERNELS(sse2, "sse2", 16, fs_v16, fs_v16u, fs_u8v16, MOVEMASK_16)
+VECTOR_KERNELS(avx2, "avx2", 32, fs_v32, fs_v32u, fs_u8v32, MOVEMASK_32)
+VECTOR_KERNELS(avx512, "avx512bw", 64, fs_v64, fs_v64u, fs_u8v64, MOVEMASK_64)
+
+#ifndef FS_NO_ESCAPE
+/* find_escape for one vector width, loading aligned vectors like the scans above */
+#define VECTOR_ESCAPE_KERNEL(name, isa, width, vec, uvec, movemask) \
+__attribute__((target(isa))) SCAN_KERNEL \
+static fs_size find_escape_##name(const char *s, fs_size limit, int c_mode) \
+{ \
+    const char *p = (const char *)((uintptr_t)s & ~(uintptr_t)(width - 1)); \
+    const uvec zeros = {0}; \
+    const uvec controls = zeros + 0x20; \
+    const uvec quotes = zeros + '"'; \
+    const uvec backslashes = zeros + '\\'; \
+    const uvec dels = zeros + (unsigned char)(c_mode ? 0x7F : 0); \
+    uvec v; \
+    fs_size mask, len; \
+    if (0 == limit) \
+        return 0; \
+    v = *(const uvec *)p; \
+    mask = movemask((vec)((v < controls) | (v == quotes) \
+        | (v == backslashes) | (v == dels))) >> (s - p); \
+    if (mask) \
+        return FIRST_BIT(mask) < limit ? FIRST_BIT(mask) : limit; \
+    for (len = width - (s - p); len < limit; len += width) \
+    { \
+        p += width; \
+        v = *(const uvec *)p; \
+        mask = movemask((vec)((v < controls) | (v == quotes) \
+            | (v == backslashes) | (v == dels))); \
+        if (mask) \
+            return len + FIRST_BIT(mask) < limit ? len + FIRST_BIT(mask) : limit; \
+    } \
+    return limit; \
+}
 
-    if ((width < minw) && (flags & PAD_RIGHT))
-        print_pad(bufptr, left, ret, ' ', minw - width);
+VECTOR_ESCAPE_KERNEL(sse2, "sse2", 16, fs_v16, fs_u8v16, MOVEMASK_16)
+VECTOR_ESCAPE_KERNEL(avx2, "avx2", 32, fs_v32, fs_u8v32, MOVEMASK_32)
+VECTOR_ESCAPE_KERNEL(avx512, "avx512bw", 64, fs_v64, fs_u8v64, MOVEMASK_64)
+#endif /* FS_NO_ESCAPE */
+
+#ifndef FS_NO_BASE64
+/* 
+ * 12 bytes to 16 characters with SSSE3 shuffles, after Wojciech Mula's encoder:
+ * the bytes are spread so that each 32 bit lane holds one group, 
+ * the multiplies shift the four 6 bit indices into their own bytes, 
+ * which are then turned into characters by adding a per range offset.
+ * every AVX2 CPU has SSSE3, the plain SSE2 level stays on the SWAR encoder
+ */
+typedef short fs_i16v8 __attribute__((vector_size(16)));
+typedef unsigned short fs_u16v8 __attribute__((vector_size(16)));
+typedef unsigned int fs_u32v4 __attribute__((vector_size(16)));
+typedef unsigned char fs_u8v16u __attribute__((vector_size(16), may_alias, aligned(1)));
+
+__attribute__((target("ssse3")))
+static fs_size base64_ssse3(char *dst, const unsigned char *src, fs_size n, int url)
+{
+    const fs_v16 spread = { 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10 };
+    const fs_u32v4 mulhi = { 0x04000040, 0x04000040, 0x04000040, 0x04000040 };
+    const fs_u32v4 mullo = { 0x01000010, 0x01000010, 0x01000010, 0x01000010 };
+    fs_v16 offsets = { 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, 
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0 };
+    fs_v16 groups;
+    fs_u16v8 hi, lo;
+    fs_u8v16 indices, ranges;
+    fs_size i;
+
+    if (url)
+    {
+        offsets[11] = '-' - 62;
+        offsets[12] = '_' - 63;
+    }
+    for (i = 0; i + 16 <= n; i += 12)
+    {
+        groups = __builtin_ia32_pshufb128((fs_v16)*(const fs_u8v16u *)(src + i), spread);
+        hi = (fs_u16v8)__builtin_ia32_pmulhuw128(
+            (fs_i16v8)((fs_u32v4)groups & 0x0FC0FC00), (fs_i16v8)mulhi);
+        lo = (fs_u16v8)((fs_u32v4)groups & 0x003F03F0) * (fs_u16v8)mullo;
+        indices = (fs_u8v16)(hi | lo);
+
+        /* 0 for A-Z, 13 for a-z, 1 to 10 for 0-9, 11 and 12 for the last two */
+        ranges = (indices - 51) & (fs_u8v16)(indices > 51);
+        ranges |= (fs_u8v16)(indices < 26) & 13;
+        *(fs_u8v16u *)dst = (fs_u8v16)__builtin_ia32_pshufb128(offsets, (fs_v16)ranges) + indices;
+        dst += 16;
+    }
+    return i + base64_swar(dst, src + i, n - i, url);
 }
+#endif /* FS_NO_BASE64 */
+
+
+/* the digits stay on the SWAR and lookup table kernels, 
+ * a number is too short to fill a vector */
+static const fs_kernels s_kernels_sse2 = {
+    find_conv_sse2, strnlen_sse2, copy_sse2, fill_sse2, 
+    decimal_lut, hex_swar, 
+    ESCAPE_KERNEL(find_escape_sse2) BASE64_KERNEL(base64_swar)
+};
+static const fs_kernels s_kernels_avx2 = {
+    find_conv_avx2, strnlen_avx2, copy_avx2, fill_avx2, 
+    decimal_lut, hex_swar, 
+    ESCAPE_KERNEL(find_escape_avx2) BASE64_KERNEL(base64_ssse3)
+};
+static const fs_kernels s_kernels_avx512 = {
+    find_conv_avx512, strnlen_avx512, copy_avx512, fill_avx512, 
+    decimal_lut, hex_swar, 
+    ESCAPE_KERNEL(find_escape_avx512) BASE64_KERNEL(base64_ssse3)
+};
+
+#endif /* FS_CPU_X86_64 */
+
+
+
+/* picked on the first call, which can race with other threads
+ * or with fs_snprintf_set_kernels(). the tables are constant, 
+ * so relaxed atomic accesses are enough. without the __atomic builtins
+ * fs_snprintf_dispatch() has to be called before any other thread formats */
+static const fs_kernels *s_kernels = &s_kernels_scalar;
+static int s_kernels_level = -1; /* not dispatched yet */
+
+#ifdef FS_ATOMICS
+#  define KERNELS_LOAD(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+#  define KERNELS_STORE(var, value) __atomic_store_n(&(var), (value), __ATOMIC_RELAXED)
+#else
+#  define KERNELS_LOAD(var) (var)
+#  define KERNELS_STORE(var, value) ((var) = (value))
+#endif /* FS_ATOMICS */
 
+static const fs_kernels *kernels(void)
+{
+    return KERNELS_LOAD(s_kernels);
+}
 
 
-static void print_chr(char **bufptr, fs_size *left, int *ret,
-    char ch, int minw, unsigned int flags)
+/* the best level the running CPU supports */
+static int kernels_supported(void)
 {
-    char character = ch;
-    if ((flags & CAPITALIZED) && is_lower(ch))
-        character = TO_UPPER_FROM_LOWER(ch);
+#ifdef FS_CPU_X86_64
+    unsigned int features = fs_cpu_features();
+    if (features & FS_CPU_AVX512BW)
+        return FS_KERNELS_AVX512;
+    if (features & FS_CPU_AVX2)
+        return FS_KERNELS_AVX2;
+    if (features & FS_CPU_SSE2)
+        return FS_KERNELS_SSE2;
+    return FS_KERNELS_SWAR;
+#elif defined(FS_PROFILE_SPEED)
+    return FS_KERNELS_SWAR;
+#else
+    return FS_KERNELS_SCALAR;
+#endif /* FS_CPU_X86_64 */
+}
 
 
-    if ((1 < minw) && !(flags & PAD_RIGHT))
-        print_pad(bufptr, left, ret, ' ', minw - 1);
+int fs_snprintf_set_kernels(int level)
+{
+    int supported = kernels_supported();
+    const fs_kernels *table;
 
-    print_pad(bufptr, left, ret, character, 1);
+    if (level < FS_KERNELS_SCALAR)
+        level = FS_KERNELS_SCALAR;
+    if (level > supported)
+        level = supported;
 
-    if ((1 < minw) && (flags & PAD_RIGHT))
-        print_pad(bufptr, left, ret, ' ', minw - 1);
+    switch (level)
+    {
+#ifdef FS_CPU_X86_64
+    case FS_KERNELS_SWAR: table = &s_kernels_swar; break;
+    case FS_KERNELS_SSE2: table = &s_kernels_sse2; break;
+    case FS_KERNELS_AVX2: table = &s_kernels_avx2; break;
+    case FS_KERNELS_AVX512: table = &s_kernels_avx512; break;
+#elif defined(FS_PROFILE_SPEED)
+    case FS_KERNELS_SWAR: table = &s_kernels_lut; break;
+#endif /* FS_CPU_X86_64 */
+    default: table = &s_kernels_scalar; break;
+    }
+    KERNELS_STORE(s_kernels, table);
+    KERNELS_STORE(s_kernels_level, level);
+    return level;
 }
 
 
+int fs_snprintf_dispatch(void)
+{
+    return fs_snprintf_set_kernels(kernels_supported());
+}
 
 
-#ifdef FS_64BIT_DEFINED
 
+/* if limit is 0, this function will act like strlen */
+static unsigned long strlen_up_to(const char *s, unsigned long limit)
+{
+    if (0 == limit)
+        return (unsigned long)kernels()->strnlen(s, (fs_size)-1);
+    return (unsigned long)kernels()->strnlen(s, limit);
+}
 
 
 
-/* prints the reversed version of val into buf */
-static int print_decimal_ll(char *buf, int bufsz, unsigned long long val)
-{
-    int len = 0;
-    unsigned long long value = val;
 
-    if (value == 0 && bufsz > 0)
+/* drops up to count bytes from the pending skip, 
+ * returns how many of the count bytes are left to be written */
+static int writer_skip(fs_writer *w, int count)
+{
+    if (w->skip >= (fs_size)count)
     {
-        buf[0] = '0';
-        len = 1;
+        w->skip -= count;
+        return 0;
     }
-    else while (len < bufsz && value)
+    count -= (int)w->skip;
+    w->skip = 0;
+    return count;
+}
+
+
+
+#ifndef FS_NO_ESCAPE
+/* notes that the output of the current conversion before ret 
+ * came from the first src bytes of its source, 
+ * so a resume can start there instead of from the beginning.
+ * a resume_ret of 0 is no mark */
+static void writer_mark(fs_writer *w, fs_size ret, fs_size src)
+{
+    w->resume_ret = ret;
+    w->resume_src = src;
+}
+
+
+/* moves a resumed conversion to its mark if the mark lies within the bytes 
+ * to skip, and sets *src to how many bytes of its source to jump over.
+ * returns 0 if there is no such mark */
+static int writer_resume(fs_writer *w, fs_size *src)
+{
+    *src = 0;
+    if (w->resume_ret <= w->ret || w->resume_ret - w->ret > w->skip)
+        return 0;
+    w->skip -= w->resume_ret - w->ret;
+    w->ret = w->resume_ret;
+    *src = w->resume_src;
+    return 1;
+}
+#endif /* FS_NO_ESCAPE */
+
+
+
+/* asks the sink for room for count more bytes */
+static int writer_grow(fs_writer *w, fs_size count)
+{
+    fs_sink *sink = w->sink;
+
+    if (NULL != sink->buf)
+        sink->used = w->bufptr - sink->buf;
+    if (!sink->grow(sink, count))
     {
-        buf[len] = '0' + (value % 10);
-        value /= 10;
-        len += 1;
+        /* keep writing what still fits in the old buffer */
+        w->sink = NULL;
+        return 0;
     }
+    w->bufptr = sink->buf + sink->used;
+    w->left = sink->size - sink->used + 1;
+    return 1;
+}
 
-    return len;
+
+/* nothing more can be written and the full length is not needed */
+static int writer_full(const fs_writer *w)
+{
+    return w->stop && !w->skip && w->left <= 1 && NULL == w->sink;
+}
+
+
+/* returns how many of the next count bytes fit */
+static fs_size writer_room(fs_writer *w, fs_size count)
+{
+    if (w->left > count)
+        return count;
+    if (NULL != w->sink && writer_grow(w, count))
+        return count;
+    return w->left > 1 ? w->left - 1 : 0;
 }
 
 
 
-static int print_hex_ll(char *buf, int bufsz, unsigned long value, unsigned int flags)
+static void spool_str_rev(fs_writer *w, const char *numstr, int len)
 {
-    int len = 0;
-    unsigned long long val = value;
-    const char *lut = s_hexchars;
-    char hex = 'x';
+    int i = len;
+    int n;
 
-    if (flags & CAPITALIZED)
+    w->ret += len;
+    if (w->skip)
+        i = writer_skip(w, len);
+    n = (int)writer_room(w, i);
+    w->left -= n;
+    while (n--)
     {
-        hex = 'X';
-        lut = s_HEXCHARS;
+        i -= 1;
+        (*w->bufptr) = numstr[i];
+        w->bufptr += 1;
     }
+}
+
 
-    if (0 == val && bufsz > 0)
+
+static void spool_str(fs_writer *w, 
+    const char *str, int len, unsigned int capitalized)
+{
+    int i = 0;
+    int end;
+
+    w->ret += len;
+    if (w->skip)
+        i = len - writer_skip(w, len);
+    end = i + (int)writer_room(w, len - i);
+    w->left -= end - i;
+    if (!capitalized)
     {
-        buf[0] = '0';
-        len = 1;
+        kernels()->copy(w->bufptr, str + i, end - i);
+        w->bufptr += end - i;
+        return;
     }
-    else while (val && len < bufsz)
+    for (; i < end; i += 1)
     {
-        buf[len] = lut[val & 0xF]; /* lookup each nibble of a byte */
-        val >>= 4;
-        len += 1;
+        if (capitalized && is_lower(str[i]))
+            (*w->bufptr) = TO_UPPER_FROM_LOWER(str[i]);
+        else
+            (*w->bufptr) = str[i];
+        w->bufptr += 1;
+    }
+}
+
+
+
+
+static void print_pad(fs_writer *w, char pad, int count)
+{
+    int n = count;
+    if (n <= 0)
+        return;
+
+    w->ret += n;
+    if (w->skip)
+        n = writer_skip(w, n);
+    n = (int)writer_room(w, n);
+    w->left -= n;
+    kernels()->fill(w->bufptr, pad, n);
+    w->bufptr += n;
+}
+
+
+static void print_num_pad(
+    fs_writer *w,
+    int minw, int precision, unsigned int flags,
+    const char *numstr, int len)
+{
+    int numw = len;
+    char signch = get_signch(flags);
+
+    if (0 == precision && (flags & VALUE_ZERO)) numw = 0;
+    if (numw < precision) numw = precision;
+
+
+    if (flags & PAD_RIGHT)
+    {
+        /* number left, padding right */
+        /* [sign][zeros][number][spaces] */
+
+        if (signch) /* print the sign ch */
+        {
+            numw += 1;
+            print_pad(w, signch, 1);
+        }
+
+
+        /* number */
+        if (precision || !(flags & VALUE_ZERO))
+        {
+            if (len < precision)
+                print_pad(w, '0', precision - len);
+            spool_str_rev(w, numstr, len);
+        }
+
+
+        /* spaces */
+        if (numw < minw)
+            print_pad(w, ' ', minw - numw);
+    }
+    else
+    {
+        /* padding left, number right */
+        /* [spaces][sign][zeros][number] */
+
+        if ((flags & ZEROPAD) && !(flags & PRECISION_PROVIDED) && (numw < minw))
+            numw = minw;
+        else if (signch)
+            numw += 1;
+
+        /* space pad */
+        if (numw < minw)
+            print_pad(w, ' ', minw - numw);
+
+        /* sign */
+        if (signch)
+        {
+            print_pad(w, signch, 1);
+            numw -= 1;
+        }
+
+        /* zeros */
+        if (len < numw)
+        {
+            print_pad(w, '0', numw - len);
+        }
+
+        if (precision || !(flags & VALUE_ZERO))
+            spool_str_rev(w, numstr, len);
     }
+}
+
+
+
+/* prints the reversed version of val into buf */
+static int print_decimal_l(char *buf, int bufsz, unsigned long val)
+{
+    return kernels()->decimal(buf, bufsz, val);
+}
+
+
+
+static int print_hex_l(char *buf, int bufsz, unsigned long value, unsigned int flags)
+{
+    char hex = (flags & CAPITALIZED) ? 'X' : 'x';
+    int len = kernels()->hex(buf, bufsz, value, flags & CAPITALIZED);
 
     if ((flags & ALTERNATE_FORM) && (len + 2 <= bufsz))
     {
@@ -514,6 +1287,7 @@ static int print_hex_ll(char *buf, int bufsz, unsigned long value, unsigned int
         buf[len + 1] = '0';
         len += 2;
     }
+
     return len;
 }
 
@@ -521,11 +1295,13 @@ static int print_hex_ll(char *buf, int bufsz, unsigned long value, unsigned int
 
 
 
-static void print_num_lld(char **bufptr, fs_size *left, int *ret,
-    long long value, int minw, int precision, unsigned int flags)
+
+
+static void print_num_ld(fs_writer *w,
+    long value, int minw, int precision, unsigned int flags)
 {
     char tmp[DEC_BUFSIZE];
-    unsigned long long abs_val;
+    unsigned long abs_val;
     int len;
     unsigned int flags2 = flags;
 
@@ -537,157 +1313,405 @@ static void print_num_lld(char **bufptr, fs_size *left, int *ret,
     else
         abs_val = value;
 
-    len = print_decimal_ll(tmp, DEC_BUFSIZE, abs_val);
-    print_num_pad(bufptr, left, ret, minw, precision, flags2,  
+    len = print_decimal_l(tmp, DEC_BUFSIZE, abs_val);
+    print_num_pad(w, minw, precision, flags2,  
         tmp, len
     );
 }
 
 
-
-
-static void print_num_llu(char **bufptr, fs_size *left, int *ret,
-    unsigned long long value, int minw, int precision, unsigned int flags)
+static void print_num_lu(fs_writer *w,
+    unsigned long value, int minw, int precision, unsigned int flags)
 {
     char tmp[DEC_BUFSIZE];
     int len;
     unsigned int flags2 = flags;
     flags2 |= ((value == 0) << VALUE_ZERO_POS);
 
-    len = print_decimal_ll(tmp, DEC_BUFSIZE, value);
-    print_num_pad(bufptr, left, ret, minw, precision, flags2,  
+    len = print_decimal_l(tmp, DEC_BUFSIZE, value);
+    print_num_pad(w, minw, precision, flags2,  
         tmp, len
     );
 }
 
 
-
-static void print_num_llx(char **bufptr, fs_size *left, int *ret,
-    unsigned long long value, int minw, int precision, unsigned int flags)
+static void print_num_lx(fs_writer *w,
+    unsigned long value, int minw, int precision, unsigned int flags)
 {
     char tmp[DEC_BUFSIZE];
     int len;
     unsigned int flags2 = flags;
     flags2 |= ((value == 0) << VALUE_ZERO_POS);
 
-    len = print_hex_ll(tmp, DEC_BUFSIZE, value, flags2);
-    print_num_pad(bufptr, left, ret, minw, precision, flags2, 
+    len = print_hex_l(tmp, DEC_BUFSIZE, value, flags2);
+    print_num_pad(w, minw, precision, flags2, 
         tmp, len
     );
 }
 
 
 
+static void print_strn(fs_writer *w, 
+    const char *str, long width, int minw, unsigned int flags)
+{
+    if ((width < minw) && !(flags & PAD_RIGHT))
+        print_pad(w, ' ', minw - width);
 
+    spool_str(w, str, width, flags & CAPITALIZED);
 
+    if ((width < minw) && (flags & PAD_RIGHT))
+        print_pad(w, ' ', minw - width);
+}
 
 
-static int print_float_remainder(char *buf, int len,
-    double remainder, int precision, unsigned int flags)
+#ifndef FS_NO_IOV
+/* ends the current scratch segment at end */
+static void iov_flush(fs_iov_state *state, char *end)
 {
-    int count = 0;
-    fs_u64 value;
-    fs_u64 shift; /* power of 10 required to turn the remainder into a whole number */
+    if (end == state->segment)
+        return;
+    state->iov[state->count].iov_base = state->segment;
+    state->iov[state->count].iov_len = end - state->segment;
+    state->count += 1;
+    state->segment = end;
+}
 
-    if (precision > FLT_MAX_PRECISION)
-        precision = FLT_MAX_PRECISION;
-    if (len < precision)
+
+/* puts str in the iov as it is, returns 0 if it has to be copied instead */
+static int iov_ref_str(fs_writer *w, 
+    const char *str, long width, int minw, unsigned int flags)
+{
+    fs_iov_state *state = w->iov;
+
+    /* the segment before str, str and the last segment */
+    if (width < FS_IOV_MIN_REF || (flags & CAPITALIZED) || state->count + 3 > state->max)
         return 0;
 
+    if ((width < minw) && !(flags & PAD_RIGHT))
+        print_pad(w, ' ', minw - width);
 
-    shift = quick_pow10(precision);
-    remainder *= (double)shift;
+    iov_flush(state, w->bufptr);
+    state->iov[state->count].iov_base = (void *)str;
+    state->iov[state->count].iov_len = width;
+    state->count += 1;
+    w->ret += width;
 
-    value = (fs_u64)remainder;
-    if (((remainder - (double)value) >= 0.5))
-    {
-        value += 1;
-        if (value >= shift) 
-            value = shift - 1;
-    }
+    if ((width < minw) && (flags & PAD_RIGHT))
+        print_pad(w, ' ', minw - width);
+    return 1;
+}
+#endif /* FS_NO_IOV */
 
-    /* only do this after rounding */
-    if (flags & FLT_G_FORMAT)
-    {
-        int omitted_zeros = 0;
-        if (0 == value)
-            return 0;
 
-        while (value && (value % 10 == 0))
-        {
-            omitted_zeros += 1;
-            value /= 10;
-        }
-        if (omitted_zeros < precision)
-            precision -= omitted_zeros;
-    }
+static long str_width(const char *str, int precision, unsigned int flags)
+{
+    if (flags & PRECISION_PROVIDED)
+        return strlen_up_to(str, (unsigned long)precision);
+    return strlen_up_to(str, 0);
+}
 
 
-    count = print_decimal_ll(buf, len, value);
-    /* pad zeros for numbers like 0.004 */
-    while (count < precision)
-    {
-        buf[count] = '0';
-        count += 1;
-    }
-    if (count < len)
-    {
-        buf[count] = '.';
-        count += 1;
-    }
-    return count;
+#ifndef FS_NO_PTR
+static void print_str(fs_writer *w, 
+    const char *str, int minw, int precision, unsigned int flags)
+{
+    print_strn(w, str, str_width(str, precision, flags), minw, flags);
 }
+#endif /* FS_NO_PTR */
 
 
 
-/* value itself should NOT be negative */
-static int print_float(char **buf, int len, 
-    double value, int precision, unsigned int flags)
+static void print_chr(fs_writer *w,
+    char ch, int minw, unsigned int flags)
 {
-    int remainder_len = 0, whole_len = 0, total_len;
-    fs_u64 whole = (fs_u64)value;
-    double remainder = value - (double)whole;
+    char character = ch;
+    if ((flags & CAPITALIZED) && is_lower(ch))
+        character = TO_UPPER_FROM_LOWER(ch);
 
-    /* leave print_float_remainder to check for trailing zeros,
-     * because double might not be accurate enough */
-    if (precision)
-    {
-        remainder_len = print_float_remainder(*buf, len,
-            remainder, precision, flags
-        );
-    }
 
-    whole_len = print_decimal_ll(
-        *buf + remainder_len, len - remainder_len, whole
-    );
+    if ((1 < minw) && !(flags & PAD_RIGHT))
+        print_pad(w, ' ', minw - 1);
 
-    total_len = whole_len + remainder_len;
-    if ((flags & FLT_G_FORMAT) 
-    && remainder_len && (total_len - 1 > precision))
-    {
-        int insignif_len = total_len - precision;
-        (*buf) += insignif_len;
+    print_pad(w, character, 1);
 
-        if (len >= insignif_len + precision) /* buffer len check */
-            total_len = precision;
-        else
-            total_len = 0;
-    }
-    return total_len;
+    if ((1 < minw) && (flags & PAD_RIGHT))
+        print_pad(w, ' ', minw - 1);
 }
 
 
 
 
-#else /* !FS_64BIT_DEFINED */ 
-
+#ifndef FS_NO_TIMESTAMP
+/* writes the two digits of n, which is less than 100 */
+static void put_digits2(char *buf, unsigned int n)
+{
+#ifdef FS_PROFILE_SPEED
+    buf[0] = s_digits2[n * 2];
+    buf[1] = s_digits2[n * 2 + 1];
+#else
+    buf[0] = (char)('0' + n / 10);
+    buf[1] = (char)('0' + n % 10);
+#endif /* FS_PROFILE_SPEED */
+}
+
+
+/* writes YYYY-MM-DDTHH:MM:SS in UTC, returns its length */
+static int print_datetime(char *buf, fs_internal_sec sec)
+{
+    fs_internal_sec days = sec / 86400;
+    fs_internal_sec z, era, year;
+    long rem = (long)(sec % 86400);
+    unsigned long doe, yoe, doy, mp, month, day;
+    int len = 0;
+
+    if (rem < 0)
+    {
+        rem += 86400;
+        days -= 1;
+    }
+
+    /* civil_from_days() by Howard Hinnant, 
+     * counts in eras of 400 years starting at 0000-03-01 */
+    z = days + 719468;
+    era = (z >= 0 ? z : z - 146096) / 146097;
+    doe = (unsigned long)(z - era * 146097);
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = (fs_internal_sec)yoe + era * 400 + (month <= 2);
+
+    if (0 <= year && year <= 9999)
+    {
+        put_digits2(buf, (unsigned int)(year / 100));
+        put_digits2(buf + 2, (unsigned int)(year % 100));
+        len = 4;
+    }
+    else
+    {
+        /* expanded year, +10000 or -0001 */
+        char tmp[DEC_BUFSIZE];
+        int n = 0;
+        buf[len++] = year < 0 ? '-' : '+';
+        if (year < 0)
+            year = -year;
+        for (; year || n < 4; year /= 10)
+            tmp[n++] = '0' + (char)(year % 10);
+        while (n)
+            buf[len++] = tmp[--n];
+    }
+
+    buf[len] = '-';
+    put_digits2(buf + len + 1, (unsigned int)month);
+    buf[len + 3] = '-';
+    put_digits2(buf + len + 4, (unsigned int)day);
+    buf[len + 6] = 'T';
+    put_digits2(buf + len + 7, (unsigned int)(rem / 3600));
+    buf[len + 9] = ':';
+    put_digits2(buf + len + 10, (unsigned int)(rem / 60 % 60));
+    buf[len + 12] = ':';
+    put_digits2(buf + len + 13, (unsigned int)(rem % 60));
+    return len + 15;
+}
+
+
+#ifdef FS_ATOMICS
+/* the date and time of the last second printed, 
+ * log lines come in bursts within the same second */
+static struct {
+    unsigned long seq;
+    fs_internal_sec sec;
+    int len; /* 0 while empty */
+    char text[DATETIME_BUFSIZE];
+} s_datetime_cache;
+#endif /* FS_ATOMICS */
+
+
+static int cached_datetime(char *buf, fs_internal_sec sec)
+{
+#ifdef FS_ATOMICS
+    unsigned long seq = seq_read_begin(&s_datetime_cache.seq);
+    int len = s_datetime_cache.len;
+    int i;
+
+    if (s_datetime_cache.sec == sec && 0 < len && len <= DATETIME_BUFSIZE)
+    {
+        for (i = 0; i < len; i += 1)
+            buf[i] = s_datetime_cache.text[i];
+        if (seq_read_end(&s_datetime_cache.seq, seq))
+            return len;
+    }
+
+    len = print_datetime(buf, sec);
+    if (seq_write_begin(&s_datetime_cache.seq, &seq))
+    {
+        s_datetime_cache.sec = sec;
+        s_datetime_cache.len = len;
+        for (i = 0; i < len; i += 1)
+            s_datetime_cache.text[i] = buf[i];
+        seq_write_end(&s_datetime_cache.seq, seq);
+    }
+    return len;
+#else
+    return print_datetime(buf, sec);
+#endif /* FS_ATOMICS */
+}
+
+
+/* ISO 8601 timestamp from seconds since the epoch and microseconds,
+ * YYYY-MM-DDTHH:MM:SS.ffffff, precision is the number of fraction digits */
+static void print_timestamp(fs_writer *w, 
+    fs_internal_sec sec, long usec, int minw, int precision, unsigned int flags)
+{
+    char tmp[DATETIME_BUFSIZE + 1 + TIMESTAMP_MAX_PRECISION];
+    unsigned long frac;
+    int len;
+
+    if (usec < 0 || usec >= 1000000)
+    {
+        sec += usec / 1000000;
+        usec %= 1000000;
+        if (usec < 0)
+        {
+            usec += 1000000;
+            sec -= 1;
+        }
+    }
+    if (!(flags & PRECISION_PROVIDED) || precision > TIMESTAMP_MAX_PRECISION)
+        precision = TIMESTAMP_MAX_PRECISION;
+
+    len = cached_datetime(tmp, sec);
+    if (precision > 0)
+    {
+        /* digits past the precision are cut off */
+        frac = (unsigned long)usec;
+        tmp[len] = '.';
+        put_digits2(tmp + len + 1, (unsigned int)(frac / 10000));
+        put_digits2(tmp + len + 3, (unsigned int)(frac / 100 % 100));
+        put_digits2(tmp + len + 5, (unsigned int)(frac % 100));
+        len += 1 + precision;
+    }
+    print_strn(w, tmp, len, minw, flags);
+}
+#endif /* FS_NO_TIMESTAMP */
+
+
+
+
+#ifdef FS_64BIT_DEFINED
+
+
+
+
+/* prints the reversed version of val into buf */
+static int print_decimal_ll(char *buf, int bufsz, unsigned long long val)
+{
+    return kernels()->decimal(buf, bufsz, val);
+}
+
+
+
+static int print_hex_ll(char *buf, int bufsz, unsigned long long value, unsigned int flags)
+{
+    char hex = (flags & CAPITALIZED) ? 'X' : 'x';
+    int len = kernels()->hex(buf, bufsz, value, flags & CAPITALIZED);
+
+    if ((flags & ALTERNATE_FORM) && (len + 2 <= bufsz))
+    {
+        buf[len] = hex;
+        buf[len + 1] = '0';
+        len += 2;
+    }
+    return len;
+}
+
+
+
+
+
+#ifdef FS_NO_LONGLONG
+
+/* %ll goes through the long paths, see fs_snprintf.h */
+#  define print_num_lld(w, value, minw, precision, flags) \
+    print_num_ld(w, (long)(value), minw, precision, flags)
+#  define print_num_llu(w, value, minw, precision, flags) \
+    print_num_lu(w, (unsigned long)(value), minw, precision, flags)
+#  define print_num_llx(w, value, minw, precision, flags) \
+    print_num_lx(w, (unsigned long)(value), minw, precision, flags)
+
+#else
+
+static void print_num_lld(fs_writer *w,
+    long long value, int minw, int precision, unsigned int flags)
+{
+    char tmp[DEC_BUFSIZE];
+    unsigned long long abs_val;
+    int len;
+    unsigned int flags2 = flags;
+
+    flags2 |= ((value < 0) << VALUE_NEG_POS);
+    flags2 |= ((value == 0) << VALUE_ZERO_POS);
+
+    if (value < 0)
+        abs_val = -value;
+    else
+        abs_val = value;
+
+    len = print_decimal_ll(tmp, DEC_BUFSIZE, abs_val);
+    print_num_pad(w, minw, precision, flags2,  
+        tmp, len
+    );
+}
+
+
+
+
+static void print_num_llu(fs_writer *w,
+    unsigned long long value, int minw, int precision, unsigned int flags)
+{
+    char tmp[DEC_BUFSIZE];
+    int len;
+    unsigned int flags2 = flags;
+    flags2 |= ((value == 0) << VALUE_ZERO_POS);
+
+    len = print_decimal_ll(tmp, DEC_BUFSIZE, value);
+    print_num_pad(w, minw, precision, flags2,  
+        tmp, len
+    );
+}
+
+
+
+static void print_num_llx(fs_writer *w,
+    unsigned long long value, int minw, int precision, unsigned int flags)
+{
+    char tmp[DEC_BUFSIZE];
+    int len;
+    unsigned int flags2 = flags;
+    flags2 |= ((value == 0) << VALUE_ZERO_POS);
+
+    len = print_hex_ll(tmp, DEC_BUFSIZE, value, flags2);
+    print_num_pad(w, minw, precision, flags2, 
+        tmp, len
+    );
+}
+
+#endif /* FS_NO_LONGLONG */
+
+
+
+
+
+
 
+/* *carry is set if the fraction rounds up to the next whole number */
 static int print_float_remainder(char *buf, int len,
-    double remainder, int precision, unsigned int flags)
+    double remainder, int precision, unsigned int flags, int *carry)
 {
     int count = 0;
-    fs_u32 value;
-    fs_u32 shift; /* power of 10 required to turn the remainder into a whole number */
+    fs_u64 value;
+    fs_u64 shift; /* power of 10 required to turn the remainder into a whole number */
 
     if (precision > FLT_MAX_PRECISION)
         precision = FLT_MAX_PRECISION;
@@ -698,14 +1722,15 @@ static int print_float_remainder(char *buf, int len,
     shift = quick_pow10(precision);
     remainder *= (double)shift;
 
-    /* rounding up if required */
-    value = (fs_u32)remainder;
+    value = (fs_u64)remainder;
     if (((remainder - (double)value) >= 0.5))
     {
         value += 1;
-        /* if the rounding resulted in overflow, ignore it */
         if (value >= shift) 
-            value = shift - 1;
+        {
+            value -= shift;
+            *carry = 1;
+        }
     }
 
     /* only do this after rounding */
@@ -714,7 +1739,8 @@ static int print_float_remainder(char *buf, int len,
         int omitted_zeros = 0;
         if (0 == value)
             return 0;
-        while (value % 10 == 0)
+
+        while (value && (value % 10 == 0))
         {
             omitted_zeros += 1;
             value /= 10;
@@ -723,7 +1749,8 @@ static int print_float_remainder(char *buf, int len,
             precision -= omitted_zeros;
     }
 
-    count = print_decimal_l(buf, len, value);
+
+    count = print_decimal_ll(buf, len, value);
     /* pad zeros for numbers like 0.004 */
     while (count < precision)
     {
@@ -739,29 +1766,34 @@ static int print_float_remainder(char *buf, int len,
 }
 
 
+
 /* value itself should NOT be negative */
 static int print_float(char **buf, int len, 
     double value, int precision, unsigned int flags)
 {
-    int whole_len = 0, remainder_len = 0, total_len;
-    fs_u32 whole = (fs_u32)value;
+    int remainder_len = 0, whole_len = 0, total_len;
+    int carry = 0;
+    fs_u64 whole = (fs_u64)value;
     double remainder = value - (double)whole;
 
-    /* double might not be accurate enough, 
-     * leave print_float_remainder to check for trailing zeros */
+    /* leave print_float_remainder to check for trailing zeros,
+     * because double might not be accurate enough */
     if (precision)
     {
         remainder_len = print_float_remainder(*buf, len,
-            remainder, precision, flags
+            remainder, precision, flags, &carry
         );
     }
+    else 
+        carry = remainder >= 0.5;
+    whole += carry;
 
-    whole_len = print_decimal_l(
+    whole_len = print_decimal_ll(
         *buf + remainder_len, len - remainder_len, whole
     );
 
     total_len = whole_len + remainder_len;
-    if ((flags & FLT_G_FORMAT)
+    if ((flags & FLT_G_FORMAT) 
     && remainder_len && (total_len - 1 > precision))
     {
         int insignif_len = total_len - precision;
@@ -778,72 +1810,374 @@ static int print_float(char **buf, int len,
 
 
 
-#endif /* FS_64BIT_DEFINED */
-
+#else /* !FS_64BIT_DEFINED */ 
 
 
-/* outbuf is assumed to have a size of HEX_BUFSIZE */
-static int print_hex_bytes(char *outbuf, const void *ptr, unsigned int flags)
+/* *carry is set if the fraction rounds up to the next whole number */
+static int print_float_remainder(char *buf, int len,
+    double remainder, int precision, unsigned int flags, int *carry)
 {
-    const char *lut = s_hexchars;
-    char hex = 'x';
-    union {
-        fs_u8 bytes[sizeof(ptr)];
-        const void *ptr;
-    } cvt;
-    unsigned int i = 0;
-    cvt.ptr = ptr;
+    int count = 0;
+    fs_u32 value;
+    fs_u32 shift; /* power of 10 required to turn the remainder into a whole number */
 
-    if (flags & CAPITALIZED)
-    {
-        lut = s_HEXCHARS;
-        hex = 'X';
-    }
+    if (precision > FLT_MAX_PRECISION)
+        precision = FLT_MAX_PRECISION;
+    if (len < precision)
+        return 0;
 
 
-    fs_endian_host_to_little(cvt.bytes, 1, sizeof(ptr));
-    for (; i < sizeof(ptr)*2; i += 2)
+    shift = quick_pow10(precision);
+    remainder *= (double)shift;
+
+    /* rounding up if required */
+    value = (fs_u32)remainder;
+    if (((remainder - (double)value) >= 0.5))
     {
-        outbuf[i] = lut[0xF & cvt.bytes[i/2]];              /* lower 4 bits */
-        outbuf[i + 1] = lut[0xF & (cvt.bytes[i/2] >> 4)];   /* upper 4 bits */
+        value += 1;
+        if (value >= shift) 
+        {
+            value -= shift;
+            *carry = 1;
+        }
     }
 
+    /* only do this after rounding */
+    if (flags & FLT_G_FORMAT)
+    {
+        int omitted_zeros = 0;
+        if (0 == value)
+            return 0;
+        while (value % 10 == 0)
+        {
+            omitted_zeros += 1;
+            value /= 10;
+        }
+        if (omitted_zeros < precision)
+            precision -= omitted_zeros;
+    }
 
-    /* outbuf   :   "00102030" */
-    if (!(flags & ALTERNATE_FORM))
+    count = print_decimal_l(buf, len, value);
+    /* pad zeros for numbers like 0.004 */
+    while (count < precision)
     {
-        /* trim the leading zeros */
-        while (i > 1 && (outbuf[i - 1] == '0')) 
-            i -= 1;
+        buf[count] = '0';
+        count += 1;
     }
-    /* 0x */
-    outbuf[i] = hex;
-    outbuf[i + 1] = '0';
-    i += 2;
-    return i;
+    if (count < len)
+    {
+        buf[count] = '.';
+        count += 1;
+    }
+    return count;
 }
 
 
-static void print_ptr(char **bufptr, fs_size *left, int *ret, 
-    const void *ptr, int minw, int precision, unsigned int flags)
+/* value itself should NOT be negative */
+static int print_float(char **buf, int len, 
+    double value, int precision, unsigned int flags)
 {
-    char hexbuf[HEX_BUFSIZE];
-    int len;
+    int whole_len = 0, remainder_len = 0, total_len;
+    int carry = 0;
+    fs_u32 whole = (fs_u32)value;
+    double remainder = value - (double)whole;
 
-    if (NULL == ptr)
+    /* double might not be accurate enough, 
+     * leave print_float_remainder to check for trailing zeros */
+    if (precision)
     {
-        print_str(bufptr, left, ret, 
-            s_nullptr_string, minw, precision, flags
+        remainder_len = print_float_remainder(*buf, len,
+            remainder, precision, flags, &carry
         );
-        return;
     }
+    else 
+        carry = remainder >= 0.5;
+    whole += carry;
 
-    len = print_hex_bytes(hexbuf, ptr, flags);
-    print_num_pad(bufptr, left, ret, minw, 
-        precision, flags, 
-        hexbuf, len
-    );
+    whole_len = print_decimal_l(
+        *buf + remainder_len, len - remainder_len, whole
+    );
+
+    total_len = whole_len + remainder_len;
+    if ((flags & FLT_G_FORMAT)
+    && remainder_len && (total_len - 1 > precision))
+    {
+        int insignif_len = total_len - precision;
+        (*buf) += insignif_len;
+
+        if (len >= insignif_len + precision) /* buffer len check */
+            total_len = precision;
+        else
+            total_len = 0;
+    }
+    return total_len;
+}
+
+
+
+
+#endif /* FS_64BIT_DEFINED */
+
+
+
+#ifndef FS_NO_FIXED
+/* %j, value / 10^scale with precision fraction digits, 
+ * rounded half away from zero on the integer alone */
+static void print_fixed(fs_writer *w, fs_internal_sec value, int scale, 
+    int minw, int precision, unsigned int flags)
+{
+    char digits[DEC_BUFSIZE];
+    char tmp[FIXED_BUFSIZE];
+    fs_umax magnitude = value < 0 ? 0 - (fs_umax)value : (fs_umax)value;
+    fs_umax divisor, rem;
+    int len = 0, n, shift = 0, i;
+
+    if (scale > FIXED_MAX_SCALE || scale < -FIXED_MAX_SCALE)
+        return;
+    if (!(flags & PRECISION_PROVIDED))
+        precision = scale > 0 ? scale : 0;
+    if (precision > FIXED_MAX_SCALE)
+        precision = FIXED_MAX_SCALE;
+
+    /* drop the digits past the precision */
+    if (scale > precision)
+    {
+        for (n = scale - precision, divisor = 1; n && divisor <= (fs_umax)-1 / 10; n -= 1)
+            divisor *= 10;
+        if (n) /* 10^(scale - precision) is over twice the largest magnitude */
+            magnitude = 0;
+        else
+        {
+            rem = magnitude % divisor;
+            magnitude = magnitude / divisor + (rem >= divisor - rem);
+        }
+        scale = precision;
+    }
+    else if (scale < 0)
+    {
+        shift = magnitude ? -scale : 0;
+        scale = 0;
+    }
+
+#ifdef FS_64BIT_DEFINED
+    n = print_decimal_ll(digits, DEC_BUFSIZE, magnitude);
+#else
+    n = print_decimal_l(digits, DEC_BUFSIZE, magnitude);
+#endif /* FS_64BIT_DEFINED */
+
+    /* reversed: [zeros past the scale][fraction][.][zeros of a negative scale][whole] */
+    for (i = scale; i < precision; i += 1)
+        tmp[len++] = '0';
+    for (i = 0; i < scale; i += 1)
+        tmp[len++] = i < n ? digits[i] : '0';
+    if (precision)
+        tmp[len++] = '.';
+    for (i = 0; i < shift; i += 1)
+        tmp[len++] = '0';
+    if (n <= scale)
+        tmp[len++] = '0';
+    for (i = scale; i < n; i += 1)
+        tmp[len++] = digits[i];
+
+    /* no "-0.00" */
+    flags &= ~(PRECISION_PROVIDED | VALUE_NEG | VALUE_ZERO);
+    if (value < 0 && magnitude)
+        flags |= VALUE_NEG;
+    print_num_pad(w, minw, 0, flags, tmp, len);
+}
+#endif /* FS_NO_FIXED */
+
+
+
+#ifndef FS_NO_PTR
+/* outbuf is assumed to have a size of HEX_BUFSIZE */
+static int print_hex_bytes(char *outbuf, const void *ptr, unsigned int flags)
+{
+#ifdef FS_PROFILE_SPEED
+    const char (*lut)[2] = (flags & CAPITALIZED) ? s_HEX2 : s_hex2;
+#else
+    const char *lut = (flags & CAPITALIZED) ? s_HEXCHARS : s_hexchars;
+#endif /* FS_PROFILE_SPEED */
+    char hex = (flags & CAPITALIZED) ? 'X' : 'x';
+    union {
+        fs_u8 bytes[sizeof(ptr)];
+        const void *ptr;
+    } cvt;
+    unsigned int i = 0;
+    cvt.ptr = ptr;
+
+
+    fs_endian_host_to_little(cvt.bytes, 1, sizeof(ptr));
+    for (; i < sizeof(ptr)*2; i += 2)
+    {
+#ifdef FS_PROFILE_SPEED
+        outbuf[i] = lut[cvt.bytes[i/2]][1];
+        outbuf[i + 1] = lut[cvt.bytes[i/2]][0];
+#else
+        outbuf[i] = lut[0xF & cvt.bytes[i/2]];              /* lower 4 bits */
+        outbuf[i + 1] = lut[0xF & (cvt.bytes[i/2] >> 4)];   /* upper 4 bits */
+#endif /* FS_PROFILE_SPEED */
+    }
+
+
+    /* outbuf   :   "00102030" */
+    if (!(flags & ALTERNATE_FORM))
+    {
+        /* trim the leading zeros */
+        while (i > 1 && (outbuf[i - 1] == '0')) 
+            i -= 1;
+    }
+    /* 0x */
+    outbuf[i] = hex;
+    outbuf[i + 1] = '0';
+    i += 2;
+    return i;
+}
+#endif /* FS_NO_PTR */
+
+
+#ifndef FS_NO_IPADDR
+/* a.b.c.d, returns the length */
+static int print_ip4_bytes(char *buf, const fs_u8 *addr)
+{
+    int len = 0;
+    int i, n;
+#ifdef FS_PROFILE_SPEED
+    const char *dec;
+
+    for (i = 0; i < 4; i += 1)
+    {
+        dec = s_byte_dec[addr[i]];
+        n = dec[3];
+        buf[len] = dec[0];
+        buf[len + 1] = dec[1];
+        buf[len + 2] = dec[2];
+        len += n;
+        buf[len] = '.';
+        len += 1;
+    }
+#else
+    for (i = 0; i < 4; i += 1)
+    {
+        n = addr[i];
+        if (n >= 100)
+            buf[len++] = (char)('0' + n / 100);
+        if (n >= 10)
+            buf[len++] = (char)('0' + n / 10 % 10);
+        buf[len++] = (char)('0' + n % 10);
+        buf[len++] = '.';
+    }
+#endif /* FS_PROFILE_SPEED */
+    return len - 1; /* no '.' after the last byte */
+}
+
+
+/* RFC 5952 text form, the same as inet_ntop: 
+ * the longest run of 2 or more zero groups becomes "::", 
+ * ::ffff:0:0/96 and ::/96 end in dotted IPv4 */
+static int print_ip6_bytes(char *buf, const fs_u8 *addr)
+{
+    unsigned int groups[8];
+    int best = -1, best_len = 0, run = -1, run_len = 0;
+    int len = 0;
+    int i;
+
+    for (i = 0; i < 8; i += 1)
+    {
+        groups[i] = ((unsigned int)addr[i * 2] << 8) | addr[i * 2 + 1];
+        if (0 == groups[i])
+        {
+            if (run < 0)
+                run = i;
+            run_len += 1;
+            if (run_len > best_len)
+            {
+                best = run;
+                best_len = run_len;
+            }
+        }
+        else
+        {
+            run = -1;
+            run_len = 0;
+        }
+    }
+    if (best_len < 2)
+        best = -1;
+
+    for (i = 0; i < 8; i += 1)
+    {
+        unsigned int g = groups[i];
+
+        if (i == best)
+        {
+            buf[len++] = ':';
+            i += best_len - 1;
+            if (i == 7)
+                buf[len++] = ':';
+            continue;
+        }
+        if (i)
+            buf[len++] = ':';
+        if (6 == i && 0 == best 
+        && (6 == best_len || (5 == best_len && 0xFFFF == groups[5])))
+        {
+            len += print_ip4_bytes(buf + len, addr + 12);
+            break;
+        }
+
+        if (g >> 12) buf[len++] = s_hexchars[g >> 12];
+        if (g >> 8) buf[len++] = s_hexchars[(g >> 8) & 0xF];
+        if (g >> 4) buf[len++] = s_hexchars[(g >> 4) & 0xF];
+        buf[len++] = s_hexchars[g & 0xF];
+    }
+    return len;
+}
+
+
+/* addr points to the address in network order, like a struct in_addr or in6_addr */
+static void print_ip(fs_writer *w, 
+    const void *addr, int conv, int minw, unsigned int flags)
+{
+    char buf[IP6_BUFSIZE];
+    int len;
+
+    if (NULL == addr)
+    {
+        print_strn(w, s_nullptr_string, sizeof(s_nullptr_string) - 1, minw, flags);
+        return;
+    }
+    if (CONV_IP4 == conv)
+        len = print_ip4_bytes(buf, addr);
+    else
+        len = print_ip6_bytes(buf, addr);
+    print_strn(w, buf, len, minw, flags);
+}
+#endif /* FS_NO_IPADDR */
+
+
+#ifndef FS_NO_PTR
+static void print_ptr(fs_writer *w,
+    const void *ptr, int minw, int precision, unsigned int flags)
+{
+    char hexbuf[HEX_BUFSIZE];
+    int len;
+
+    if (NULL == ptr)
+    {
+        print_str(w, 
+            s_nullptr_string, minw, precision, flags
+        );
+        return;
+    }
+
+    len = print_hex_bytes(hexbuf, ptr, flags);
+    print_num_pad(w, minw, 
+        precision, flags, 
+        hexbuf, len
+    );
 }
+#endif /* FS_NO_PTR */
 
 
 
@@ -852,7 +2186,9 @@ static void print_ptr(char **bufptr, fs_size *left, int *ret,
 
 
 
-static void print_num_f(char **bufptr, fs_size *left, int *ret,
+#ifndef FS_NO_FLOAT
+
+static void print_num_f(fs_writer *w,
     double num, int minw, int precision, unsigned int flags_)
 {
     char a_tmp[FLT_BUFSIZE];
@@ -879,13 +2215,13 @@ static void print_num_f(char **bufptr, fs_size *left, int *ret,
     sign = get_signch(flags);
     if (sign && len)
     {
-        print_pad(bufptr, left, ret, sign, 1);
+        print_pad(w, sign, 1);
     }
-    spool_str_rev(bufptr, left, ret, tmp, len);
+    spool_str_rev(w, tmp, len);
 }
 
 
-static void print_num_e(char **bufptr, fs_size *left, int *ret,
+static void print_num_e(fs_writer *w,
     double num, int minw, int precision, unsigned int flags)
 {
 }
@@ -894,13 +2230,13 @@ static void print_num_e(char **bufptr, fs_size *left, int *ret,
 
 
 
-static void print_num_lf(char **bufptr, fs_size *left, int *ret,
+static void print_num_lf(fs_writer *w,
     long double num, int minw, int precision, unsigned int flags)
 {
 }
 
 
-static void print_num_le(char **bufptr, fs_size *left, int *ret,
+static void print_num_le(fs_writer *w,
     long double num, int minw, int precision, unsigned int flags)
 {
 }
@@ -908,29 +2244,30 @@ static void print_num_le(char **bufptr, fs_size *left, int *ret,
 
 
 
-static void print_num_g(char **bufptr, fs_size *left, int *ret,
+static void print_num_g(fs_writer *w,
     double num, int minw, int precision, unsigned int flags_)
 {
     int exponent = fs_exp_of_double(num);
 
     if (g_format_should_use_e(exponent, precision, flags_))
-        print_num_e(bufptr, left, ret, num, minw, precision, flags_);
+        print_num_e(w, num, minw, precision, flags_);
     else
-        print_num_f(bufptr, left, ret, num, minw, precision, flags_ | FLT_G_FORMAT);
+        print_num_f(w, num, minw, precision, flags_ | FLT_G_FORMAT);
 }
 
 
-static void print_num_lg(char **bufptr, fs_size *left, int *ret,
+static void print_num_lg(fs_writer *w,
     long double num, int minw, int precision, unsigned int flags_)
 {
     int exponent = fs_exp_of_ldouble(num);
 
     if (g_format_should_use_e(exponent, precision, flags_))
-        print_num_le(bufptr, left, ret, num, minw, precision, flags_);
+        print_num_le(w, num, minw, precision, flags_);
     else
-        print_num_lf(bufptr, left, ret, num, minw, precision, flags_ | FLT_G_FORMAT);
+        print_num_lf(w, num, minw, precision, flags_ | FLT_G_FORMAT);
 }
 
+#endif /* FS_NO_FLOAT */
 
 
 
@@ -940,132 +2277,107 @@ static void print_num_lg(char **bufptr, fs_size *left, int *ret,
 
 
 
-int fs_snprintf(char *buf, fs_size bufsz, const char *fmt, ...)
+
+static void writer_init(fs_writer *w, char *buf, fs_size bufsz)
 {
-    int ret;
-    va_list args;
-    va_start(args, fmt);
-    ret = fs_vsnprintf(buf, bufsz, fmt, args);
-    va_end(args);
-    return ret;
+    w->bufptr = buf;
+    w->left = bufsz;
+    w->ret = 0;
+    w->skip = 0;
+    w->stop = 0;
+    w->cut = 0;
+    w->resume_ret = 0;
+    w->resume_src = 0;
+    w->sink = NULL;
+    w->iov = NULL;
+    if (KERNELS_LOAD(s_kernels_level) < 0)
+        fs_snprintf_dispatch(); /* racing threads store the same table */
 }
 
-int fs_vsnprintf(char *buf, fs_size bufsz, const char *fmt, va_list ap)
+
+
+/* parses the conversion specification after '%', 
+ * returns a pointer past the conversion character */
+static const char *parse_spec(const char *fmtptr, fs_internal_conv_spec *spec)
 {
     unsigned int flags = 0;
-    int minw;
-    int precision;
-    int l_count;
+    int minw = 0;
+    int precision = 1;
+    int l_count = 0;
     int conv;
-    int ret = 0;
-    const char *fmtptr = fmt;
-    char *bufptr = buf;
-    fs_size left = bufsz;
-
-    if (NULL == buf)
-        bufsz = 0;
 
 
-    while (*fmtptr)
+    /* get flags */
+    for (;;fmtptr += 1)
     {
-        /* copy raw string */
-        while (*fmtptr && '%' != *fmtptr)
+        switch (*fmtptr)
         {
-            if (left > 1)
-            {
-                *bufptr = *fmtptr;
-                bufptr += 1;
-                fmtptr += 1;
-                left -= 1;
-            }
-            else fmtptr += 1;
-            ret += 1;
+        case ' ': flags |= SPACE; break;
+        case '0': flags |= ZEROPAD; break;
+        case '+': flags |= PLUS; break;
+        case '-': flags |= PAD_RIGHT; break;
+        case '#': flags |= ALTERNATE_FORM; break;
+        default: goto done_flags;
         }
+    }
+done_flags:
 
-        if (0 == *fmtptr) break; /* null character */
+    /* get variable width */
+    if ('*' == *fmtptr)
+    {
+        fmtptr += 1; /* skips '*' */
+        flags |= WIDTH_FROM_ARG;
+    }
+    /* parse width */
+    else while (is_number(*fmtptr))
+    {
+        minw = minw * 10 + (*fmtptr) - '0';
         fmtptr += 1;
+    }
 
 
-        flags = 0;
-        minw = 0;
-        l_count = 0;
-        precision = 1;
-
-
-        /* get flags */
-        for (;;fmtptr += 1)
-        {
-            switch (*fmtptr)
-            {
-            case ' ': flags |= SPACE; break;
-            case '0': flags |= ZEROPAD; break;
-            case '+': flags |= PLUS; break;
-            case '-': flags |= PAD_RIGHT; break;
-            case '#': flags |= ALTERNATE_FORM; break;
-            default: goto done_flags;
-            }
-        }
-done_flags:
+    /* get precision */
+    if ('.' == *fmtptr)
+    {
+        fmtptr += 1; /* skip '.' */
+        flags |= PRECISION_PROVIDED;
+        precision = 0;
 
-        /* get variable width */
+        /* variable precision */
         if ('*' == *fmtptr)
         {
             fmtptr += 1; /* skips '*' */
-            minw = va_arg(ap, int);
-            if (minw < 0)
-            {
-                flags |= PAD_RIGHT;
-                minw = -minw;
-            }
+            flags |= PRECISION_FROM_ARG;
         }
-        /* parse width */
+        /* parse precision */
         else while (is_number(*fmtptr))
         {
-            minw = minw * 10 + (*fmtptr) - '0';
+            precision = precision * 10 + (*fmtptr) - '0';
             fmtptr += 1;
         }
+    }
 
 
-        /* get precision */
-        if ('.' == *fmtptr)
-        {
-            fmtptr += 1; /* skip '.' */
-            flags |= PRECISION_PROVIDED;
-            precision = 0;
-
-            /* variable precision */
-            if ('*' == *fmtptr)
-            {
-                fmtptr += 1; /* skips '*' */
-                precision = va_arg(ap, int);
-                if (precision < 0)
-                {
-                    flags |= PAD_RIGHT;
-                    precision = 0;
-                }
-            }
-            /* parse precision */
-            else while (is_number(*fmtptr))
-            {
-                precision = precision * 10 + (*fmtptr) - '0';
-                fmtptr += 1;
-            }
-        }
-
-
-        /* get length */
+    /* get length */
+    if ('l' == *fmtptr)
+    {
+        fmtptr += 1; /* skip 'l' */
+        l_count = 1;
         if ('l' == *fmtptr)
         {
-            fmtptr += 1; /* skip 'l' */
-            l_count = 1;
-            if ('l' == *fmtptr)
-            {
-                fmtptr += 1;
-                l_count = 2;
-            }
+            fmtptr += 1;
+            l_count = 2;
         }
+    }
 
-        conv = *fmtptr;
+    conv = *fmtptr;
+    if ('I' == conv && ('4' == fmtptr[1] || '6' == fmtptr[1]))
+    {
+        conv = ('4' == fmtptr[1]) ? CONV_IP4 : CONV_IP6;
+        fmtptr += 2;
+    }
+    else
+    {
         if (conv) 
             fmtptr += 1;
         if (is_upper(conv)) 
@@ -1073,353 +2385,2246 @@ done_flags:
             flags |= CAPITALIZED;
             conv = TO_LOWER_FROM_UPPER(conv);
         }
+    }
 
-        switch (conv)
-        {
-        case 'i':
-        case 'd':
-            if (l_count == 0)
-                print_num_ld(&bufptr, &left, &ret, 
-                    va_arg(ap, int), minw, precision, flags
-                );
-#ifdef FS_64BIT_DEFINED
-            else if (l_count == 2)
-                print_num_lld(&bufptr, &left, &ret,
-                    va_arg(ap, long long), minw, precision, flags
-                );
-#endif /* FS_64BIT_DEFINED */
-            else
-                print_num_ld(&bufptr, &left, &ret, 
-                    va_arg(ap, long), minw, precision, flags
-                );
-            break;
+    spec->flags = flags;
+    spec->minw = minw;
+    spec->precision = precision;
+    spec->l_count = l_count;
+    spec->conv = conv;
+    return fmtptr;
+}
 
 
-        case 'u':
-            if (l_count == 0)
-                print_num_lu(&bufptr, &left, &ret, 
-                    va_arg(ap, unsigned int), minw, precision, flags
-                );
-#ifdef FS_64BIT_DEFINED
-            else if (l_count == 2)
-                print_num_llu(&bufptr, &left, &ret, 
-                    va_arg(ap, unsigned long long), minw, precision, flags
-                );
-#endif /* FS_64BIT_DEFINED */
-            else if (l_count == 1)
-                print_num_lu(&bufptr, &left, &ret, 
-                    va_arg(ap, unsigned long), minw, precision, flags
-                );
-            break;
 
+#ifndef FS_NO_CUSTOM
+/* 
+ * conversions registered with fs_register_conversion(), by lowercase letter, 
+ * the built-in conversions are checked first, 
+ * so these only cost something to the conversions that are not built in 
+ */
+typedef struct fs_custom_conv
+{
+    fs_conversion fn;
+    void *ctx;
+} fs_custom_conv;
 
-        case 'x':
-            if (l_count == 0)
-                print_num_lx(&bufptr, &left, &ret, 
-                    va_arg(ap, unsigned int), minw, precision, flags
-                );
-#ifdef FS_64BIT_DEFINED
-            else if (l_count == 2)
-                print_num_llx(&bufptr, &left, &ret, 
-                    va_arg(ap, unsigned long long), minw, precision, flags
-                );
-#endif /* FS_64BIT_DEFINED */
-            else if (l_count == 1)
-                print_num_lx(&bufptr, &left, &ret, 
-                    va_arg(ap, unsigned long), minw, precision, flags
-                );
-            break;
+static fs_custom_conv s_conversions[26];
 
+/* the letters parse_spec() and print_conv() already use, lowercase */
+static const char s_builtin_conversions[] = "cdfgijklmnpqrsuvxy";
 
-        case 's':
-            print_str(&bufptr, &left, &ret, 
-                va_arg(ap, const char *), minw, precision, flags
-            );
-            break;
 
+static const fs_custom_conv *find_custom_conv(int conv)
+{
+    if (conv < 'a' || conv > 'z' || NULL == s_conversions[conv - 'a'].fn)
+        return NULL;
+    return &s_conversions[conv - 'a'];
+}
 
-        case 'c':
-            print_chr(&bufptr, &left, &ret, 
-                va_arg(ap, int), minw, flags
-            );
-            break;
 
-#ifndef FREESTANDING_TRULY
-        case 'm':
-            print_str(&bufptr, &left, &ret, 
-                strerror(errno), minw, precision, flags
-            );
-            break;
-#endif /* !FREESTANDING_TRULY */
+int fs_register_conversion(int letter, fs_conversion fn, void *ctx)
+{
+    const char *builtin;
 
-        case 'p':
-            print_ptr(&bufptr, &left, &ret,
-                va_arg(ap, const void *), minw, precision, flags
-            );
-            break;
+    if (letter < 'a' || letter > 'z')
+        return -1;
+    for (builtin = s_builtin_conversions; *builtin; builtin += 1)
+    {
+        if (letter == *builtin)
+            return -1;
+    }
+    s_conversions[letter - 'a'].fn = fn;
+    s_conversions[letter - 'a'].ctx = ctx;
+    return 0;
+}
+#endif /* FS_NO_CUSTOM */
 
-        case '%':
-            print_chr(&bufptr, &left, &ret, 
-                '%', minw, flags
-            );
-            break;
 
-        case 'n':
-            *va_arg(ap, int*) = ret;
-            break;
+void fs_writer_write(fs_writer *w, const char *s, fs_size len)
+{
+    int n;
+    while (len)
+    {
+        n = len > INT_MAX ? INT_MAX : (int)len;
+        spool_str(w, s, n, 0);
+        s += n;
+        len -= n;
+    }
+}
 
-        case 'f':
-            if (l_count)
-                print_num_lf(&bufptr, &left, &ret, 
-                    va_arg(ap, long double), minw, precision, flags
-                );
-            else
-                print_num_f(&bufptr, &left, &ret,
-                    va_arg(ap, double), minw, precision, flags
-                );
-            break;
+void fs_writer_pad(fs_writer *w, char ch, fs_size count)
+{
+    int n;
+    while (count)
+    {
+        n = count > INT_MAX ? INT_MAX : (int)count;
+        print_pad(w, ch, n);
+        count -= n;
+    }
+}
 
-        case 'g': 
-            if (l_count)
-                print_num_lg(&bufptr, &left, &ret, 
-                    va_arg(ap, long double), minw, precision, flags
-                );
-            else
-                print_num_g(&bufptr, &left, &ret,
-                    va_arg(ap, double), minw, precision, flags
-                );
-            break;
 
+#ifndef FS_NO_CUSTOM
+/* runs a registered conversion, the width is applied around its output, 
+ * which is measured with a dry run first when it is right aligned */
+static void print_custom(fs_writer *w, const fs_internal_conv *conv)
+{
+    const fs_custom_conv *custom = find_custom_conv(conv->spec.conv);
+    unsigned int flags = conv->spec.flags;
+    fs_conv_spec spec;
+    fs_writer dry;
+    fs_size start = w->ret;
+    fs_size minw = (fs_size)conv->spec.minw;
+
+    spec.conv = conv->spec.conv;
+    spec.flags = flags & (FS_CONV_SPACE | FS_CONV_LEFT | FS_CONV_PLUS 
+        | FS_CONV_ZERO | FS_CONV_ALT | FS_CONV_UPPER);
+    spec.width = conv->spec.minw;
+    spec.precision = (flags & PRECISION_PROVIDED) ? conv->spec.precision : -1;
+    spec.length = conv->spec.l_count;
+
+    if (conv->spec.minw > 0 && !(flags & PAD_RIGHT))
+    {
+        writer_init(&dry, NULL, 0);
+        custom->fn(&dry, &spec, conv->arg.ptr, custom->ctx);
+        if (dry.ret < minw)
+            fs_writer_pad(w, ' ', minw - dry.ret);
+        start = w->ret;
+    }
 
+    custom->fn(w, &spec, conv->arg.ptr, custom->ctx);
 
+    if ((flags & PAD_RIGHT) && w->ret - start < minw)
+        fs_writer_pad(w, ' ', minw - (w->ret - start));
+}
+#endif /* FS_NO_CUSTOM */
 
 
-        default: 
-        case 0: break;
-        }
-    }
-
-    /* left is always greater than 0 if bufsize is nonzero, 
-     * checking because snprintf can be used as 
-     * a kind of strlen for the hypothetically formatted string 
-     * when bufsize is 0 */
-    if (left > 0)
-        *bufptr = 0;
-    return ret;
-}
-
 
+#ifndef FS_NO_ESCAPE
+/* pairs of a byte and the letter of its escape, the rest are numeric */
+static const char s_json_escapes[] = "\"\"\\\\\bb\ff\nn\rr\tt";
+static const char s_c_escapes[] = "\"\"\\\\\bb\ff\nn\rr\tt\aa\vv";
 
+/* writes str escaped for a JSON string, or a C string literal if c_mode, 
+ * from done up to a null character or limit bytes. 
+ * the runs in between escapes are copied as they are. 
+ * once the buffer is full it stops and marks where to resume */
+static void escape_str(fs_writer *w, 
+    const char *str, fs_size done, fs_size limit, int c_mode, unsigned int flags)
+{
+    const char *lut = (flags & CAPITALIZED) ? s_HEXCHARS : s_hexchars;
+    const char *escapes = c_mode ? s_c_escapes : s_json_escapes;
+    char esc[6];
+    unsigned char ch;
+    fs_size run, before_ret, before_skip;
+    char *before;
+    int i, len;
+
+    while (done < limit && str[done])
+    {
+        if (writer_full(w))
+        {
+            writer_mark(w, w->ret, done);
+            w->cut = 1;
+            return;
+        }
 
+        before = w->bufptr;
+        before_ret = w->ret;
+        before_skip = w->skip;
+        run = kernels()->find_escape(str + done, limit - done, c_mode);
+        if (run)
+        {
+            fs_writer_write(w, str + done, run);
 
+            /* cut off inside the run, which maps byte for byte */
+            if (before_skip < run && writer_full(w) 
+            && before_skip + (fs_size)(w->bufptr - before) < run)
+            {
+                run = before_skip + (fs_size)(w->bufptr - before);
+                writer_mark(w, before_ret + run, done + run);
+                w->cut = 1;
+                return;
+            }
+            done += run;
+            continue;
+        }
 
+        ch = (unsigned char)str[done];
+        for (i = 0; escapes[i] && (unsigned char)escapes[i] != ch; i += 2)
+            ;
+        esc[0] = '\\';
+        if (escapes[i])
+        {
+            esc[1] = escapes[i + 1];
+            len = 2;
+        }
+        else if (c_mode)
+        {
+            esc[1] = '0' + (ch >> 6);
+            esc[2] = '0' + ((ch >> 3) & 7);
+            esc[3] = '0' + (ch & 7);
+            len = 4;
+        }
+        else
+        {
+            esc[1] = 'u';
+            esc[2] = '0';
+            esc[3] = '0';
+            esc[4] = lut[ch >> 4];
+            esc[5] = lut[ch & 0xF];
+            len = 6;
+        }
+        spool_str(w, esc, len, 0);
 
+        /* cut off inside the escape, it is written again in full */
+        if (before_skip < (fs_size)len && writer_full(w) 
+        && before_skip + (fs_size)(w->bufptr - before) < (fs_size)len)
+        {
+            writer_mark(w, before_ret, done);
+            w->cut = 1;
+            return;
+        }
+        done += 1;
+    }
+}
 
 
+/* width is applied to the escaped string, measured with a dry run when right aligned.
+ * a resumed conversion starts at its mark, the end of the padding
+ * is marked too so that it is measured once */
+static void print_escaped(fs_writer *w, 
+    const char *str, fs_size limit, int minw, unsigned int flags)
+{
+    int c_mode = (flags & ALTERNATE_FORM) != 0;
+    fs_writer dry;
+    fs_size start = w->ret;
+    fs_size done, pad = 0;
 
+    if (!writer_resume(w, &done) && minw > 0 && !(flags & PAD_RIGHT))
+    {
+        if (w->resume_ret > w->ret)
+            pad = w->resume_ret - w->ret; /* cut off inside the padding */
+        else
+        {
+            writer_init(&dry, NULL, 0);
+            escape_str(&dry, str, 0, limit, c_mode, flags);
+            if (dry.ret < (fs_size)minw)
+                pad = minw - dry.ret;
+        }
+        writer_mark(w, w->ret + pad, 0);
+        fs_writer_pad(w, ' ', pad);
+        start = w->ret;
+    }
 
-#ifdef SNPRINTF_TEST
+    escape_str(w, str, done, limit, c_mode, flags);
 
+    if ((flags & PAD_RIGHT) && w->ret - start < (fs_size)minw)
+        fs_writer_pad(w, ' ', minw - (w->ret - start));
+}
+#endif /* FS_NO_ESCAPE */
 
 
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
 
+int fs_writer_full(fs_writer *w)
+{
+    if (!writer_full(w))
+        return 0;
+    w->cut = 1; /* the caller had more to write */
+    return 1;
+}
 
 
-#ifndef FS_C99
-#  error "at least C99 is required for testing code"
-#endif /* FS_C99 */
+#ifndef FS_NO_LAZY
+/* right aligned width runs the producer twice, once to measure.
+ * a producer that stops early because fs_writer_full() sets w->cut,
+ * so the string is only cut off if it had more to write */
+static void print_lazy(fs_writer *w, const fs_lazy *lazy, int minw, unsigned int flags)
+{
+    fs_writer dry;
+    fs_size start;
 
+    /* the width alone is output that does not fit, no need to produce it */
+    if (minw > 0 && writer_full(w))
+    {
+        w->cut = 1;
+        return;
+    }
 
+    if (minw > 0 && !(flags & PAD_RIGHT))
+    {
+        writer_init(&dry, NULL, 0);
+        lazy->produce(&dry, lazy->ctx);
+        if (dry.ret < (fs_size)minw)
+            fs_writer_pad(w, ' ', minw - dry.ret);
+    }
 
+    start = w->ret;
+    lazy->produce(w, lazy->ctx);
 
-/** do tests */
-#define DOTEST(bufsz, result, retval, ...) do { \
-    char buf[bufsz]; \
-    int r;\
-    printf("[INFO]: Now test %s\n", #__VA_ARGS__); \
-    r=fs_snprintf(buf, sizeof(buf), __VA_ARGS__); \
-    if(r != retval || strcmp(buf, result) != 0) { \
-        printf("  [ERROR]: test(%s) was '%s':%d\n", \
-                ""#bufsz", "#result", "#retval", "#__VA_ARGS__, \
-                buf, r); \
-        exit(1); \
-    } \
-    r=snprintf(buf, sizeof(buf), __VA_ARGS__); \
-    if(r != retval || strcmp(buf, result) != 0) { \
-        printf("  [WARNING]: test(%s) differs with system, '%s':%d\n", \
-                ""#bufsz", "#result", "#retval", "#__VA_ARGS__, \
-                buf, r); \
-    } \
-    printf("  test(\"%s\":%d) passed\n", buf, r); \
-} while(0);
+    if ((flags & PAD_RIGHT) && w->ret - start < (fs_size)minw)
+        fs_writer_pad(w, ' ', minw - (w->ret - start));
+}
+#endif /* FS_NO_LAZY */
 
 
 
+#ifndef FS_NO_BASE64
+#define BASE64_CHUNK 256 /* characters encoded at a time when it does not all fit */
 
-/** test program */
-int main(void)
+/* writes n bytes of src in base64 with '=' padding */
+static void base64_str(fs_writer *w, const unsigned char *src, fs_size n, int url)
 {
-    /* bufsize, expectedstring, expectedretval, snprintf arguments */
-    DOTEST(1024, "hello", 5, "hello");
-    DOTEST(1024, "h", 1, "h");
-    /* warning from gcc for format string, but it does work
-     *   * DOTEST(1024, "", 0, ""); */
-
-    DOTEST(3, "he", 5, "hello");
-    DOTEST(1, "", 7, "%d", 7823089);
+    const char *lut = url ? s_base64_url : s_base64;
+    char chunk[BASE64_CHUNK];
+    fs_size whole = n / 3 * 3;
+    fs_size len = whole / 3 * 4;
+    fs_size done, count;
+    unsigned long group;
+
+    /* straight into the buffer when all of it fits */
+    if (!w->skip && writer_room(w, len) == len)
+    {
+        kernels()->base64(w->bufptr, src, whole, url);
+        w->bufptr += len;
+        w->left -= len;
+        w->ret += len;
+        done = whole;
+    }
+    else
+    {
+        /* a resumed conversion jumps over the groups it already wrote */
+        done = w->skip / 4 < whole / 3 ? w->skip / 4 * 3 : whole;
+        w->skip -= done / 3 * 4;
+        w->ret += done / 3 * 4;
+    }
+    for (; done < whole; done += count)
+    {
+        /* the rest is only counted once the buffer is full */
+        if (!w->skip && 0 == writer_room(w, 1))
+        {
+            w->ret += (whole - done) / 3 * 4;
+            break;
+        }
+        count = whole - done;
+        if (count > BASE64_CHUNK / 4 * 3)
+            count = BASE64_CHUNK / 4 * 3;
+        kernels()->base64(chunk, src + done, count, url);
+        spool_str(w, chunk, (int)(count / 3 * 4), 0);
+    }
 
-    /* test positive numbers */
-    DOTEST(1024, "0", 1, "%d", 0);
-    DOTEST(1024, "1", 1, "%d", 1);
-    DOTEST(1024, "9", 1, "%d", 9);
-    DOTEST(1024, "15", 2, "%d", 15);
-    DOTEST(1024, "ab15cd", 6, "ab%dcd", 15);
-    DOTEST(1024, "167", 3, "%d", 167);
-    DOTEST(1024, "7823089", 7, "%d", 7823089);
-    DOTEST(1024, " 12", 3, "%3d", 12);
-    DOTEST(1024, "012", 3, "%.3d", 12);
-    DOTEST(1024, "012", 3, "%3.3d", 12);
-    DOTEST(1024, "012", 3, "%03d", 12);
-    DOTEST(1024, " 012", 4, "%4.3d", 12);
-    DOTEST(1024, "", 0, "%.0d", 0);
+    if (n > whole)
+    {
+        group = (unsigned long)src[whole] << 16;
+        if (n - whole == 2)
+            group |= (unsigned long)src[whole + 1] << 8;
+        chunk[0] = lut[group >> 18];
+        chunk[1] = lut[(group >> 12) & 0x3F];
+        chunk[2] = (n - whole == 2) ? lut[(group >> 6) & 0x3F] : '=';
+        chunk[3] = '=';
+        spool_str(w, chunk, 4, 0);
+    }
+}
 
-    /* test negative numbers */
-    DOTEST(1024, "-1", 2, "%d", -1);
-    DOTEST(1024, "-12", 3, "%3d", -12);
-    DOTEST(1024, " -2", 3, "%3d", -2);
-    DOTEST(1024, "-012", 4, "%.3d", -12);
-    DOTEST(1024, "-012", 4, "%3.3d", -12);
-    DOTEST(1024, "-012", 4, "%4.3d", -12);
-    DOTEST(1024, " -012", 5, "%5.3d", -12);
-    DOTEST(1024, "-12", 3, "%03d", -12);
-    DOTEST(1024, "-02", 3, "%03d", -2);
-    DOTEST(1024, "-15", 3, "%d", -15);
-    DOTEST(1024, "-7307", 5, "%d", -7307);
-    DOTEST(1024, "-12  ", 5, "%-5d", -12);
-    DOTEST(1024, "-00012", 6, "%-.5d", -12);
 
-    /* test + and space flags */
-    DOTEST(1024, "+12", 3, "%+d", 12);
-    DOTEST(1024, " 12", 3, "% d", 12);
+static void print_base64(fs_writer *w, 
+    const void *src, fs_size n, int minw, unsigned int flags)
+{
+    fs_size len = (n + 2) / 3 * 4;
 
-    /* test %u */
-    DOTEST(1024, "12", 2, "%u", 12);
-    DOTEST(1024, "0", 1, "%u", 0);
-    DOTEST(1024, "4294967295", 10, "%u", 0xffffffff);
+    if ((fs_size)minw > len && !(flags & PAD_RIGHT))
+        fs_writer_pad(w, ' ', minw - len);
+    base64_str(w, (const unsigned char *)src, n, (flags & ALTERNATE_FORM) != 0);
+    if ((fs_size)minw > len && (flags & PAD_RIGHT))
+        fs_writer_pad(w, ' ', minw - len);
+}
+#endif /* FS_NO_BASE64 */
 
-    /* test %x */
-    DOTEST(1024, "0", 1, "%x", 0);
-    DOTEST(1024, "c", 1, "%x", 12);
-    DOTEST(1024, "12ab34cd", 8, "%x", 0x12ab34cd);
-    DOTEST(1024, "ABCD", 4, "%X", 0xABCD);
-    DOTEST(1024, "0XABCD", 6, "%#X", 0xABCD);
 
 
-    /* test %llu, %lld */
-    DOTEST(1024, "18446744073709551615", 20, "%llu",
-            (long long)0xffffffffffffffff);
-    DOTEST(1024, "-9223372036854775808", 20, "%lld",
-            (long long)0x8000000000000000);
-    DOTEST(1024, "9223372036854775808", 19, "%llu",
-            (long long)0x8000000000000000);
+/* reads the variable width, precision and the argument of a conversion */
+static void fetch_arg(fs_internal_conv *conv, va_list *ap)
+{
+    fs_internal_conv_spec *spec = &conv->spec;
+    fs_internal_conv_arg *arg = &conv->arg;
 
-    /* test %s */
-    DOTEST(1024, "hello", 5, "%s", "hello");
-    DOTEST(1024, "     hello", 10, "%10s", "hello");
-    DOTEST(1024, "hello     ", 10, "%-10s", "hello");
-    DOTEST(1024, "he", 2, "%.2s", "hello");
-    DOTEST(1024, "  he", 4, "%4.2s", "hello");
-    DOTEST(1024, "   h", 4, "%4.2s", "h");
+    if (spec->flags & WIDTH_FROM_ARG)
+    {
+        spec->minw = va_arg(*ap, int);
+        if (spec->minw < 0)
+        {
+            spec->flags |= PAD_RIGHT;
+            spec->minw = -spec->minw;
+        }
+    }
+    if (spec->flags & PRECISION_FROM_ARG)
+    {
+        spec->precision = va_arg(*ap, int);
+        if (spec->precision < 0)
+        {
+            spec->flags |= PAD_RIGHT;
+            spec->precision = 0;
+        }
+    }
+    spec->flags &= ~(WIDTH_FROM_ARG | PRECISION_FROM_ARG);
 
-    /* test %c */
-    DOTEST(1024, "a", 1, "%c", 'a');
-    /* warning from gcc for format string, but it does work
-     *     DOTEST(1024, "    a", 5, "%5c", 'a');
-     *         DOTEST(1024, "a", 1, "%.0c", 'a'); */
 
-    /* test %n */
+    switch (spec->conv)
     {
-        const char *expect = "hello  ";
-        char buf[1024];
-        int fs_x, x, fs_ret, ret;
+    case 'i':
+    case 'd':
+        if (spec->l_count == 0)
+            arg->ld = va_arg(*ap, int);
+#ifdef FS_64BIT_DEFINED
+        else if (spec->l_count == 2)
+            arg->lld = va_arg(*ap, long long);
+#endif /* FS_64BIT_DEFINED */
+        else
+            arg->ld = va_arg(*ap, long);
+        break;
 
-        printf("[INFO]: Now test %%n\n");
-        fs_ret = fs_snprintf(buf, sizeof buf, "hello  %n", &fs_x);
-        if (strcmp(buf, expect) != 0)
-        {
-            printf("  [ERROR]: mismatched strings: (fs:'%s' != expect:'%s')\n", buf, expect);
-            exit(1);
-        }
-        ret = snprintf(buf, sizeof buf, "hello  %n", &x);
-        if (ret != fs_ret)
+    case 'u':
+    case 'x':
+        if (spec->l_count == 0)
+            arg->lu = va_arg(*ap, unsigned int);
+#ifdef FS_64BIT_DEFINED
+        else if (spec->l_count == 2)
+            arg->llu = va_arg(*ap, unsigned long long);
+#endif /* FS_64BIT_DEFINED */
+        else if (spec->l_count == 1)
+            arg->lu = va_arg(*ap, unsigned long);
+        break;
+
+    case 's':
+    case 'q':
+        arg->str.s = va_arg(*ap, const char *);
+        arg->str.len = -1;
+        break;
+
+    case 'v':
+        if (spec->flags & ALTERNATE_FORM)
         {
-            printf("  [ERROR]: mismatched return value (fs:%d != std:%d)\n", fs_ret, ret);
-            exit(1);
+            const fs_slice *slice = va_arg(*ap, const fs_slice *);
+            arg->str.s = slice->ptr;
+            arg->str.len = (long)slice->len;
         }
-        if (fs_x != x)
+        else
         {
-            printf("  [ERROR]: '%%n' failed: (fs:%d != std:%d)", fs_x, x);
-            exit(1);
+            arg->str.len = (long)va_arg(*ap, fs_size);
+            arg->str.s = va_arg(*ap, const char *);
         }
-        printf("  test %%n passed\n");
-    }
+        if ((spec->flags & PRECISION_PROVIDED) && arg->str.len > spec->precision)
+            arg->str.len = spec->precision;
+        break;
+
+    case 'r':
+        arg->str.len = (long)va_arg(*ap, fs_size);
+        arg->str.s = (const char *)va_arg(*ap, const void *);
+        if ((spec->flags & PRECISION_PROVIDED) && arg->str.len > spec->precision)
+            arg->str.len = spec->precision;
+        break;
 
-    /* test %m */
 #ifndef FREESTANDING_TRULY
-#  ifdef __GNUC__
-    errno = 0;
-    {
-        const char *es = strerror(errno);
-        DOTEST(1024, es, strlen(es), "%m");
+    case 'm':
+        arg->str.s = strerror(errno);
+        arg->str.len = -1;
+        break;
+#endif /* !FREESTANDING_TRULY */
+
+    case 'k':
+        if (spec->l_count == 0)
+            arg->time.sec = va_arg(*ap, int);
+#ifdef FS_64BIT_DEFINED
+        else if (spec->l_count == 2)
+            arg->time.sec = va_arg(*ap, long long);
+#endif /* FS_64BIT_DEFINED */
+        else
+            arg->time.sec = va_arg(*ap, long);
+        arg->time.usec = va_arg(*ap, long);
+        break;
+
+    case 'j':
+        if (spec->l_count == 0)
+            arg->fixed.value = va_arg(*ap, int);
+#ifdef FS_64BIT_DEFINED
+        else if (spec->l_count == 2)
+            arg->fixed.value = va_arg(*ap, long long);
+#endif /* FS_64BIT_DEFINED */
+        else
+            arg->fixed.value = va_arg(*ap, long);
+        arg->fixed.scale = va_arg(*ap, int);
+        break;
+
+    case 'c': arg->chr = va_arg(*ap, int); break;
+    case '%': arg->chr = '%'; break;
+    case 'p': 
+    case 'y':
+    case CONV_IP4:
+    case CONV_IP6:
+        arg->ptr = va_arg(*ap, const void *); 
+        break;
+    case 'n': arg->n = va_arg(*ap, int *); break;
+
+    case 'f':
+    case 'g':
+        if (spec->l_count)
+            arg->lf = va_arg(*ap, long double);
+        else
+            arg->f = va_arg(*ap, double);
+        break;
+
+#ifndef FS_NO_CUSTOM
+    default:
+        if (NULL != find_custom_conv(spec->conv))
+            arg->ptr = va_arg(*ap, const void *);
+        break;
+#endif /* FS_NO_CUSTOM */
+    case 0: break;
     }
+}
+
+
+
+#ifdef FS_STATS
+/* per conversion and per format counters, see fs_snprintf.h */
+
+#ifndef FS_STATS_CLOCK
+#  if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#    define FS_STATS_CLOCK() stats_rdtsc()
+
+static fs_stats_count stats_rdtsc(void)
+{
+    fs_u32 lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+    return (fs_stats_count)hi << 16 << 16 | lo;
+}
+
+#  else
+#    define FS_STATS_CLOCK() 0
 #  endif
-#endif
+#endif /* FS_STATS_CLOCK */
 
-    /* test %p */
-    DOTEST(1024, "0x10", 4, "%p", (void*)0x10);
-    DOTEST(1024, "(nil)", 5, "%p", (void*)0x0);
+/* counters are only ever added to, nothing is ordered by them */
+#ifdef FS_ATOMICS
+#  define STATS_ADD(counter, n) __atomic_fetch_add(&(counter), (fs_stats_count)(n), __ATOMIC_RELAXED)
+#  define STATS_LOAD(counter) __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+#  define STATS_STORE(counter, n) __atomic_store_n(&(counter), (n), __ATOMIC_RELAXED)
+#else
+#  define STATS_ADD(counter, n) ((counter) += (fs_stats_count)(n))
+#  define STATS_LOAD(counter) (counter)
+#  define STATS_STORE(counter, n) ((counter) = (n))
+#endif /* FS_ATOMICS */
 
-    /* test %% */
-    DOTEST(1024, "%", 1, "%%");
+static fs_stats s_stats;
 
-    /* test %f */
-    DOTEST(1024, "0.000000", 8, "%f", 0.0);
-    DOTEST(1024, "0.00", 4, "%.2f", 0.0);
-    /* differs, "-0.00" DOTEST(1024, "0.00", 4, "%.2f", -0.0); */
-    DOTEST(1024, "234.00", 6, "%.2f", 234.005);
-    DOTEST(1024, "8973497.1246", 12, "%.4f", 8973497.12456);
-    DOTEST(1024, "-12.000000", 10, "%f", -12.0);
-    DOTEST(1024, "6", 1, "%.0f", 6.0);
 
-    DOTEST(1024, "6", 1, "%g", 6.0);
-    DOTEST(1024, "6.1", 3, "%g", 6.1);
-    DOTEST(1024, "6.15", 4, "%g", 6.15);
+/* the writer as a conversion or a format found it */
+typedef struct fs_stats_mark
+{
+    const char *fmt;
+    const char *bufptr;
+    fs_size ret;
+    fs_size skip;
+    fs_stats_count start;
+} fs_stats_mark;
 
-    /* These format strings are from the code of NSD, Unbound, ldns */
 
-    DOTEST(1024, "abcdef", 6, "%s", "abcdef");
-    DOTEST(1024, "005", 3, "%03u", 5);
-    DOTEST(1024, "12345", 5, "%03u", 12345);
-    DOTEST(1024, "5", 1, "%d", 5);
-    DOTEST(1024, "(nil)", 5, "%p", NULL);
-    DOTEST(1024, "12345", 5, "%ld", (long)12345);
-    DOTEST(1024, "12345", 5, "%lu", (long)12345);
-    DOTEST(1024, "       12345", 12, "%12u", (unsigned)12345);
-    DOTEST(1024, "12345", 5, "%u", (unsigned)12345);
-    DOTEST(1024, "12345", 5, "%llu", (unsigned long long)12345);
-    DOTEST(1024, "12345", 5, "%x", 0x12345);
-    DOTEST(1024, "12345", 5, "%llx", (long long)0x12345);
-    DOTEST(1024, "012345", 6, "%6.6d", 12345);
-    DOTEST(1024, "012345", 6, "%6.6u", 12345);
-    DOTEST(1024, "1234.54", 7, "%g", 1234.54);
-    DOTEST(1024, "123456789.54", 12, "%.12g", 123456789.54);
-    DOTEST(1024, "3456789123456.54", 16, "%.16g", 3456789123456.54);
-    /* %24g does not work with 24 digits, not enough accuracy,
-     *   * the first 16 digits are correct */
-    DOTEST(1024, "12345", 5, "%3.3d", 12345);
+static void stats_begin(fs_stats_mark *mark, const fs_writer *w, const char *fmt)
+{
+    mark->fmt = fmt;
+    mark->bufptr = w->bufptr;
+    mark->ret = w->ret;
+    mark->skip = w->skip;
+    mark->start = FS_STATS_CLOCK();
+}
+
+
+/* fewer bytes reached the buffer than were printed, 
+ * besides those fs_format_resume skipped and those the iov references */
+static int stats_lost(const fs_stats_mark *mark, const fs_writer *w)
+{
+    fs_size kept = (fs_size)(w->bufptr - mark->bufptr) + (mark->skip - w->skip);
+    return NULL == w->iov && kept < w->ret - mark->ret;
+}
+
+
+/* the histogram bucket of a call, see fs_snprintf.h */
+static int stats_bucket(fs_stats_count cycles)
+{
+    int bucket = 0;
+
+    cycles >>= 5;
+    while (cycles && bucket < FS_STATS_BUCKETS - 1)
+    {
+        cycles >>= 1;
+        bucket += 1;
+    }
+    return bucket;
+}
+
+
+static void stats_add(fs_stats_entry *entry, 
+    const fs_stats_mark *mark, const fs_writer *w, int truncated)
+{
+    fs_stats_count cycles = FS_STATS_CLOCK() - mark->start;
+
+    STATS_ADD(entry->calls, 1);
+    STATS_ADD(entry->bytes, w->ret - mark->ret);
+    STATS_ADD(entry->truncations, 0 != truncated);
+    STATS_ADD(entry->cycles, cycles);
+    STATS_ADD(entry->histogram[stats_bucket(cycles)], 1);
+}
+
+
+static void stats_conv(const fs_stats_mark *mark, const fs_writer *w, int conv)
+{
+    int index;
+
+    if ('a' <= conv && conv <= 'z')
+        index = conv - 'a';
+    else if ('%' == conv)
+        index = FS_STATS_PERCENT;
+    else if (CONV_IP4 == conv)
+        index = FS_STATS_IP4;
+    else if (CONV_IP6 == conv)
+        index = FS_STATS_IP6;
+    else
+        return; /* a '%' at the end of the format */
+    stats_add(&s_stats.conv[index], mark, w, stats_lost(mark, w));
+}
+
+
+/* the slot of fmt, claimed on its first use */
+static fs_stats_entry *stats_format_entry(const char *fmt)
+{
+    uintptr_t addr = (uintptr_t)fmt;
+    unsigned int i = (unsigned int)((addr >> 4) ^ (addr >> 12));
+    unsigned int probe;
+    const char *seen;
+
+    for (probe = 0; probe < FS_STATS_FORMATS; probe += 1, i += 1)
+    {
+        i &= FS_STATS_FORMATS - 1;
+        seen = STATS_LOAD(s_stats.formats[i].fmt);
+#ifdef FS_ATOMICS
+        if (NULL == seen)
+            __atomic_compare_exchange_n(&s_stats.formats[i].fmt, &seen, fmt, 0, 
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+#else
+        if (NULL == seen)
+            s_stats.formats[i].fmt = seen = fmt;
+#endif /* FS_ATOMICS */
+        if (NULL == seen || fmt == seen)
+            return &s_stats.formats[i].stats;
+    }
+    return &s_stats.other_formats;
+}
+
+
+static void stats_format(const fs_stats_mark *mark, const fs_writer *w, int truncated)
+{
+    stats_add(stats_format_entry(mark->fmt), mark, w, truncated);
+}
+
+
+static void stats_copy(fs_stats_entry *dst, const fs_stats_entry *src)
+{
+    int i;
+
+    dst->calls = STATS_LOAD(src->calls);
+    dst->bytes = STATS_LOAD(src->bytes);
+    dst->truncations = STATS_LOAD(src->truncations);
+    dst->cycles = STATS_LOAD(src->cycles);
+    for (i = 0; i < FS_STATS_BUCKETS; i += 1)
+        dst->histogram[i] = STATS_LOAD(src->histogram[i]);
+}
+
+
+static void stats_clear(fs_stats_entry *entry)
+{
+    int i;
+
+    STATS_STORE(entry->calls, 0);
+    STATS_STORE(entry->bytes, 0);
+    STATS_STORE(entry->truncations, 0);
+    STATS_STORE(entry->cycles, 0);
+    for (i = 0; i < FS_STATS_BUCKETS; i += 1)
+        STATS_STORE(entry->histogram[i], 0);
+}
+
+
+void fs_stats_snapshot(fs_stats *out)
+{
+    int i;
+
+    for (i = 0; i < FS_STATS_CONVS; i += 1)
+        stats_copy(&out->conv[i], &s_stats.conv[i]);
+    for (i = 0; i < FS_STATS_FORMATS; i += 1)
+    {
+        out->formats[i].fmt = STATS_LOAD(s_stats.formats[i].fmt);
+        stats_copy(&out->formats[i].stats, &s_stats.formats[i].stats);
+    }
+    stats_copy(&out->other_formats, &s_stats.other_formats);
+}
+
+
+void fs_stats_reset(void)
+{
+    int i;
+
+    for (i = 0; i < FS_STATS_CONVS; i += 1)
+        stats_clear(&s_stats.conv[i]);
+    for (i = 0; i < FS_STATS_FORMATS; i += 1)
+    {
+        STATS_STORE(s_stats.formats[i].fmt, NULL);
+        stats_clear(&s_stats.formats[i].stats);
+    }
+    stats_clear(&s_stats.other_formats);
+}
+
+#endif /* FS_STATS */
+
+
+
+static void print_conv(fs_writer *w, fs_internal_conv *conv)
+{
+    const fs_internal_conv_spec *spec = &conv->spec;
+    fs_internal_conv_arg *arg = &conv->arg;
+    int minw = spec->minw;
+    int precision = spec->precision;
+    unsigned int flags = spec->flags;
+#ifdef FS_STATS
+    fs_stats_mark mark;
+    stats_begin(&mark, w, NULL);
+#endif /* FS_STATS */
+
+    switch (spec->conv)
+    {
+    case 'i':
+    case 'd':
+#ifdef FS_64BIT_DEFINED
+        if (spec->l_count == 2)
+            print_num_lld(w, arg->lld, minw, precision, flags);
+        else
+#endif /* FS_64BIT_DEFINED */
+            print_num_ld(w, arg->ld, minw, precision, flags);
+        break;
+
+
+    case 'u':
+        if (spec->l_count == 0 || spec->l_count == 1)
+            print_num_lu(w, arg->lu, minw, precision, flags);
+#ifdef FS_64BIT_DEFINED
+        else if (spec->l_count == 2)
+            print_num_llu(w, arg->llu, minw, precision, flags);
+#endif /* FS_64BIT_DEFINED */
+        break;
+
+
+    case 'x':
+        if (spec->l_count == 0 || spec->l_count == 1)
+            print_num_lx(w, arg->lu, minw, precision, flags);
+#ifdef FS_64BIT_DEFINED
+        else if (spec->l_count == 2)
+            print_num_llx(w, arg->llu, minw, precision, flags);
+#endif /* FS_64BIT_DEFINED */
+        break;
+
+
+#ifndef FREESTANDING_TRULY
+    case 'm':
+#endif /* !FREESTANDING_TRULY */
+    case 's':
+#ifndef FS_NO_SLICE
+    case 'v':
+#endif /* FS_NO_SLICE */
+        /* measured once, a resumed conversion does not walk the string again */
+        if (arg->str.len < 0)
+            arg->str.len = str_width(arg->str.s, precision, flags);
+#ifndef FS_NO_IOV
+        if (NULL != w->iov && 'm' != spec->conv 
+        && iov_ref_str(w, arg->str.s, arg->str.len, minw, flags))
+            break;
+#endif /* FS_NO_IOV */
+        print_strn(w, arg->str.s, arg->str.len, minw, flags);
+        break;
+
+#ifndef FS_NO_BASE64
+    case 'r':
+        print_base64(w, arg->str.s, (fs_size)arg->str.len, minw, flags);
+        break;
+#endif /* FS_NO_BASE64 */
+
+#ifndef FS_NO_LAZY
+    case 'y':
+        print_lazy(w, (const fs_lazy *)arg->ptr, minw, flags);
+        break;
+#endif /* FS_NO_LAZY */
+
+#ifndef FS_NO_ESCAPE
+    case 'q':
+        print_escaped(w, arg->str.s, 
+            (flags & PRECISION_PROVIDED) ? (fs_size)precision : (fs_size)-1, 
+            minw, flags);
+        break;
+#endif /* FS_NO_ESCAPE */
+
+
+    case 'c':
+    case '%':
+        print_chr(w, (char)arg->chr, minw, flags);
+        break;
+
+#ifndef FS_NO_PTR
+    case 'p':
+        print_ptr(w, arg->ptr, minw, precision, flags);
+        break;
+#endif /* FS_NO_PTR */
+
+#ifndef FS_NO_IPADDR
+    case CONV_IP4:
+    case CONV_IP6:
+        print_ip(w, arg->ptr, spec->conv, minw, flags);
+        break;
+#endif /* FS_NO_IPADDR */
+
+#ifndef FS_NO_TIMESTAMP
+    case 'k':
+        print_timestamp(w, arg->time.sec, arg->time.usec, minw, precision, flags);
+        break;
+#endif /* FS_NO_TIMESTAMP */
+
+#ifndef FS_NO_FIXED
+    case 'j':
+        print_fixed(w, arg->fixed.value, arg->fixed.scale, minw, precision, flags);
+        break;
+#endif /* FS_NO_FIXED */
+
+    case 'n':
+        *arg->n = (int)w->ret;
+        break;
+
+#ifndef FS_NO_FLOAT
+    case 'f':
+        if (spec->l_count)
+            print_num_lf(w, arg->lf, minw, precision, flags);
+        else
+            print_num_f(w, arg->f, minw, precision, flags);
+        break;
+
+    case 'g': 
+        if (spec->l_count)
+            print_num_lg(w, arg->lf, minw, precision, flags);
+        else
+            print_num_g(w, arg->f, minw, precision, flags);
+        break;
+#endif /* FS_NO_FLOAT */
+
+
+#ifndef FS_NO_CUSTOM
+    default: 
+        if (NULL != find_custom_conv(spec->conv))
+            print_custom(w, conv);
+        break;
+#endif /* FS_NO_CUSTOM */
+    case 0: break;
+    }
+#ifdef FS_STATS
+    stats_conv(&mark, w, spec->conv);
+#endif /* FS_STATS */
+}
+
+
+
+/* formats from *pfmt until the end of the format string,
+ * or, if w->stop is set, until something does not fit.
+ * when stopped in a literal, *pfmt points to its first unwritten character,
+ * when stopped in a conversion, *pfmt points past it, 
+ * conv holds the conversion and *conv_done is how much of it was written */
+static int format_loop(fs_writer *w, const char **pfmt, va_list *ap,
+    fs_internal_conv *conv, fs_size *conv_done)
+{
+    const char *fmtptr = *pfmt;
+    const char *literal;
+    char *start;
+    fs_size start_ret;
+
+    for (;;)
+    {
+        /* copy raw string */
+        literal = fmtptr;
+        if (*fmtptr && '%' != *fmtptr)
+            fmtptr = kernels()->find_conv(fmtptr + 1);
+
+        if (literal != fmtptr)
+        {
+            start = w->bufptr;
+            spool_str(w, literal, (int)(fmtptr - literal), 0);
+            if (w->stop && (w->bufptr - start) < (fmtptr - literal))
+            {
+                *pfmt = literal + (w->bufptr - start);
+                return FORMAT_STOP_LITERAL;
+            }
+        }
+
+        if (0 == *fmtptr) break; /* null character */
+
+        fmtptr = parse_spec(fmtptr + 1, &conv->spec);
+        fetch_arg(conv, ap);
+
+        start = w->bufptr;
+        start_ret = w->ret;
+        w->cut = 0;
+        w->resume_ret = 0;
+        print_conv(w, conv);
+        if (w->stop && (w->cut || (fs_size)(w->bufptr - start) < w->ret - start_ret))
+        {
+            *pfmt = fmtptr;
+            *conv_done = w->bufptr - start;
+            return FORMAT_STOP_CONV;
+        }
+    }
+
+    *pfmt = fmtptr;
+    return FORMAT_DONE;
+}
+
+
+
+
+
+#ifdef FS_FORMAT_CACHE
+/*
+ * compiled format cache, opt-in with -DFS_FORMAT_CACHE.
+ * maps a format pointer to its parsed specs, so the same format 
+ * is not scanned and parsed again on every call. the ops are replayed 
+ * straight from the cache, after checking that the format has the same 
+ * length, and for each op, that it still has a '%' and the same conversion 
+ * letter where its spec was, which costs much less than the parse. 
+ * a format rewritten in place is a miss or goes on with the parser from 
+ * the first op that does not match, and is compiled again, but a rewrite 
+ * that keeps all of these, like "%5d" to "%6d", is not noticed, so 
+ * formats should still have a stable address and text (string literals).
+ * each slot is guarded by a sequence lock, a reader that races 
+ * with a writer parses the rest of the format itself.
+ */
+
+#ifndef FS_ATOMICS
+#  error "FS_FORMAT_CACHE needs the __atomic builtins"
+#endif
+
+#ifndef FS_FORMAT_CACHE_SLOTS
+#  define FS_FORMAT_CACHE_SLOTS 64 /* must be a power of 2 */
+#endif
+#ifndef FS_FORMAT_CACHE_OPS
+#  define FS_FORMAT_CACHE_OPS 16 /* formats with more conversions are not cached */
+#endif
+
+/* format_cached results */
+#define FORMAT_CACHE_HIT        0
+#define FORMAT_CACHE_MISS       1 /* compile the format again */
+#define FORMAT_CACHE_SKIP       2 /* not cached, or raced with a writer */
+
+
+/* a literal followed by a conversion spec, 
+ * the last op of a format has a spec_len of 0 */
+typedef struct fs_format_op
+{
+    unsigned int literal_len;
+    unsigned int spec_len; /* including the '%' */
+    int letter; /* the last character of the spec */
+    fs_internal_conv_spec spec;
+} fs_format_op;
+
+/* a count of 0 marks a format that could not be cached, 
+ * so it is not compiled again on every call */
+typedef struct fs_format_entry
+{
+    const char *fmt;
+    fs_size length;
+    unsigned int count;
+    fs_format_op ops[FS_FORMAT_CACHE_OPS];
+} fs_format_entry;
+
+static struct {
+    unsigned long seq;
+    fs_format_entry entry;
+} s_format_cache[FS_FORMAT_CACHE_SLOTS];
+
+
+
+static unsigned int format_cache_index(const char *fmt)
+{
+    uintptr_t addr = (uintptr_t)fmt;
+    return (unsigned int)((addr >> 4) ^ (addr >> 12)) & (FS_FORMAT_CACHE_SLOTS - 1);
+}
+
+
+static void format_cache_store(const fs_format_entry *entry)
+{
+    unsigned int i = format_cache_index(entry->fmt);
+    fs_format_entry *slot = &s_format_cache[i].entry;
+    unsigned long seq;
+    unsigned int k;
+
+    /* another thread is writing this slot, leave it to them */
+    if (!seq_write_begin(&s_format_cache[i].seq, &seq))
+        return;
+
+    slot->fmt = entry->fmt;
+    slot->length = entry->length;
+    slot->count = entry->count;
+    for (k = 0; k < entry->count; k += 1)
+        slot->ops[k] = entry->ops[k];
+
+    seq_write_end(&s_format_cache[i].seq, seq);
+}
+
+
+/* parses fmt and stores it, with a count of 0 if it has too many conversions to be cached */
+static void format_compile(const char *fmt)
+{
+    fs_format_entry entry;
+    const char *fmtptr = fmt;
+    const char *start;
+    fs_format_op *op;
+    unsigned int count = 0;
+
+    entry.fmt = fmt;
+    entry.count = 0;
+    for (;;)
+    {
+        if (FS_FORMAT_CACHE_OPS == count)
+        {
+            entry.length = kernels()->strnlen(fmt, (fs_size)-1);
+            format_cache_store(&entry);
+            return;
+        }
+        op = &entry.ops[count];
+        count += 1;
+
+        start = fmtptr;
+        while (*fmtptr && '%' != *fmtptr)
+            fmtptr += 1;
+        op->literal_len = (unsigned int)(fmtptr - start);
+
+        if (0 == *fmtptr)
+        {
+            op->spec_len = 0;
+            op->letter = 0;
+            break;
+        }
+        start = fmtptr;
+        fmtptr = parse_spec(fmtptr + 1, &op->spec);
+        op->spec_len = (unsigned int)(fmtptr - start);
+        op->letter = fmtptr[-1];
+    }
+
+    entry.length = (fs_size)(fmtptr - fmt);
+    entry.count = count;
+    format_cache_store(&entry);
+}
+
+
+/* 
+ * formats *pfmt from the cache, 
+ * unless it returns FORMAT_CACHE_HIT, *pfmt is where format_loop 
+ * has to go on from, everything before it was written 
+ */
+static int format_cached(fs_writer *w, const char **pfmt, va_list *ap)
+{
+    const char *fmtptr = *pfmt;
+    unsigned int i = format_cache_index(fmtptr);
+    unsigned long *seq = &s_format_cache[i].seq;
+    unsigned long start = seq_read_begin(seq);
+    const fs_format_entry *slot = &s_format_cache[i].entry;
+    const fs_format_op *op = slot->ops;
+    fs_internal_conv conv;
+    unsigned int count = slot->count;
+    unsigned int literal_len, spec_len;
+    int letter;
+
+    if (slot->fmt != fmtptr || count > FS_FORMAT_CACHE_OPS
+    || kernels()->strnlen(fmtptr, slot->length + 1) != slot->length)
+        return FORMAT_CACHE_MISS;
+    if (0 == count)
+        return seq_read_end(seq, start) ? FORMAT_CACHE_SKIP : FORMAT_CACHE_MISS;
+
+    for (; count; count -= 1, op += 1)
+    {
+        literal_len = op->literal_len;
+        spec_len = op->spec_len;
+        letter = op->letter;
+        conv.spec = op->spec;
+
+        /* nothing of this op is written until the format and the slot are checked */
+        if (0 == spec_len ? 0 != fmtptr[literal_len]
+            : '%' != fmtptr[literal_len] || letter != fmtptr[literal_len + spec_len - 1])
+            break;
+        if (!seq_read_end(seq, start))
+        {
+            *pfmt = fmtptr;
+            return FORMAT_CACHE_SKIP;
+        }
+
+        if (literal_len)
+            spool_str(w, fmtptr, (int)literal_len, 0);
+        if (0 == spec_len)
+            return FORMAT_CACHE_HIT;
+        fmtptr += literal_len + spec_len;
+
+        fetch_arg(&conv, ap);
+        print_conv(w, &conv);
+    }
+
+    *pfmt = fmtptr;
+    return FORMAT_CACHE_MISS;
+}
+
+#endif /* FS_FORMAT_CACHE */
+
+
+
+
+
+int fs_snprintf(char *buf, fs_size bufsz, const char *fmt, ...)
+{
+    int ret;
+    va_list args;
+    va_start(args, fmt);
+    ret = fs_vsnprintf(buf, bufsz, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+int fs_vsnprintf(char *buf, fs_size bufsz, const char *fmt, va_list ap)
+{
+    return (int)fs_vsnprintf_sz(buf, bufsz, fmt, ap);
+}
+
+
+fs_size fs_snprintf_sz(char *buf, fs_size bufsz, const char *fmt, ...)
+{
+    fs_size ret;
+    va_list args;
+    va_start(args, fmt);
+    ret = fs_vsnprintf_sz(buf, bufsz, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+fs_size fs_vsnprintf_sz(char *buf, fs_size bufsz, const char *fmt, va_list ap)
+{
+    fs_writer w;
+    fs_internal_conv conv;
+    fs_size conv_done;
+    va_list args;
+#ifdef FS_FORMAT_CACHE
+    const char *rest = fmt;
+    int cache;
+#endif /* FS_FORMAT_CACHE */
+#ifdef FS_STATS
+    fs_stats_mark mark;
+#endif /* FS_STATS */
+
+    if (NULL == buf)
+        bufsz = 0;
+    writer_init(&w, buf, bufsz);
+#ifdef FS_STATS
+    stats_begin(&mark, &w, fmt);
+#endif /* FS_STATS */
+
+    FS_VA_COPY(args, ap);
+#ifdef FS_FORMAT_CACHE
+    cache = format_cached(&w, &rest, &args);
+    if (FORMAT_CACHE_HIT != cache)
+        format_loop(&w, &rest, &args, &conv, &conv_done);
+    if (FORMAT_CACHE_MISS == cache)
+        format_compile(fmt);
+#else
+    format_loop(&w, &fmt, &args, &conv, &conv_done);
+#endif /* FS_FORMAT_CACHE */
+    va_end(args);
+
+    /* left is always greater than 0 if bufsize is nonzero, 
+     * checking because snprintf can be used as 
+     * a kind of strlen for the hypothetically formatted string 
+     * when bufsize is 0 */
+    if (w.left > 0)
+        *w.bufptr = 0;
+#ifdef FS_STATS
+    stats_format(&mark, &w, w.ret >= bufsz);
+#endif /* FS_STATS */
+    return w.ret;
+}
+
+
+
+
+fs_size fs_sink_printf(fs_sink *sink, const char *fmt, ...)
+{
+    fs_size ret;
+    va_list args;
+    va_start(args, fmt);
+    ret = fs_sink_vprintf(sink, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+fs_size fs_sink_vprintf(fs_sink *sink, const char *fmt, va_list ap)
+{
+    fs_writer w;
+    fs_internal_conv conv;
+    fs_size conv_done;
+    va_list args;
+#ifdef FS_STATS
+    fs_stats_mark mark;
+#endif /* FS_STATS */
+
+    /* the sink is not null terminated, every byte of it can be used */
+    writer_init(&w, NULL, sink->size - sink->used + 1);
+    if (NULL != sink->buf)
+        w.bufptr = sink->buf + sink->used;
+    w.sink = sink;
+#ifdef FS_STATS
+    stats_begin(&mark, &w, fmt);
+#endif /* FS_STATS */
+
+    FS_VA_COPY(args, ap);
+    format_loop(&w, &fmt, &args, &conv, &conv_done);
+    va_end(args);
+
+    if (NULL != sink->buf)
+        sink->used = w.bufptr - sink->buf;
+#ifdef FS_STATS
+    stats_format(&mark, &w, stats_lost(&mark, &w));
+#endif /* FS_STATS */
+    return w.ret;
+}
+
+
+
+#ifndef FS_NO_IOV
+int fs_snprintf_iov(fs_iovec *iov, int iovcnt, 
+    char *scratch, fs_size scratchsz, const char *fmt, ...)
+{
+    va_list ap;
+    int ret;
+
+    va_start(ap, fmt);
+    ret = fs_vsnprintf_iov(iov, iovcnt, scratch, scratchsz, fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+int fs_vsnprintf_iov(fs_iovec *iov, int iovcnt, 
+    char *scratch, fs_size scratchsz, const char *fmt, va_list ap)
+{
+    fs_writer w;
+    fs_iov_state state;
+    fs_internal_conv conv;
+    fs_size conv_done;
+    fs_size written = 0;
+    va_list args;
+    int i;
+#ifdef FS_STATS
+    fs_stats_mark mark;
+#endif /* FS_STATS */
+
+    if (iovcnt < 1)
+        return -1;
+    if (NULL == scratch)
+        scratchsz = 0;
+
+    /* the scratch is not null terminated, every byte of it can be used */
+    writer_init(&w, scratch, scratchsz + 1);
+    state.iov = iov;
+    state.count = 0;
+    state.max = iovcnt;
+    state.segment = scratch;
+    w.iov = &state;
+#ifdef FS_STATS
+    stats_begin(&mark, &w, fmt);
+#endif /* FS_STATS */
+
+    FS_VA_COPY(args, ap);
+    format_loop(&w, &fmt, &args, &conv, &conv_done);
+    va_end(args);
+    iov_flush(&state, w.bufptr);
+
+    for (i = 0; i < state.count; i += 1)
+        written += iov[i].iov_len;
+#ifdef FS_STATS
+    stats_format(&mark, &w, written != w.ret);
+#endif /* FS_STATS */
+    return written == w.ret ? state.count : -1;
+}
+#endif /* FS_NO_IOV */
+
+
+
+
+#ifdef FS_MMAP_SINK
+
+static fs_size mmap_sink_pagesize(void)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    return page > 0 ? (fs_size)page : 4096;
+}
+
+
+/* maps a new window starting at the page of the next byte to be written */
+static int mmap_sink_grow(fs_sink *sink, fs_size need)
+{
+    fs_mmap_sink *m = sink->ctx;
+    fs_size page = mmap_sink_pagesize();
+    fs_size end = m->base + sink->used;
+    fs_size base = end - end % page;
+    fs_size len = m->stride;
+    void *map;
+
+    if (len < end - base + need)
+        len = (end - base + need + page - 1) / page * page;
+
+    if (0 != ftruncate(m->fd, (off_t)(base + len)))
+        return 0;
+    map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, m->fd, (off_t)base);
+    if (MAP_FAILED == map)
+        return 0;
+
+    if (NULL != sink->buf)
+        munmap(sink->buf, sink->size);
+    sink->buf = map;
+    sink->size = len;
+    sink->used = end - base;
+    m->base = base;
+    return 1;
+}
+
+
+int fs_mmap_sink_open(fs_mmap_sink *m, const char *path, fs_size stride)
+{
+    fs_size page = mmap_sink_pagesize();
+
+    m->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m->fd < 0)
+        return -1;
+
+    if (0 == stride)
+        stride = FS_MMAP_SINK_STRIDE;
+    m->stride = (stride + page - 1) / page * page;
+    m->base = 0;
+
+    /* mapped on the first write */
+    m->sink.buf = NULL;
+    m->sink.size = 0;
+    m->sink.used = 0;
+    m->sink.grow = mmap_sink_grow;
+    m->sink.ctx = m;
+    return 0;
+}
+
+
+int fs_mmap_sink_close(fs_mmap_sink *m)
+{
+    int err = 0;
+
+    if (NULL != m->sink.buf)
+        munmap(m->sink.buf, m->sink.size);
+    /* drop the unused tail of the last window */
+    if (0 != ftruncate(m->fd, (off_t)(m->base + m->sink.used)))
+        err = -1;
+    if (0 != close(m->fd))
+        err = -1;
+    m->sink.buf = NULL;
+    return err;
+}
+
+#endif /* FS_MMAP_SINK */
+
+
+
+int fs_snprintf_trunc(char *buf, fs_size bufsz, int *truncated, const char *fmt, ...)
+{
+    int ret;
+    va_list args;
+    va_start(args, fmt);
+    ret = fs_vsnprintf_trunc(buf, bufsz, truncated, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+int fs_vsnprintf_trunc(char *buf, fs_size bufsz, int *truncated, const char *fmt, va_list ap)
+{
+    fs_writer w;
+    fs_internal_conv conv;
+    fs_size conv_done;
+    va_list args;
+    int status;
+#ifdef FS_STATS
+    fs_stats_mark mark;
+#endif /* FS_STATS */
+
+    if (NULL == buf)
+        bufsz = 0;
+    writer_init(&w, buf, bufsz);
+    w.stop = 1;
+#ifdef FS_STATS
+    stats_begin(&mark, &w, fmt);
+#endif /* FS_STATS */
+
+    FS_VA_COPY(args, ap);
+    status = format_loop(&w, &fmt, &args, &conv, &conv_done);
+    va_end(args);
+
+    if (NULL != truncated)
+        *truncated = (status != FORMAT_DONE);
+    if (w.left > 0)
+        *w.bufptr = 0;
+#ifdef FS_STATS
+    stats_format(&mark, &w, status != FORMAT_DONE);
+#endif /* FS_STATS */
+    return (int)(w.bufptr - buf);
+}
+
+
+
+
+void fs_format_begin(fs_format_state *state, const char *fmt, va_list *ap)
+{
+    state->fmtptr = fmt;
+    state->ap = ap;
+    state->conv_done = 0;
+    state->resume_ret = 0;
+    state->resume_src = 0;
+    state->pending = 0;
+    state->done = 0;
+    state->ret = 0;
+}
+
+
+fs_size fs_format_resume(fs_format_state *state, char *buf, fs_size bufsz)
+{
+    fs_writer w;
+    fs_size written;
+    fs_size start_ret;
+
+    if (state->done || NULL == buf || 0 == bufsz)
+        return 0;
+
+    /* nothing is null terminated, every byte of buf can be used */
+    writer_init(&w, buf, bufsz + 1);
+    w.stop = 1;
+    w.ret = state->ret;
+
+    if (state->pending)
+    {
+        /* print the cut off conversion again, dropping the part that 
+         * was already written, %q and %r pick up from their mark */
+        w.ret -= state->conv_done;
+        w.skip = state->conv_done;
+        w.resume_ret = state->resume_ret;
+        w.resume_src = state->resume_src;
+        start_ret = w.ret;
+        print_conv(&w, &state->conv);
+
+        written = w.bufptr - buf;
+        if (w.cut || state->conv_done + written < w.ret - start_ret)
+        {
+            state->conv_done += written;
+            state->resume_ret = w.resume_ret;
+            state->resume_src = w.resume_src;
+            state->ret += written;
+            return written;
+        }
+        state->pending = 0;
+    }
+
+    switch (format_loop(&w, &state->fmtptr, state->ap, 
+        &state->conv, &state->conv_done))
+    {
+    case FORMAT_STOP_CONV: 
+        state->pending = 1; 
+        state->resume_ret = w.resume_ret;
+        state->resume_src = w.resume_src;
+        break;
+    case FORMAT_STOP_LITERAL: break;
+    default: state->done = 1; break;
+    }
+
+    written = w.bufptr - buf;
+    state->ret += written;
+    return written;
+}
+
+
+int fs_format_done(const fs_format_state *state)
+{
+    return state->done;
+}
+
+
+
+
+/* one worker's share of fs_format_parallel */
+typedef struct fs_parallel_slice
+{
+    fs_size first;
+    fs_size count;
+    fs_size offset; /* where the slice starts in the output */
+    fs_size len;
+} fs_parallel_slice;
+
+typedef struct fs_parallel_job
+{
+    const char *prefix;
+    const char *suffix;
+    int prefix_len;
+    int suffix_len;
+    fs_internal_conv_spec spec;
+    const char *array;
+    fs_size elem_size;
+    char *buf;
+    fs_size bufsz; /* excluding the null terminator */
+    fs_parallel_slice slices[FS_PARALLEL_MAX_WORKERS];
+} fs_parallel_job;
+
+
+
+/* size of an array element that the conversion takes as its argument,
+ * 0 if the conversion does not take exactly one argument */
+static fs_size arg_size(const fs_internal_conv_spec *spec)
+{
+    if (spec->flags & (WIDTH_FROM_ARG | PRECISION_FROM_ARG))
+        return 0;
+
+    switch (spec->conv)
+    {
+    case 'i':
+    case 'd':
+    case 'u':
+    case 'x':
+        if (spec->l_count == 0) return sizeof(int);
+#ifdef FS_64BIT_DEFINED
+        if (spec->l_count == 2) return sizeof(long long);
+#endif /* FS_64BIT_DEFINED */
+        return sizeof(long);
+
+    case 'f':
+    case 'g':
+        return spec->l_count ? sizeof(long double) : sizeof(double);
+
+    case 's': 
+    case 'q': 
+        return sizeof(const char *);
+    case 'v': 
+    case 'r': 
+        return sizeof(fs_slice);
+    case 'p': 
+    case 'y': 
+        return sizeof(const void *);
+    case 'c': return sizeof(char);
+    default: 
+#ifndef FS_NO_CUSTOM
+        if (NULL != find_custom_conv(spec->conv))
+            return sizeof(const void *);
+#endif /* FS_NO_CUSTOM */
+        return 0;
+    }
+}
+
+
+/* like fetch_arg, but from an array element */
+static void load_arg(fs_internal_conv *conv, const char *elem)
+{
+    const fs_internal_conv_spec *spec = &conv->spec;
+    fs_internal_conv_arg *arg = &conv->arg;
+
+    switch (spec->conv)
+    {
+    case 'i':
+    case 'd':
+        if (spec->l_count == 0)
+            arg->ld = *(const int *)elem;
+#ifdef FS_64BIT_DEFINED
+        else if (spec->l_count == 2)
+            arg->lld = *(const long long *)elem;
+#endif /* FS_64BIT_DEFINED */
+        else
+            arg->ld = *(const long *)elem;
+        break;
+
+    case 'u':
+    case 'x':
+        if (spec->l_count == 0)
+            arg->lu = *(const unsigned int *)elem;
+#ifdef FS_64BIT_DEFINED
+        else if (spec->l_count == 2)
+            arg->llu = *(const unsigned long long *)elem;
+#endif /* FS_64BIT_DEFINED */
+        else
+            arg->lu = *(const unsigned long *)elem;
+        break;
+
+    case 'f':
+    case 'g':
+        if (spec->l_count)
+            arg->lf = *(const long double *)elem;
+        else
+            arg->f = *(const double *)elem;
+        break;
+
+    case 's':
+    case 'q':
+        arg->str.s = *(const char *const *)elem;
+        arg->str.len = -1;
+        break;
+
+    case 'v':
+    case 'r':
+        arg->str.s = ((const fs_slice *)elem)->ptr;
+        arg->str.len = (long)((const fs_slice *)elem)->len;
+        if ((spec->flags & PRECISION_PROVIDED) && arg->str.len > spec->precision)
+            arg->str.len = spec->precision;
+        break;
+
+    case 'c': arg->chr = *elem; break;
+    case 'p': 
+    default: 
+        arg->ptr = *(const void *const *)elem; 
+        break;
+    }
+}
+
+
+/* returns the full length of elements [first, first + count) */
+static fs_size parallel_print(fs_writer *w, const fs_parallel_job *job,
+    fs_size first, fs_size count)
+{
+    fs_internal_conv conv;
+    const char *elem = job->array + first * job->elem_size;
+    fs_size total = 0;
+    fs_size i;
+
+    for (i = 0; i < count; i += 1, elem += job->elem_size)
+    {
+        w->ret = 0;
+        w->cut = 0;
+        w->resume_ret = 0;
+        if (job->prefix_len)
+            spool_str(w, job->prefix, job->prefix_len, 0);
+
+        conv.spec = job->spec;
+        load_arg(&conv, elem);
+        print_conv(w, &conv);
+
+        if (job->suffix_len)
+            spool_str(w, job->suffix, job->suffix_len, 0);
+        total += w->ret;
+    }
+    return total;
+}
+
+
+static void parallel_measure(void *ctx, fs_size worker)
+{
+    fs_parallel_job *job = ctx;
+    fs_parallel_slice *slice = &job->slices[worker];
+    fs_writer w;
+
+    writer_init(&w, NULL, 0);
+    slice->len = parallel_print(&w, job, slice->first, slice->count);
+}
+
+
+static void parallel_write(void *ctx, fs_size worker)
+{
+    fs_parallel_job *job = ctx;
+    const fs_parallel_slice *slice = &job->slices[worker];
+    fs_writer w;
+    fs_size len = slice->len;
+
+    if (slice->offset >= job->bufsz)
+        return;
+    if (len > job->bufsz - slice->offset)
+        len = job->bufsz - slice->offset;
+
+    /* each slice ends where the next one begins, no null terminator */
+    writer_init(&w, job->buf + slice->offset, len + 1);
+    parallel_print(&w, job, slice->first, slice->count);
+}
+
+
+static void parallel_run(fs_parallel_for run, void *sched, fs_size count,
+    void (*fn)(void *ctx, fs_size i), void *ctx)
+{
+    fs_size i;
+    if (NULL != run)
+    {
+        run(sched, count, fn, ctx);
+        return;
+    }
+    for (i = 0; i < count; i += 1)
+        fn(ctx, i);
+}
+
+
+
+fs_size fs_format_parallel(char *buf, fs_size bufsz, const char *fmt,
+    const void *array, fs_size count, unsigned int workers,
+    fs_parallel_for run, void *sched)
+{
+    fs_parallel_job job;
+    const char *fmtptr = fmt;
+    fs_size per_worker, extra, first = 0, offset = 0;
+    unsigned int i;
+
+    /* [prefix]%[spec][suffix] */
+    while (*fmtptr && '%' != *fmtptr)
+        fmtptr += 1;
+    if ('%' != *fmtptr)
+        return FS_PARALLEL_BAD_FORMAT;
+    job.prefix = fmt;
+    job.prefix_len = (int)(fmtptr - fmt);
+
+    fmtptr = parse_spec(fmtptr + 1, &job.spec);
+    job.elem_size = arg_size(&job.spec);
+    if (0 == job.elem_size)
+        return FS_PARALLEL_BAD_FORMAT;
+
+    job.suffix = fmtptr;
+    while (*fmtptr && '%' != *fmtptr)
+        fmtptr += 1;
+    if (*fmtptr)
+        return FS_PARALLEL_BAD_FORMAT;
+    job.suffix_len = (int)(fmtptr - job.suffix);
+
+
+    if (NULL == buf)
+        bufsz = 0;
+    job.array = array;
+    job.buf = buf;
+    job.bufsz = bufsz ? bufsz - 1 : 0;
+
+    if (workers > FS_PARALLEL_MAX_WORKERS)
+        workers = FS_PARALLEL_MAX_WORKERS;
+    if (workers > count)
+        workers = (unsigned int)count;
+    if (0 == workers)
+        workers = 1;
+
+    per_worker = count / workers;
+    extra = count % workers;
+    for (i = 0; i < workers; i += 1)
+    {
+        job.slices[i].first = first;
+        job.slices[i].count = per_worker + (i < extra);
+        first += job.slices[i].count;
+    }
+
+
+    parallel_run(run, sched, workers, parallel_measure, &job);
+    for (i = 0; i < workers; i += 1)
+    {
+        job.slices[i].offset = offset;
+        offset += job.slices[i].len;
+    }
+    parallel_run(run, sched, workers, parallel_write, &job);
+
+    if (bufsz)
+        buf[offset < job.bufsz ? offset : job.bufsz] = 0;
+    return offset;
+}
+
+
+
+
+
+
+
+
+
+
+/* copies the reversed digits of rev to first, NULL if they do not fit */
+static char *put_chars_rev(char *first, char *last, const char *rev, int len)
+{
+    if (NULL == first || last - first < len)
+        return NULL;
+    while (len)
+    {
+        len -= 1;
+        *first = rev[len];
+        first += 1;
+    }
+    return first;
+}
+
+
+char *fs_to_chars_u32(char *first, char *last, fs_u32 value)
+{
+    char tmp[DEC_BUFSIZE];
+    int len = print_decimal_l(tmp, DEC_BUFSIZE, value);
+    return put_chars_rev(first, last, tmp, len);
+}
+
+
+char *fs_to_chars_i32(char *first, char *last, fs_i32 value)
+{
+    char tmp[DEC_BUFSIZE];
+    int len;
+
+    if (value >= 0)
+        return fs_to_chars_u32(first, last, (fs_u32)value);
+
+    len = print_decimal_l(tmp, DEC_BUFSIZE - 1, 0 - (unsigned long)value);
+    tmp[len] = '-';
+    return put_chars_rev(first, last, tmp, len + 1);
+}
+
+
+#ifdef FS_64BIT_DEFINED
+
+char *fs_to_chars_u64(char *first, char *last, fs_u64 value)
+{
+    char tmp[DEC_BUFSIZE];
+    int len = print_decimal_ll(tmp, DEC_BUFSIZE, value);
+    return put_chars_rev(first, last, tmp, len);
+}
+
+
+char *fs_to_chars_i64(char *first, char *last, fs_i64 value)
+{
+    char tmp[DEC_BUFSIZE];
+    int len;
+
+    if (value >= 0)
+        return fs_to_chars_u64(first, last, (fs_u64)value);
+
+    len = print_decimal_ll(tmp, DEC_BUFSIZE - 1, 0 - (unsigned long long)value);
+    tmp[len] = '-';
+    return put_chars_rev(first, last, tmp, len + 1);
+}
+
+
+char *fs_to_chars_hex(char *first, char *last, fs_u64 value)
+{
+    char tmp[DEC_BUFSIZE];
+    int len = print_hex_ll(tmp, DEC_BUFSIZE, value, 0);
+    return put_chars_rev(first, last, tmp, len);
+}
+
+#else
+
+char *fs_to_chars_hex(char *first, char *last, fs_u32 value)
+{
+    char tmp[DEC_BUFSIZE];
+    int len = print_hex_l(tmp, DEC_BUFSIZE, value, 0);
+    return put_chars_rev(first, last, tmp, len);
+}
+
+#endif /* FS_64BIT_DEFINED */
+
+
+/* the whole part of fs_to_chars_f64 is converted to an integer, 
+ * 2^64 (2^32 without 64 bit integers) is where that stops being exact */
+#ifdef FS_64BIT_DEFINED
+#  define TO_CHARS_F64_LIMIT 18446744073709551616.0
+#else
+#  define TO_CHARS_F64_LIMIT 4294967296.0
+#endif /* FS_64BIT_DEFINED */
+
+char *fs_to_chars_f64(char *first, char *last, double value, int precision)
+{
+    char a_tmp[FLT_BUFSIZE];
+    char *tmp = a_tmp;
+    int len;
+    int neg = fs_sign_of_double(value);
+
+    if (precision < 0)
+        precision = FLT_DEFAULT_PRECISION;
+    if (neg)
+        value = -value;
+
+    /* reversed, like the digits */
+    if (value != value)
+        return neg ? put_chars_rev(first, last, "nan-", 4) : put_chars_rev(first, last, "nan", 3);
+    if (value - value != 0)
+        return neg ? put_chars_rev(first, last, "fni-", 4) : put_chars_rev(first, last, "fni", 3);
+    if (value >= TO_CHARS_F64_LIMIT || precision > FLT_MAX_PRECISION)
+        return NULL;
+
+    len = print_float(&tmp, FLT_BUFSIZE - 1, value, precision, 0);
+    if (neg && len)
+    {
+        tmp[len] = '-';
+        len += 1;
+    }
+    return put_chars_rev(first, last, tmp, len);
+}
+
+
+
+
+
+
+
+
+
+
+#ifdef SNPRINTF_TEST
+
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+
+#ifndef FS_C99
+#  error "at least C99 is required for testing code"
+#endif /* FS_C99 */
+
+
+
+
+/** do tests */
+#define DOTEST(bufsz, result, retval, ...) do { \
+    char buf[bufsz]; \
+    int r;\
+    printf("[INFO]: Now test %s\n", #__VA_ARGS__); \
+    r=fs_snprintf(buf, sizeof(buf), __VA_ARGS__); \
+    if(r != retval || strcmp(buf, result) != 0) { \
+        printf("  [ERROR]: test(%s) was '%s':%d\n", \
+                ""#bufsz", "#result", "#retval", "#__VA_ARGS__, \
+                buf, r); \
+        exit(1); \
+    } \
+    r=snprintf(buf, sizeof(buf), __VA_ARGS__); \
+    if(r != retval || strcmp(buf, result) != 0) { \
+        printf("  [WARNING]: test(%s) differs with system, '%s':%d\n", \
+                ""#bufsz", "#result", "#retval", "#__VA_ARGS__, \
+                buf, r); \
+    } \
+    printf("  test(\"%s\":%d) passed\n", buf, r); \
+} while(0);
+
+/** do tests of extensions the system snprintf does not have */
+#define DOTEST_EXT(bufsz, result, retval, ...) do { \
+    char buf[bufsz]; \
+    int r;\
+    printf("[INFO]: Now test %s\n", #__VA_ARGS__); \
+    r=fs_snprintf(buf, sizeof(buf), __VA_ARGS__); \
+    if(r != retval || strcmp(buf, result) != 0) { \
+        printf("  [ERROR]: test(%s) was '%s':%d\n", \
+                ""#bufsz", "#result", "#retval", "#__VA_ARGS__, \
+                buf, r); \
+        exit(1); \
+    } \
+    printf("  test(\"%s\":%d) passed\n", buf, r); \
+} while(0);
+
+
+/** runs the jobs backwards, the output must not depend on the order */
+static void backwards_scheduler(void *sched, fs_size count, 
+    void (*job)(void *ctx, fs_size i), void *ctx)
+{
+    (void)sched;
+    while (count--)
+        job(ctx, count);
+}
+
+
+#ifndef FS_NO_CUSTOM
+/** a custom conversion, rack and slot of a node as r<rack>-s<slot>, 
+ * '#' zero pads the slot to the precision */
+typedef struct test_node { unsigned int rack, slot; } test_node;
+
+static void print_test_node(fs_writer *w, 
+    const fs_conv_spec *spec, const void *arg, void *ctx)
+{
+    const test_node *node = (const test_node *)arg;
+    char digits[DEC_BUFSIZE];
+    int len, i;
+
+    fs_writer_write(w, (spec->flags & FS_CONV_UPPER) ? "R" : "r", 1);
+    len = print_decimal_l(digits, sizeof digits, node->rack);
+    for (i = len; i--;)
+        fs_writer_write(w, digits + i, 1);
+
+    fs_writer_write(w, (const char *)ctx, 2);
+    len = print_decimal_l(digits, sizeof digits, node->slot);
+    if ((spec->flags & FS_CONV_ALT) && spec->precision > len)
+        fs_writer_pad(w, '0', spec->precision - len);
+    for (i = len; i--;)
+        fs_writer_write(w, digits + i, 1);
+}
+#endif /* FS_NO_CUSTOM */
+
+
+#ifndef FS_NO_LAZY
+/** a lazy string, "frame 0 frame 1 ...", counts its calls in ctx */
+static void produce_test_frames(fs_writer *w, void *ctx)
+{
+    int *calls = (int *)ctx;
+    char digit;
+    int i;
+
+    *calls += 1;
+    for (i = 0; i < 4 && !fs_writer_full(w); i += 1)
+    {
+        digit = (char)('0' + i);
+        fs_writer_write(w, " frame ", 7);
+        fs_writer_write(w, &digit, 1);
+    }
+}
+
+
+/** a lazy string of len letters, written 16 at a time */
+typedef struct test_letters
+{
+    int calls;
+    fs_size len;
+} test_letters;
+
+static void produce_test_letters(fs_writer *w, void *ctx)
+{
+    test_letters *letters = (test_letters *)ctx;
+    char chunk[16];
+    fs_size done, n, i;
+
+    letters->calls += 1;
+    for (done = 0; done < letters->len && !fs_writer_full(w); done += n)
+    {
+        n = letters->len - done < 16 ? letters->len - done : 16;
+        for (i = 0; i < n; i += 1)
+            chunk[i] = (char)('a' + (done + i) % 26);
+        fs_writer_write(w, chunk, n);
+    }
+}
+#endif /* FS_NO_LAZY */
+
+
+/** formats through fs_format_resume() in pieces of chunk bytes */
+static int stream_format(char *out, fs_size chunk, const char *fmt, ...)
+{
+    fs_format_state state;
+    va_list ap;
+    char piece[64];
+    fs_size n, total = 0;
+
+    va_start(ap, fmt);
+    fs_format_begin(&state, fmt, &ap);
+    while (!fs_format_done(&state))
+    {
+        n = fs_format_resume(&state, piece, chunk);
+        memcpy(out + total, piece, n);
+        total += n;
+    }
+    va_end(ap);
+    out[total] = 0;
+    return (int)total;
+}
+
+/** do tests through fs_format_resume() */
+#define DOSTREAMTEST(chunk, result, ...) do { \
+    char out[1024]; \
+    int r; \
+    printf("[INFO]: Now test in pieces of %d: %s\n", chunk, #__VA_ARGS__); \
+    r = stream_format(out, chunk, __VA_ARGS__); \
+    if (r != (int)strlen(result) || strcmp(out, result) != 0) { \
+        printf("  [ERROR]: test(%s) was '%s':%d\n", \
+                ""#chunk", "#result", "#__VA_ARGS__, out, r); \
+        exit(1); \
+    } \
+    printf("  test(\"%s\":%d) passed\n", out, r); \
+} while(0);
+
+
+
+
+/** test program */
+int main(void)
+{
+    /* bufsize, expectedstring, expectedretval, snprintf arguments */
+    DOTEST(1024, "hello", 5, "hello");
+    DOTEST(1024, "h", 1, "h");
+    /* warning from gcc for format string, but it does work
+     *   * DOTEST(1024, "", 0, ""); */
+
+    DOTEST(3, "he", 5, "hello");
+    DOTEST(1, "", 7, "%d", 7823089);
+
+    /* test positive numbers */
+    DOTEST(1024, "0", 1, "%d", 0);
+    DOTEST(1024, "1", 1, "%d", 1);
+    DOTEST(1024, "9", 1, "%d", 9);
+    DOTEST(1024, "15", 2, "%d", 15);
+    DOTEST(1024, "ab15cd", 6, "ab%dcd", 15);
+    DOTEST(1024, "167", 3, "%d", 167);
+    DOTEST(1024, "7823089", 7, "%d", 7823089);
+    DOTEST(1024, " 12", 3, "%3d", 12);
+    DOTEST(1024, "012", 3, "%.3d", 12);
+    DOTEST(1024, "012", 3, "%3.3d", 12);
+    DOTEST(1024, "012", 3, "%03d", 12);
+    DOTEST(1024, " 012", 4, "%4.3d", 12);
+    DOTEST(1024, "", 0, "%.0d", 0);
+
+    /* test negative numbers */
+    DOTEST(1024, "-1", 2, "%d", -1);
+    DOTEST(1024, "-12", 3, "%3d", -12);
+    DOTEST(1024, " -2", 3, "%3d", -2);
+    DOTEST(1024, "-012", 4, "%.3d", -12);
+    DOTEST(1024, "-012", 4, "%3.3d", -12);
+    DOTEST(1024, "-012", 4, "%4.3d", -12);
+    DOTEST(1024, " -012", 5, "%5.3d", -12);
+    DOTEST(1024, "-12", 3, "%03d", -12);
+    DOTEST(1024, "-02", 3, "%03d", -2);
+    DOTEST(1024, "-15", 3, "%d", -15);
+    DOTEST(1024, "-7307", 5, "%d", -7307);
+    DOTEST(1024, "-12  ", 5, "%-5d", -12);
+    DOTEST(1024, "-00012", 6, "%-.5d", -12);
+
+    /* test + and space flags */
+    DOTEST(1024, "+12", 3, "%+d", 12);
+    DOTEST(1024, " 12", 3, "% d", 12);
+
+    /* test %u */
+    DOTEST(1024, "12", 2, "%u", 12);
+    DOTEST(1024, "0", 1, "%u", 0);
+    DOTEST(1024, "4294967295", 10, "%u", 0xffffffff);
+
+    /* test %x */
+    DOTEST(1024, "0", 1, "%x", 0);
+    DOTEST(1024, "c", 1, "%x", 12);
+    DOTEST(1024, "12ab34cd", 8, "%x", 0x12ab34cd);
+    DOTEST(1024, "ABCD", 4, "%X", 0xABCD);
+    DOTEST(1024, "0XABCD", 6, "%#X", 0xABCD);
+
+
+    /* test %llu, %lld */
+    DOTEST(1024, "18446744073709551615", 20, "%llu",
+            (long long)0xffffffffffffffff);
+    DOTEST(1024, "-9223372036854775808", 20, "%lld",
+            (long long)0x8000000000000000);
+    DOTEST(1024, "9223372036854775808", 19, "%llu",
+            (long long)0x8000000000000000);
+
+    /* test %s */
+    DOTEST(1024, "hello", 5, "%s", "hello");
+    DOTEST(1024, "     hello", 10, "%10s", "hello");
+    DOTEST(1024, "hello     ", 10, "%-10s", "hello");
+    DOTEST(1024, "he", 2, "%.2s", "hello");
+    DOTEST(1024, "  he", 4, "%4.2s", "hello");
+    DOTEST(1024, "   h", 4, "%4.2s", "h");
+
+    /* test %c */
+    DOTEST(1024, "a", 1, "%c", 'a');
+    /* warning from gcc for format string, but it does work
+     *     DOTEST(1024, "    a", 5, "%5c", 'a');
+     *         DOTEST(1024, "a", 1, "%.0c", 'a'); */
+
+    /* test %n */
+    {
+        const char *expect = "hello  ";
+        char buf[1024];
+        int fs_x, x, fs_ret, ret;
+
+        printf("[INFO]: Now test %%n\n");
+        fs_ret = fs_snprintf(buf, sizeof buf, "hello  %n", &fs_x);
+        if (strcmp(buf, expect) != 0)
+        {
+            printf("  [ERROR]: mismatched strings: (fs:'%s' != expect:'%s')\n", buf, expect);
+            exit(1);
+        }
+        ret = snprintf(buf, sizeof buf, "hello  %n", &x);
+        if (ret != fs_ret)
+        {
+            printf("  [ERROR]: mismatched return value (fs:%d != std:%d)\n", fs_ret, ret);
+            exit(1);
+        }
+        if (fs_x != x)
+        {
+            printf("  [ERROR]: '%%n' failed: (fs:%d != std:%d)", fs_x, x);
+            exit(1);
+        }
+        printf("  test %%n passed\n");
+    }
+
+    /* test %m */
+#ifndef FREESTANDING_TRULY
+#  ifdef __GNUC__
+    errno = 0;
+    {
+        const char *es = strerror(errno);
+        DOTEST(1024, es, strlen(es), "%m");
+    }
+#  endif
+#endif
+
+    /* test %p */
+#ifndef FS_NO_PTR
+    DOTEST(1024, "0x10", 4, "%p", (void*)0x10);
+    DOTEST(1024, "(nil)", 5, "%p", (void*)0x0);
+#else
+    DOTEST_EXT(1024, "|7", 2, "%p|%d", (void*)0x10, 7);
+#endif /* FS_NO_PTR */
+
+    /* test %% */
+    DOTEST(1024, "%", 1, "%%");
+
+    /* test %f */
+#ifndef FS_NO_FLOAT
+    DOTEST(1024, "0.000000", 8, "%f", 0.0);
+    DOTEST(1024, "0.00", 4, "%.2f", 0.0);
+    /* differs, "-0.00" DOTEST(1024, "0.00", 4, "%.2f", -0.0); */
+    DOTEST(1024, "234.00", 6, "%.2f", 234.005);
+    DOTEST(1024, "8973497.1246", 12, "%.4f", 8973497.12456);
+    DOTEST(1024, "-12.000000", 10, "%f", -12.0);
+    DOTEST(1024, "6", 1, "%.0f", 6.0);
+
+    DOTEST(1024, "6", 1, "%g", 6.0);
+    DOTEST(1024, "6.1", 3, "%g", 6.1);
+    DOTEST(1024, "6.15", 4, "%g", 6.15);
+#else
+    /* the argument is still read */
+    DOTEST_EXT(1024, "|7", 2, "%f|%d", 1.5, 7);
+    DOTEST_EXT(1024, "|7|", 3, "%.3g|%d|%f", 1.5, 7, 2.5);
+#endif /* FS_NO_FLOAT */
+
+#ifdef FS_NO_LONGLONG
+    DOTEST_EXT(1024, "-5|7", 4, "%lld|%d", -5LL, 7);
+#endif /* FS_NO_LONGLONG */
+
+    /* These format strings are from the code of NSD, Unbound, ldns */
+
+    DOTEST(1024, "abcdef", 6, "%s", "abcdef");
+    DOTEST(1024, "005", 3, "%03u", 5);
+    DOTEST(1024, "12345", 5, "%03u", 12345);
+    DOTEST(1024, "5", 1, "%d", 5);
+#ifndef FS_NO_PTR
+    DOTEST(1024, "(nil)", 5, "%p", NULL);
+#endif /* FS_NO_PTR */
+    DOTEST(1024, "12345", 5, "%ld", (long)12345);
+    DOTEST(1024, "12345", 5, "%lu", (long)12345);
+    DOTEST(1024, "       12345", 12, "%12u", (unsigned)12345);
+    DOTEST(1024, "12345", 5, "%u", (unsigned)12345);
+    DOTEST(1024, "12345", 5, "%llu", (unsigned long long)12345);
+    DOTEST(1024, "12345", 5, "%x", 0x12345);
+    DOTEST(1024, "12345", 5, "%llx", (long long)0x12345);
+    DOTEST(1024, "012345", 6, "%6.6d", 12345);
+    DOTEST(1024, "012345", 6, "%6.6u", 12345);
+#ifndef FS_NO_FLOAT
+    DOTEST(1024, "1234.54", 7, "%g", 1234.54);
+    DOTEST(1024, "123456789.54", 12, "%.12g", 123456789.54);
+    DOTEST(1024, "3456789123456.54", 16, "%.16g", 3456789123456.54);
+#endif /* FS_NO_FLOAT */
+    /* %24g does not work with 24 digits, not enough accuracy,
+     *   * the first 16 digits are correct */
+    DOTEST(1024, "12345", 5, "%3.3d", 12345);
     DOTEST(1024, "000", 3, "%3.3d", 0);
     DOTEST(1024, "001", 3, "%3.3d", 1);
     DOTEST(1024, "012", 3, "%3.3d", 12);
@@ -1440,11 +4645,13 @@ int main(void)
     DOTEST(1024, "02", 2, "%02ld", (long)2); 
     DOTEST(1024, "02", 2, "%02u", (unsigned)2); 
     DOTEST(1024, "765432", 6, "%05u", (unsigned)765432); 
+#ifndef FS_NO_FLOAT
     DOTEST(1024, "10.234", 6, "%0.3f", 10.23421); 
     DOTEST(1024, "123456.234", 10, "%0.3f", 123456.23421); 
     DOTEST(1024, "123456789.234", 13, "%0.3f", 123456789.23421); 
     DOTEST(1024, "123456.23", 9, "%.2f", 123456.23421); 
     DOTEST(1024, "123456", 6, "%.0f", 123456.23421); 
+#endif /* FS_NO_FLOAT */
     DOTEST(1024, "0123", 4, "%.4x", 0x0123); 
     DOTEST(1024, "00000123", 8, "%.8x", 0x0123); 
     DOTEST(1024, "ffeb0cde", 8, "%.8x", 0xffeb0cde); 
@@ -1458,15 +4665,1020 @@ int main(void)
     DOTEST(1024, "foobarfoobar    ", 16, "%-16s", "foobarfoobar"); 
     DOTEST(1024, "foobarfoobarfoobar", 18, "%-16s", "foobarfoobarfoobar"); 
 
-    /* combined expressions */
-    DOTEST(1024, "foo 1.0 size 512 edns", 21,
-            "foo %s size %d %s%s", "1.0", 512, "", "edns");
-    DOTEST(15, "foo 1.0 size 5", 21,
-            "foo %s size %d %s%s", "1.0", 512, "", "edns");
-    DOTEST(1024, "packet 1203ceff id", 18,
-            "packet %2.2x%2.2x%2.2x%2.2x id", 0x12, 0x03, 0xce, 0xff);
-    DOTEST(1024, "/tmp/testbound_123abcd.tmp", 26, "/tmp/testbound_%u%s%s.tmp", 123, "ab", "cd");
+    /* combined expressions */
+    DOTEST(1024, "foo 1.0 size 512 edns", 21,
+            "foo %s size %d %s%s", "1.0", 512, "", "edns");
+    DOTEST(15, "foo 1.0 size 5", 21,
+            "foo %s size %d %s%s", "1.0", 512, "", "edns");
+    DOTEST(1024, "packet 1203ceff id", 18,
+            "packet %2.2x%2.2x%2.2x%2.2x id", 0x12, 0x03, 0xce, 0xff);
+    DOTEST(1024, "/tmp/testbound_123abcd.tmp", 26, "/tmp/testbound_%u%s%s.tmp", 123, "ab", "cd");
+
+
+    /* test formatting in pieces */
+    DOSTREAMTEST(1, "hello", "hello");
+    DOSTREAMTEST(3, "foo 1.0 size 512 edns", 
+            "foo %s size %d %s%s", "1.0", 512, "", "edns");
+    DOSTREAMTEST(64, "foo 1.0 size 512 edns", 
+            "foo %s size %d %s%s", "1.0", 512, "", "edns");
+    DOSTREAMTEST(4, "[abc                                     ]", "[%-40s]", "abc");
+    DOSTREAMTEST(7, "[                                     abc]", "[%*s]", 40, "abc");
+#ifndef FS_NO_FLOAT
+    DOSTREAMTEST(1, "8973497.1246|-00012|0XABCD", "%.4f|%.5d|%#X", 8973497.12456, -12, 0xABCD);
+#endif /* FS_NO_FLOAT */
+    DOSTREAMTEST(5, "18446744073709551615", "%llu", (long long)0xffffffffffffffff);
+    {
+        int n = 0;
+        char out[64];
+        printf("[INFO]: Now test %%n in pieces\n");
+        stream_format(out, 2, "%5d%n!", 42, &n);
+        if (n != 5 || strcmp(out, "   42!") != 0)
+        {
+            printf("  [ERROR]: '%%n' in pieces was %d, '%s'\n", n, out);
+            exit(1);
+        }
+        printf("  test %%n in pieces passed\n");
+    }
+
+    /* test the truncating variant */
+    {
+        char buf[16];
+        int r, truncated;
+
+        printf("[INFO]: Now test fs_snprintf_trunc\n");
+        r = fs_snprintf_trunc(buf, sizeof buf, &truncated, "foo %s size %d %s%s", "1.0", 512, "", "edns");
+        if (r != 15 || !truncated || strcmp(buf, "foo 1.0 size 51") != 0)
+        {
+            printf("  [ERROR]: fs_snprintf_trunc was '%s':%d:%d\n", buf, r, truncated);
+            exit(1);
+        }
+        r = fs_snprintf_trunc(buf, sizeof buf, &truncated, "%-8s|%5d|", "abc", 42);
+        if (r != 15 || truncated || strcmp(buf, "abc     |   42|") != 0)
+        {
+            printf("  [ERROR]: fs_snprintf_trunc was '%s':%d:%d\n", buf, r, truncated);
+            exit(1);
+        }
+        r = fs_snprintf_trunc(buf, 4, NULL, "%d", 123456);
+        if (r != 3 || strcmp(buf, "123") != 0)
+        {
+            printf("  [ERROR]: fs_snprintf_trunc was '%s':%d\n", buf, r);
+            exit(1);
+        }
+        printf("  test fs_snprintf_trunc passed\n");
+    }
+
+    /* test parallel formatting */
+    {
+        static int values[1000];
+        char expect[8192], *p = expect;
+        char buf[8192];
+        const char *strs[] = { "a", "bc", "", "def" };
+        fs_size r;
+        int i;
+
+        printf("[INFO]: Now test fs_format_parallel\n");
+        for (i = 0; i < 1000; i += 1)
+        {
+            values[i] = (i * 7919) % 100003 - 5000;
+            p += sprintf(p, "<%5d>\n", values[i]);
+        }
+        r = fs_format_parallel(buf, sizeof buf, "<%5d>\n", values, 1000, 7, backwards_scheduler, NULL);
+        if (r != (fs_size)(p - expect) || strcmp(buf, expect) != 0)
+        {
+            printf("  [ERROR]: fs_format_parallel differs from the serial output\n");
+            exit(1);
+        }
+        r = fs_format_parallel(buf, 100, "<%5d>\n", values, 1000, 3, NULL, NULL);
+        if (r != (fs_size)(p - expect) || strlen(buf) != 99 || strncmp(buf, expect, 99) != 0)
+        {
+            printf("  [ERROR]: truncated fs_format_parallel differs from the serial output\n");
+            exit(1);
+        }
+        r = fs_format_parallel(buf, sizeof buf, "%s,", strs, 4, 64, backwards_scheduler, NULL);
+        if (r != 10 || strcmp(buf, "a,bc,,def,") != 0)
+        {
+            printf("  [ERROR]: fs_format_parallel with %%s was '%s'\n", buf);
+            exit(1);
+        }
+        if (fs_format_parallel(buf, sizeof buf, "%d %d", values, 2, 1, NULL, NULL) != FS_PARALLEL_BAD_FORMAT
+        || fs_format_parallel(buf, sizeof buf, "%*d", values, 2, 1, NULL, NULL) != FS_PARALLEL_BAD_FORMAT)
+        {
+            printf("  [ERROR]: fs_format_parallel accepted a bad format\n");
+            exit(1);
+        }
+        printf("  test fs_format_parallel passed\n");
+    }
+
+    /* test %k */
+#ifndef FS_NO_TIMESTAMP
+    DOTEST_EXT(1024, "1970-01-01T00:00:00.000000", 26, "%k", 0, 0L);
+    DOTEST_EXT(1024, "2000-02-29T12:34:56.000789", 26, "%k", 951827696, 789L);
+    DOTEST_EXT(1024, "2023-11-14T22:13:20.123", 23, "%.3k", 1700000000, 123456L);
+    DOTEST_EXT(1024, "[2023-11-14T22:13:20]", 21, "[%.0k]", 1700000000, 999999L);
+    DOTEST_EXT(1024, "1969-12-31T23:59:59.500000", 26, "%lk", -1L, 500000L);
+    DOTEST_EXT(1024, "1970-01-01T00:00:01.500000", 26, "%k", 0, 1500000L);
+    DOTEST_EXT(1024, "9999-12-31T23:59:59.000000", 26, "%llk", 253402300799LL, 0L);
+    DOTEST_EXT(1024, "+10000-01-01T00:00:00.000000", 28, "%llk", 253402300800LL, 0L);
+    DOTEST_EXT(12, "2023-11-14T", 23, "%.3k", 1700000000, 123456L);
+    {
+        char buf[64], expect[64];
+        long long sec;
+        time_t t;
+
+        printf("[INFO]: Now test %%k against gmtime\n");
+        for (sec = -2208988800LL; sec < 7258118400LL; sec += 86399LL * 37 + 1234)
+        {
+            t = (time_t)sec;
+            strftime(expect, sizeof expect, "%Y-%m-%dT%H:%M:%S", gmtime(&t));
+            fs_snprintf(buf, sizeof buf, "%.0llk", sec, 0L);
+            if (strcmp(buf, expect) != 0)
+            {
+                printf("  [ERROR]: %%k of %lld was '%s', expected '%s'\n", sec, buf, expect);
+                exit(1);
+            }
+            fs_snprintf(buf, sizeof buf, "%.0llk", sec, 0L); /* again, from the cache */
+            if (strcmp(buf, expect) != 0)
+            {
+                printf("  [ERROR]: cached %%k of %lld was '%s', expected '%s'\n", sec, buf, expect);
+                exit(1);
+            }
+        }
+        printf("  test %%k against gmtime passed\n");
+    }
+#else
+    DOTEST_EXT(1024, "|7", 2, "%.3k|%d", 1700000000, 123456L, 7);
+#endif /* FS_NO_TIMESTAMP */
+
+    /* test %j */
+#ifndef FS_NO_FIXED
+    DOTEST_EXT(1024, "123.45", 6, "%j", 12345, 2);
+    DOTEST_EXT(1024, "123.5", 5, "%.1j", 12345, 2);
+    DOTEST_EXT(1024, "-124", 4, "%.0j", -12350, 2);
+    DOTEST_EXT(1024, "0.0500", 6, "%.4j", 5, 2);
+    DOTEST_EXT(1024, "-0.005", 6, "%j", -5, 3);
+    DOTEST_EXT(1024, "0.00", 4, "%.2j", -4, 3);
+    DOTEST_EXT(1024, "42000", 5, "%j", 42, -3);
+    DOTEST_EXT(1024, "42000.00", 8, "%.2j", 42, -3);
+    DOTEST_EXT(1024, "0", 1, "%j", 0, -3);
+    DOTEST_EXT(1024, "7", 1, "%j", 7, 0);
+    DOTEST_EXT(1024, "+0012.34", 8, "%+08j", 1234, 2);
+    DOTEST_EXT(1024, "[12.34   ]", 10, "[%-8j]", 1234, 2);
+    DOTEST_EXT(1024, "[  -12.34]", 10, "[%8j]", -1234, 2);
+    DOTEST_EXT(1024, "15.0|7", 6, "%j|%d", 150, 1, 7);
+    DOTEST_EXT(1024, "12345.6789", 10, "%lj", 123456789L, 4);
+    DOTEST_EXT(1024, "-92233720368547758.08", 21, "%llj", -9223372036854775807LL - 1, 2);
+    DOTEST_EXT(1024, "0.9223372036854775807", 21, "%llj", 9223372036854775807LL, 19);
+    DOTEST_EXT(1024, "1", 1, "%.0llj", 9223372036854775807LL, 19);
+    DOTEST_EXT(1024, "0", 1, "%.0llj", 4999999999999999999LL, 19);
+    DOTEST_EXT(1024, "1", 1, "%.0llj", 5000000000000000000LL, 19);
+    DOTEST_EXT(1024, "0.0", 3, "%.1j", 1, 25);
+    DOTEST_EXT(1024, "123.4500000000000000000000000000000000000000", 44, "%.41j", 12345, 2);
+    DOTEST_EXT(1024, "||", 2, "|%j|", 1, 41);
+    DOTEST_EXT(5, "123.", 7, "%j", 123456, 3);
+    {
+        char buf[64], expect[64];
+        long long v, whole;
+
+        printf("[INFO]: Now test %%j against integer division\n");
+        for (v = -100000; v <= 100000; v += 7)
+        {
+            whole = v < 0 ? -v : v;
+            sprintf(expect, "%s%lld.%02lld", v < 0 ? "-" : "", whole / 100, whole % 100);
+            fs_snprintf(buf, sizeof buf, "%llj", v, 2);
+            if (strcmp(buf, expect) != 0)
+                break;
+
+            /* rounded to tenths of the thousandths */
+            whole = (whole + 50) / 100;
+            sprintf(expect, "%s%lld.%lld", v < 0 && whole ? "-" : "", whole / 10, whole % 10);
+            fs_snprintf(buf, sizeof buf, "%.1llj", v, 3);
+            if (strcmp(buf, expect) != 0)
+                break;
+        }
+        if (v <= 100000)
+        {
+            printf("  [ERROR]: %%j of %lld was '%s', expected '%s'\n", v, buf, expect);
+            exit(1);
+        }
+        printf("  test %%j against integer division passed\n");
+    }
+#else
+    DOTEST_EXT(1024, "|7", 2, "%j|%d", 12345, 2, 7);
+#endif /* FS_NO_FIXED */
+
+    /* test %I4 and %I6 */
+#ifndef FS_NO_IPADDR
+    {
+        static const unsigned char ip4[] = { 192, 0, 2, 255 };
+        static const unsigned char ip4_zero[] = { 0, 0, 0, 0 };
+        static const unsigned char ip6_doc[] = { 
+            0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+        static const unsigned char ip6_any[16] = { 0 };
+        static const unsigned char ip6_loop[] = { 
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+        static const unsigned char ip6_two_runs[] = { 
+            0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1 };
+        static const unsigned char ip6_one_zero[] = { 
+            0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1 };
+        static const unsigned char ip6_full[] = { 
+            0xfe, 0x80, 0x12, 0x34, 0xab, 0xcd, 0x00, 0x0e, 0x10, 0x00, 0x02, 0x00, 0x00, 0x30, 0x00, 0x04 };
+        static const unsigned char ip6_mapped[] = { 
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 192, 0, 2, 1 };
+        static const unsigned char ip6_trailing[] = { 
+            0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+        DOTEST_EXT(1024, "192.0.2.255", 11, "%I4", ip4);
+        DOTEST_EXT(1024, "0.0.0.0", 7, "%I4", ip4_zero);
+        DOTEST_EXT(1024, "from     192.0.2.255#53", 23, "from %15I4#%d", ip4, 53);
+        DOTEST_EXT(1024, "2001:db8::1", 11, "%I6", ip6_doc);
+        DOTEST_EXT(1024, "::", 2, "%I6", ip6_any);
+        DOTEST_EXT(1024, "::1", 3, "%I6", ip6_loop);
+        DOTEST_EXT(1024, "2001:db8::1:0:0:1", 17, "%I6", ip6_two_runs);
+        DOTEST_EXT(1024, "2001:db8:0:1:1:1:1:1", 20, "%I6", ip6_one_zero);
+        DOTEST_EXT(1024, "fe80:1234:abcd:e:1000:200:30:4", 30, "%I6", ip6_full);
+        DOTEST_EXT(1024, "::ffff:192.0.2.1", 16, "%I6", ip6_mapped);
+        DOTEST_EXT(1024, "2001:db8::", 10, "%I6", ip6_trailing);
+        DOTEST_EXT(1024, "[2001:db8::1]:53", 16, "[%I6]:%d", ip6_doc, 53);
+        DOTEST_EXT(1024, "(nil)", 5, "%I6", NULL);
+    }
+#else
+    DOTEST_EXT(1024, "||7", 3, "%I4|%I6|%d", "\300\0\2\1", NULL, 7);
+#endif /* FS_NO_IPADDR */
+
+    /* test the to_chars functions */
+    {
+        char buf[64], expect[64], *end;
+        unsigned long long u = 1;
+        int i;
+
+        printf("[INFO]: Now test fs_to_chars\n");
+        for (i = 0; i < 2000; i += 1)
+        {
+            u = u * 6364136223846793005ULL + 1442695040888963407ULL;
+
+            end = fs_to_chars_u32(buf, buf + sizeof buf, (fs_u32)(u >> (i % 32)));
+            snprintf(expect, sizeof expect, "%lu", (unsigned long)(fs_u32)(u >> (i % 32)));
+            if ((fs_size)(end - buf) != strlen(expect) || memcmp(buf, expect, end - buf) != 0)
+                break;
+
+            end = fs_to_chars_i32(buf, buf + sizeof buf, (fs_i32)(u >> 32));
+            snprintf(expect, sizeof expect, "%ld", (long)(fs_i32)(u >> 32));
+            if ((fs_size)(end - buf) != strlen(expect) || memcmp(buf, expect, end - buf) != 0)
+                break;
+
+            end = fs_to_chars_u64(buf, buf + sizeof buf, u >> (i % 64));
+            snprintf(expect, sizeof expect, "%llu", u >> (i % 64));
+            if ((fs_size)(end - buf) != strlen(expect) || memcmp(buf, expect, end - buf) != 0)
+                break;
+
+            end = fs_to_chars_i64(buf, buf + sizeof buf, (long long)u);
+            snprintf(expect, sizeof expect, "%lld", (long long)u);
+            if ((fs_size)(end - buf) != strlen(expect) || memcmp(buf, expect, end - buf) != 0)
+                break;
+
+            end = fs_to_chars_hex(buf, buf + sizeof buf, u >> (i % 64));
+            snprintf(expect, sizeof expect, "%llx", u >> (i % 64));
+            if ((fs_size)(end - buf) != strlen(expect) || memcmp(buf, expect, end - buf) != 0)
+                break;
+
+#ifndef FS_NO_FLOAT
+            end = fs_to_chars_f64(buf, buf + sizeof buf, (double)(long long)(u >> 40) / 1024.0, 3);
+            fs_snprintf(expect, sizeof expect, "%.3f", (double)(long long)(u >> 40) / 1024.0);
+            if ((fs_size)(end - buf) != strlen(expect) || memcmp(buf, expect, end - buf) != 0)
+                break;
+#endif /* FS_NO_FLOAT */
+        }
+        if (i != 2000)
+        {
+            printf("  [ERROR]: fs_to_chars wrote '%.*s', expected '%s'\n", (int)(end ? end - buf : 0), buf, expect);
+            exit(1);
+        }
+        if (fs_to_chars_f64(buf, buf + sizeof buf, -12.5, 2) != buf + 6 || memcmp(buf, "-12.50", 6) != 0
+        || fs_to_chars_f64(buf, buf + sizeof buf, -0.0, 2) != buf + 5 || memcmp(buf, "-0.00", 5) != 0
+        || fs_to_chars_f64(buf, buf + sizeof buf, 0.999, 2) != buf + 4 || memcmp(buf, "1.00", 4) != 0
+        || fs_to_chars_f64(buf, buf + sizeof buf, 0.7, 0) != buf + 1 || memcmp(buf, "1", 1) != 0
+        || fs_to_chars_f64(buf, buf + sizeof buf, 0.5, 19) != buf + 21 
+        || memcmp(buf, "0.5000000000000000000", 21) != 0
+        || fs_to_chars_f64(buf, buf + sizeof buf, 1.0 / 0.0, 2) != buf + 3 || memcmp(buf, "inf", 3) != 0
+        || fs_to_chars_f64(buf, buf + sizeof buf, -1.0 / 0.0, 2) != buf + 4 || memcmp(buf, "-inf", 4) != 0
+        || NULL == (end = fs_to_chars_f64(buf, buf + sizeof buf, 0.0 / 0.0, 2))
+        || (memcmp(buf, "nan", 3) != 0 && memcmp(buf, "-nan", 4) != 0) || end[-1] != 'n'
+        || fs_to_chars_f64(buf, buf + 2, 1.0 / 0.0, 2) != NULL
+        || fs_to_chars_f64(buf, buf + sizeof buf, 1e300, 2) != NULL
+        || fs_to_chars_f64(buf, buf + sizeof buf, 18446744073709551616.0, 0) != NULL
+        || fs_to_chars_f64(buf, buf + sizeof buf, 18446744073709549568.0, 0) != buf + 20
+        || memcmp(buf, "18446744073709549568", 20) != 0
+        || fs_to_chars_f64(buf, buf + sizeof buf, 1.5, 20) != NULL
+        || fs_to_chars_i64(buf, buf + sizeof buf, (long long)0x8000000000000000ULL) != buf + 20
+        || memcmp(buf, "-9223372036854775808", 20) != 0
+        || fs_to_chars_u32(buf, buf + 2, 123) != NULL
+        || fs_to_chars_u32(buf, buf + 3, 123) != buf + 3)
+        {
+            printf("  [ERROR]: fs_to_chars edge cases failed\n");
+            exit(1);
+        }
+        printf("  test fs_to_chars passed\n");
+    }
+
+    /* test the fs_size variant */
+    {
+        char buf[8];
+        fs_size r = fs_snprintf_sz(buf, sizeof buf, "%-20s|", "abc");
+
+        printf("[INFO]: Now test fs_snprintf_sz\n");
+        if (r != 21 || strcmp(buf, "abc    ") != 0)
+        {
+            printf("  [ERROR]: fs_snprintf_sz was '%s':%lu\n", buf, (unsigned long)r);
+            exit(1);
+        }
+        printf("  test fs_snprintf_sz passed\n");
+    }
+
+#ifdef FS_MMAP_SINK
+    /* test the mmap sink, with a small stride so that it remaps a lot */
+    {
+        const char *path = "fs_mmap_sink_test.txt";
+        fs_mmap_sink m;
+        FILE *f;
+        char line[64], expect[64];
+        fs_size total = 0;
+        int i, ok = 1;
+
+        printf("[INFO]: Now test fs_mmap_sink\n");
+        if (fs_mmap_sink_open(&m, path, 1) != 0)
+        {
+            printf("  [ERROR]: fs_mmap_sink_open failed\n");
+            exit(1);
+        }
+        for (i = 0; i < 20000; i += 1)
+            total += fs_sink_printf(&m.sink, "line %6d: %-20s|\n", i, "payload");
+        if (fs_mmap_sink_close(&m) != 0)
+            ok = 0;
+
+        f = fopen(path, "r");
+        for (i = 0; ok && i < 20000; i += 1)
+        {
+            snprintf(expect, sizeof expect, "line %6d: %-20s|\n", i, "payload");
+            ok = NULL != fgets(line, sizeof line, f) && strcmp(line, expect) == 0;
+        }
+        ok = ok && NULL == fgets(line, sizeof line, f) && total == (fs_size)ftell(f);
+        fclose(f);
+        remove(path);
+        if (!ok)
+        {
+            printf("  [ERROR]: fs_mmap_sink file differs\n");
+            exit(1);
+        }
+        printf("  test fs_mmap_sink passed\n");
+    }
+#endif /* FS_MMAP_SINK */
+
+#ifdef FS_FORMAT_CACHE
+    /* the second round is served from the format cache */
+    {
+        int round;
+        for (round = 0; round < 2; round += 1)
+        {
+            DOTEST(1024, "packet 1203ceff id", 18,
+                    "packet %2.2x%2.2x%2.2x%2.2x id", 0x12, 0x03, 0xce, 0xff);
+            DOTEST(1024, "  hello|-012", 12, "%*s|%.*d", 7, "hello", 3, -12);
+            DOTEST(1024, "1 2 3 4 5 6 7 8 9", 17, "%d %d %d %d %d %d %d %d %d", 
+                    1, 2, 3, 4, 5, 6, 7, 8, 9);
+        }
+    }
+    /* a format rewritten in place is parsed again */
+    {
+        char fmt[32];
+        int round;
+        for (round = 0; round < 3; round += 1)
+        {
+            strcpy(fmt, "a=%d b=%s");
+            DOTEST(1024, "a=1 b=x", 7, fmt, 1, "x");
+        }
+        strcpy(fmt, "%s and %d");
+        DOTEST(1024, "x and 1", 7, fmt, "x", 1);
+        strcpy(fmt, "%s and %d!");
+        DOTEST(1024, "x and 1!", 8, fmt, "x", 1);
+        strcpy(fmt, "%d and %s");
+        DOTEST(1024, "1 and x", 7, fmt, 1, "x");
+        /* the first spec still matches, the parser goes on from the second */
+        strcpy(fmt, "%d and %c");
+        DOTEST(1024, "1 and y", 7, fmt, 1, 'y');
+        DOTEST(1024, "2 and z", 7, fmt, 2, 'z');
+        strcpy(fmt, "%d and %c!");
+        DOTEST(1024, "1 and y!", 8, fmt, 1, 'y');
+        strcpy(fmt, "%d and %c");
+        DOTEST(1024, "1 and y", 7, fmt, 1, 'y');
+    }
+    /* formats with more conversions than a slot holds are formatted by the parser */
+    {
+        int round;
+        for (round = 0; round < 2; round += 1)
+        {
+            DOTEST(1024, "1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17", 41, 
+                    "%d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d", 
+                    1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17);
+        }
+    }
+#endif /* FS_FORMAT_CACHE */
+
+#if defined(FS_STATS) && !defined(FS_NO_IPADDR)
+    {
+        static const char fmt[] = "%d|%s|%I4|%%";
+        static char fmts[FS_STATS_FORMATS + 8][2];
+        static fs_stats stats;
+        const fs_u8 addr[4] = {10, 0, 0, 1};
+        const fs_stats_entry *e;
+        fs_stats_count calls;
+        char out[64];
+        int i, ok;
+
+        printf("[INFO]: Now test FS_STATS\n");
+        fs_stats_reset();
+        fs_snprintf(out, sizeof out, fmt, 42, "abc", addr);
+        /* "7|abc|1" fits, %I4 and %% do not */
+        fs_snprintf(out, 8, fmt, 7, "abc", addr);
+        fs_stats_snapshot(&stats);
+
+        e = &stats.conv['d' - 'a'];
+        ok = 2 == e->calls && 3 == e->bytes && 0 == e->truncations;
+        e = &stats.conv['s' - 'a'];
+        ok = ok && 2 == e->calls && 6 == e->bytes && 0 == e->truncations;
+        e = &stats.conv[FS_STATS_IP4];
+        ok = ok && 2 == e->calls && 16 == e->bytes && 1 == e->truncations;
+        e = &stats.conv[FS_STATS_PERCENT];
+        ok = ok && 2 == e->calls && 2 == e->bytes && 1 == e->truncations;
+        for (i = 0, e = NULL; i < FS_STATS_FORMATS; i += 1)
+        {
+            if (fmt == stats.formats[i].fmt)
+                e = &stats.formats[i].stats;
+            else
+                ok = ok && NULL == stats.formats[i].fmt;
+        }
+        ok = ok && NULL != e && 2 == e->calls && 33 == e->bytes && 1 == e->truncations;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        ok = ok && e->cycles > 0;
+#endif
+        if (!ok)
+        {
+            printf("  [ERROR]: counters of '%s'\n", fmt);
+            exit(1);
+        }
+
+        /* every call is in one bucket */
+        for (i = 0, calls = 0; NULL != e && i < FS_STATS_BUCKETS; i += 1)
+            calls += e->histogram[i];
+        for (i = 0; i < FS_STATS_BUCKETS; i += 1)
+            calls += stats.conv['d' - 'a'].histogram[i];
+        if (4 != calls || 0 != stats_bucket(0) || 0 != stats_bucket(31) 
+        || 1 != stats_bucket(32) || 1 != stats_bucket(63) || 2 != stats_bucket(64)
+        || 14 != stats_bucket((fs_stats_count)1 << 18) 
+        || 15 != stats_bucket((fs_stats_count)1 << 19) || 15 != stats_bucket((fs_stats_count)-1))
+        {
+            printf("  [ERROR]: cycle histogram holds %d calls\n", (int)calls);
+            exit(1);
+        }
+
+        /* one format more than there are slots */
+        fs_stats_reset();
+        for (i = 0; i < FS_STATS_FORMATS + 8; i += 1)
+        {
+            fmts[i][0] = 'x';
+            fs_snprintf(out, sizeof out, fmts[i]);
+        }
+        fs_stats_snapshot(&stats);
+        for (i = 0; ok && i < FS_STATS_FORMATS; i += 1)
+            ok = NULL != stats.formats[i].fmt && 1 == stats.formats[i].stats.calls;
+        if (!ok || 8 != stats.other_formats.calls || 8 != stats.other_formats.bytes)
+        {
+            printf("  [ERROR]: formats past the last slot\n");
+            exit(1);
+        }
+        printf("  test FS_STATS passed\n");
+    }
+#endif /* FS_STATS && !FS_NO_IPADDR */
+
+    /* every kernel level the CPU has agrees with the scalar kernels */
+    {
+        static char text[300], a[320], b[320];
+        int level, supported = fs_snprintf_dispatch();
+        fs_size i, n;
+        int ok = 1;
+
+        for (i = 0; i < sizeof text - 1; i += 1)
+            text[i] = (char)('a' + i % 26);
+        for (level = FS_KERNELS_SCALAR; level <= supported; level += 1)
+        {
+            fs_snprintf_set_kernels(level);
+            for (i = 0; ok && i < 130; i += 1)
+            {
+                text[i + 100] = (i & 1) ? '%' : 0;
+                for (n = 0; ok && n < 100; n += 1)
+                {
+                    ok = kernels()->find_conv(text + n) == find_conv_scalar(text + n)
+                        && kernels()->strnlen(text + n, i) == strnlen_scalar(text + n, i)
+                        && kernels()->strnlen(text + n, (fs_size)-1) 
+                            == strnlen_scalar(text + n, (fs_size)-1);
+                    memset(a, '#', sizeof a);
+                    memset(b, '#', sizeof b);
+                    kernels()->copy(a + i % 7, text + n, i);
+                    copy_scalar(b + i % 7, text + n, i);
+                    kernels()->fill(a + 160 + n % 31, '0', i);
+                    fill_scalar(b + 160 + n % 31, '0', i);
+                    ok = ok && memcmp(a, b, sizeof a) == 0;
+                }
+                text[i + 100] = (char)('a' + (i + 100) % 26);
+            }
+#ifndef FS_NO_ESCAPE
+            for (i = 0; ok && i < 130; i += 1)
+            {
+                text[i + 100] = "\"\\\x7f\n\x1f"[i % 5];
+                text[i % 90] = (char)0xC3; /* not escaped */
+                for (n = 0; ok && n < 100; n += 1)
+                {
+                    ok = kernels()->find_escape(text + n, i, i & 1) 
+                            == find_escape_scalar(text + n, i, i & 1)
+                        && kernels()->find_escape(text + n, i + 120, i & 1) 
+                            == find_escape_scalar(text + n, i + 120, i & 1);
+                }
+                text[i + 100] = (char)('a' + (i + 100) % 26);
+                text[i % 90] = (char)('a' + i % 90 % 26);
+            }
+#endif /* FS_NO_ESCAPE */
+#ifndef FS_NO_BASE64
+            for (i = 0; ok && i < 100; i += 1)
+            {
+                memset(a, '#', sizeof a);
+                memset(b, '#', sizeof b);
+                n = kernels()->base64(a, (const unsigned char *)text + i % 13, i, i & 1);
+                ok = n == base64_scalar(b, (const unsigned char *)text + i % 13, i, i & 1)
+                    && n == i / 3 * 3 && memcmp(a, b, sizeof a) == 0;
+            }
+#endif /* FS_NO_BASE64 */
+            for (i = 0; ok && i < 64 * 8; i += 1)
+            {
+                fs_umax value = (fs_umax)1 << (i % (sizeof(fs_umax) * 8));
+                value = (i & 64) ? value - 1 : value * 5 / 3;
+                n = kernels()->decimal(a, 32, value);
+                ok = (int)n == decimal_scalar(b, 32, value) && memcmp(a, b, n) == 0;
+                n = kernels()->hex(a, 32, value, i & 1);
+                ok = ok && (int)n == hex_scalar(b, 32, value, i & 1) && memcmp(a, b, n) == 0;
+                n = kernels()->decimal(a, 3, value);
+                ok = ok && (int)n == decimal_scalar(b, 3, value) && memcmp(a, b, n) == 0;
+            }
+            if (!ok)
+            {
+                printf("  [ERROR]: kernel level %d differs from scalar\n", level);
+                exit(1);
+            }
+            DOTEST(1024, "%  2a|0xff|18446744073709551615|  -42", 37,
+                    "%%%*x|%#x|%llu|%5d", 4, 42, 255, 18446744073709551615ull, -42);
+            DOTEST(1024, "a long literal before the conversion abcdefghijklmnopqrstuvwxyz|"
+                    "hello                                   |", 105,
+                    "a long literal before the conversion %s|%-40.5s|", 
+                    "abcdefghijklmnopqrstuvwxyz", "hello world");
+        }
+        printf("  test kernel levels 0 to %d passed\n", supported);
+    }
+
+    /* the paths that FS_PROFILE_SPEED and FS_PROFILE_SIZE build differently */
+    {
+        char a[64], b[64];
+#ifndef FS_NO_IPADDR
+        fs_u8 addr[4];
+#endif /* FS_NO_IPADDR */
+        fs_size ptr;
+        unsigned int i;
+        int ok = 1;
+
+        printf("[INFO]: Now test the %s profile\n",
+#ifdef FS_PROFILE_SPEED
+            "speed"
+#else
+            "size"
+#endif /* FS_PROFILE_SPEED */
+        );
+        for (i = 0; ok && i < 256; i += 1)
+        {
+#ifndef FS_NO_IPADDR
+            addr[0] = (fs_u8)i;
+            addr[1] = (fs_u8)(255 - i);
+            addr[2] = (fs_u8)(i / 10);
+            addr[3] = (fs_u8)(i % 100);
+            fs_snprintf(a, sizeof a, "%I4", addr);
+            sprintf(b, "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
+            ok = strcmp(a, b) == 0;
+#endif /* FS_NO_IPADDR */
+
+#ifndef FS_NO_PTR
+            ptr = ((fs_size)i * 0x9E3779B9u + 1) << (i % 24);
+            fs_snprintf(a, sizeof a, "%p|%P", (void *)ptr, (void *)ptr);
+            sprintf(b, "%#zx|%#zX", ptr, ptr);
+            ok = ok && strcmp(a, b) == 0;
+#endif /* FS_NO_PTR */
+        }
+        for (i = 0, ptr = 1; ok && i <= FLT_MAX_PRECISION; i += 1, ptr *= 10)
+            ok = quick_pow10(i) == ptr;
+        if (!ok)
+        {
+            printf("  [ERROR]: '%s' should be '%s', or quick_pow10(%u) is wrong\n", a, b, i);
+            exit(1);
+        }
+        printf("  test profile paths passed\n");
+    }
+
+#ifndef FS_NO_IOV
+    /* long strings are passed through the iov, the rest goes to scratch */
+    {
+        static char payload[4097], expect[5000], scratch[64], joined[5000];
+        fs_iovec iov[8];
+        int i, count, len, ok;
+
+        printf("[INFO]: Now test fs_snprintf_iov\n");
+        for (i = 0; i < 4096; i += 1)
+            payload[i] = (char)('a' + i % 26);
+        len = fs_snprintf(expect, sizeof expect, "[%d] %s|%-5s|%10s\n", 7, "msg", payload, "x");
+
+        count = fs_snprintf_iov(iov, 8, scratch, sizeof scratch, 
+            "[%d] %s|%-5s|%10s\n", 7, "msg", payload, "x");
+        ok = 3 == count && iov[1].iov_base == payload && 4096 == iov[1].iov_len;
+        for (i = 0, joined[0] = 0; ok && i < count; i += 1)
+            strncat(joined, (const char *)iov[i].iov_base, iov[i].iov_len);
+        ok = ok && (int)strlen(joined) == len && strcmp(joined, expect) == 0;
+
+        /* no room for a reference, the payload does not fit in scratch */
+        ok = ok && -1 == fs_snprintf_iov(iov, 2, scratch, sizeof scratch, 
+            "[%d] %s|%-5s|%10s\n", 7, "msg", payload, "x");
+        ok = ok && -1 == fs_snprintf_iov(iov, 8, scratch, 3, "[%d] %s", 7, payload);
+        ok = ok && 1 == fs_snprintf_iov(iov, 1, scratch, sizeof scratch, "%S|%d", "short", 1)
+            && 7 == iov[0].iov_len && memcmp(scratch, "SHORT|1", 7) == 0;
+        if (!ok)
+        {
+            printf("  [ERROR]: fs_snprintf_iov returned %d\n", count);
+            exit(1);
+        }
+        printf("  test fs_snprintf_iov passed\n");
+    }
+#endif /* FS_NO_IOV */
+
+#ifndef FS_NO_CUSTOM
+    /* custom conversions, through every path of the writer */
+    {
+        test_node node = { 12, 7 };
+        test_node nodes[3] = { {1, 2}, {3, 4}, {5, 6} };
+        const test_node *node_ptrs[3];
+        char buf[64];
+        fs_size r;
+
+        if (0 != fs_register_conversion('w', print_test_node, "-s")
+        || -1 != fs_register_conversion('d', print_test_node, NULL)
+        || -1 != fs_register_conversion('W', print_test_node, NULL))
+        {
+            printf("  [ERROR]: fs_register_conversion\n");
+            exit(1);
+        }
+        DOTEST_EXT(1024, "node r12-s7 up", 14, "node %w up", &node);
+        DOTEST_EXT(1024, "[  R12-s007][r12-s7    ]", 24, "[%#10.3W][%-10w]", &node, &node);
+        DOTEST_EXT(1024, "[  r12-s7|5]", 12, "[%*w|%d]", 8, &node, 5);
+        DOTEST_EXT(8, "[  r12-", 12, "[%*w|%d]", 8, &node, 5);
+        DOSTREAMTEST(3, "node   r12-s7 up", "node %8w up", &node);
+
+        node_ptrs[0] = &nodes[0];
+        node_ptrs[1] = &nodes[1];
+        node_ptrs[2] = &nodes[2];
+        r = fs_format_parallel(buf, sizeof buf, "%w,", node_ptrs, 3, 2, backwards_scheduler, NULL);
+        if (r != 18 || strcmp(buf, "r1-s2,r3-s4,r5-s6,") != 0)
+        {
+            printf("  [ERROR]: custom conversion in parallel, '%s'\n", buf);
+            exit(1);
+        }
+        fs_register_conversion('w', NULL, NULL);
+        printf("  test custom conversions passed\n");
+    }
+#else
+    /* an unknown letter reads no argument, as in C */
+    DOTEST_EXT(1024, "[]|7", 4, "[%w]|%d", 7);
+#endif /* FS_NO_CUSTOM */
+
+#ifndef FS_NO_SLICE
+    /* slices are copied as they are, without looking for a null character */
+    {
+        static const char text[] = { 'h', 'e', 'l', 'l', 'o', 'w', 'o', 'r', 'l', 'd' };
+        fs_slice words[2];
+        char buf[64];
+        fs_size r;
+
+        words[0].ptr = text;
+        words[0].len = 5;
+        words[1].ptr = text + 5;
+        words[1].len = 5;
+        DOTEST_EXT(1024, "[hello][world]", 14, "[%v][%#v]", (fs_size)5, text, &words[1]);
+        DOTEST_EXT(1024, "[  HEL][wor  ]", 14, "[%5.3V][%-5.*v]", (fs_size)5, text, 3, (fs_size)5, text + 5);
+        DOTEST_EXT(1024, "[]", 2, "[%v]", (fs_size)0, (const char *)NULL);
+        DOTEST_EXT(6, "[hell", 7, "[%#v]", &words[0]);
+        DOSTREAMTEST(2, "helloworld|", "%v|", (fs_size)10, text);
+
+        r = fs_format_parallel(buf, sizeof buf, "%.4v ", words, 2, 2, backwards_scheduler, NULL);
+        if (r != 10 || strcmp(buf, "hell worl ") != 0)
+        {
+            printf("  [ERROR]: %%v in parallel, '%s'\n", buf);
+            exit(1);
+        }
+    }
+#else
+    DOTEST_EXT(1024, "[]|7", 4, "[%v]|%d", (fs_size)5, "hello", 7);
+#endif /* FS_NO_SLICE */
+
+#ifndef FS_NO_ESCAPE
+    /* escaped strings */
+    {
+        DOTEST_EXT(1024, "say \\\"hi\\\"\\n\\u0001\\u001F\\\\ \xc3\xa9", 29, 
+                "say %Q", "\"hi\"\n\x01\x1f\\ \xc3\xa9");
+        DOTEST_EXT(1024, "tab\\there\\a\\001\\177\\v", 21, 
+                "%#q", "tab\there\a\001\177\v");
+        DOTEST_EXT(1024, "[  a\\nb][a   ]", 14, "[%6q][%-4.1q]", "a\nb", "ab");
+        DOTEST_EXT(1024, "[a\\\"]", 5, "[%.2q]", "a\"bcd");
+        DOTEST_EXT(8, "\\\"\\\"\\\"\\", 12, "%q", "\"\"\"\"\"\"");
+        DOSTREAMTEST(3, "<a long clean run before the \\\"quote\\\">", 
+                "<%q>", "a long clean run before the \"quote\"");
+
+        /* resumed from where each piece stopped, in pieces of every size */
+        {
+            static const char text[] = "a\tlong \"run\" with\x01 escapes\\ and a clean tail";
+            char out[256], expect[256];
+            fs_size chunk;
+
+            fs_snprintf(expect, sizeof expect, "<%60q|%-60Q|%#.20q>", text, text, text);
+            for (chunk = 1; chunk < 12; chunk += 1)
+            {
+                stream_format(out, chunk, "<%60q|%-60Q|%#.20q>", text, text, text);
+                if (strcmp(out, expect) != 0)
+                {
+                    printf("  [ERROR]: %%q in pieces of %d was '%s'\n", (int)chunk, out);
+                    exit(1);
+                }
+            }
+        }
+
+        /* every element pads on its own, the same as one serial call */
+        {
+            static const char *strs[3] = { "abcdefgh", "x", "yy" };
+            char out[256], expect[256];
+            fs_size r;
+
+            fs_snprintf(expect, sizeof expect, "[%10q][%10q][%10q]", strs[0], strs[1], strs[2]);
+            r = fs_format_parallel(out, sizeof out, "[%10q]", strs, 3, 1, backwards_scheduler, NULL);
+            if (r != 36 || strcmp(out, expect) != 0)
+            {
+                printf("  [ERROR]: %%q in parallel was '%s'\n", out);
+                exit(1);
+            }
+        }
+    }
+#else
+    DOTEST_EXT(1024, "[]|7", 4, "[%q]|%d", "a\nb", 7);
+#endif /* FS_NO_ESCAPE */
+
+#ifndef FS_NO_BASE64
+    /* base64, checked against RFC 4648 */
+    {
+        static unsigned char blob[1000];
+        static char encoded[1400], truncated[700];
+        static const unsigned char bytes[] = { 0xfb, 0xff, 0xbf, 0x00, 0x10 };
+        fs_size i;
+
+        DOTEST_EXT(1024, "[][Zg==][Zm8=][Zm9v][Zm9vYmFy]", 30, "[%r][%r][%r][%r][%r]", 
+                (fs_size)0, "", (fs_size)1, "foobar", (fs_size)2, "foobar", 
+                (fs_size)3, "foobar", (fs_size)6, "foobar");
+        DOTEST_EXT(1024, "+/+/ABA=|-_-_ABA=|    -_8=|+/+/", 31, "%r|%#r|%#8.2r|%-3.3r", 
+                (fs_size)5, bytes, (fs_size)5, bytes, (fs_size)5, bytes, (fs_size)5, bytes);
+        DOTEST_EXT(6, "Zm9vY", 8, "%r", (fs_size)6, "foobar");
+        DOSTREAMTEST(3, "<Zm9vYmFy>", "<%r>", (fs_size)6, "foobar");
+
+        /* long enough for the vector encoder and the chunked path */
+        for (i = 0; i < sizeof blob; i += 1)
+            blob[i] = (unsigned char)(i * 7 + i / 256);
+        fs_snprintf(encoded, sizeof encoded, "%r", sizeof blob, blob);
+        for (i = 0; i < sizeof blob; i += 3)
+        {
+            fs_size n = sizeof blob - i < 3 ? sizeof blob - i : 3;
+            char group[5];
+            fs_snprintf(group, sizeof group, "%r", n, blob + i);
+            if (memcmp(group, encoded + i / 3 * 4, 4) != 0)
+            {
+                printf("  [ERROR]: base64 of a long blob differs at %d\n", (int)i);
+                exit(1);
+            }
+        }
+        for (i = 1; i < 12; i += 5)
+        {
+            static char streamed[1400];
+            stream_format(streamed, i, "%r", sizeof blob, blob);
+            if (strcmp(streamed, encoded) != 0)
+            {
+                printf("  [ERROR]: base64 of a long blob in pieces of %d\n", (int)i);
+                exit(1);
+            }
+        }
+        if (fs_snprintf(truncated, sizeof truncated, "%r", sizeof blob, blob) != 1336 
+        || strlen(truncated) != 699 || memcmp(truncated, encoded, 699) != 0)
+        {
+            printf("  [ERROR]: base64 of a long blob was not truncated\n");
+            exit(1);
+        }
+        printf("  test base64 passed\n");
+    }
+#else
+    DOTEST_EXT(1024, "[]|7", 4, "[%r]|%d", (fs_size)6, "foobar", 7);
+#endif /* FS_NO_BASE64 */
+
+#ifndef FS_NO_LAZY
+    /* lazy strings are not produced when nothing of them fits */
+    {
+        int calls = 0;
+        int truncated = 0;
+        fs_lazy frames;
+        char buf[16];
+
+        frames.produce = produce_test_frames;
+        frames.ctx = &calls;
+        DOTEST_EXT(1024, "trace: frame 0 frame 1 frame 2 frame 3|", 39, "trace:%y|", &frames);
+        DOTEST_EXT(1024, "[ frame 0 frame 1 frame 2 frame 3  ]", 36, "[%-34y]", &frames);
+        DOTEST_EXT(10, "trace: fr", 39, "trace:%y|", &frames);
+        DOSTREAMTEST(5, "trace: frame 0 frame 1 frame 2 frame 3|", "trace:%y|", &frames);
+        calls = 0;
+        if (15 != fs_snprintf_trunc(buf, sizeof buf, &truncated, "a long prefix: %y", &frames)
+        || !truncated || 1 != calls || 
+        15 != fs_snprintf_trunc(buf, sizeof buf, &truncated, "a long prefix: %8y", &frames)
+        || !truncated || 1 != calls || 
+        13 != fs_snprintf_trunc(buf, 14, &truncated, "trace:%y|", &frames)
+        || !truncated || 2 != calls || strcmp(buf, "trace: frame ") != 0)
+        {
+            printf("  [ERROR]: lazy string with fs_snprintf_trunc, %d calls\n", calls);
+            exit(1);
+        }
+        printf("  test lazy strings passed\n");
+    }
+
+    /* a lazy string that fills the buffer exactly is not cut off, 
+     * and is produced once per piece */
+    {
+        static char out[4096];
+        test_letters letters;
+        fs_lazy lazy;
+        char buf[8];
+        int truncated = 0;
+
+        printf("[INFO]: Now test lazy strings that fill the buffer exactly\n");
+        lazy.produce = produce_test_letters;
+        lazy.ctx = &letters;
+        letters.calls = 0;
+        letters.len = 4;
+        if (4 != fs_snprintf_trunc(buf, 5, &truncated, "%y", &lazy) 
+        || truncated || 1 != letters.calls || strcmp(buf, "abcd") != 0)
+        {
+            printf("  [ERROR]: exact lazy string with fs_snprintf_trunc, %d calls\n", letters.calls);
+            exit(1);
+        }
+        letters.calls = 0;
+        letters.len = 4000;
+        if (4000 != stream_format(out, 4, "%y", &lazy) || 1000 != letters.calls
+        || memcmp(out + 3996, "stuv", 4) != 0)
+        {
+            printf("  [ERROR]: lazy string in pieces, %d calls\n", letters.calls);
+            exit(1);
+        }
+        printf("  test lazy strings that fill the buffer exactly passed\n");
+    }
+#else
+    DOTEST_EXT(1024, "[]|7", 4, "[%y]|%d", (const void *)NULL, 7);
+#endif /* FS_NO_LAZY */
+
+    {
+        /* FS_CPU_* features to run the bulk endian kernels with, the scalar loop first */
+        static const unsigned s_endian_features[] = { 0, FS_CPU_SSSE3, FS_CPU_SSE2 | FS_CPU_SSSE3 | FS_CPU_AVX2 };
+        static const unsigned s_elem_sizes[] = { 2, 4, 8 };
+        unsigned char src[520], dst[520], expected[520];
+        unsigned features = fs_cpu_features();
+        unsigned f, e, count, offset, i;
+
+        printf("[INFO]: Now test the bulk endian conversions\n");
+        for (i = 0; i < sizeof src; i += 1)
+            src[i] = (unsigned char)(i * 7 + 3);
+        for (f = 0; f < FS_STATIC_ARRAYSIZE(s_endian_features); f += 1)
+        {
+            if ((s_endian_features[f] & features) != s_endian_features[f])
+                continue;
+            for (e = 0; e < FS_STATIC_ARRAYSIZE(s_elem_sizes); e += 1)
+            for (count = 0; count * s_elem_sizes[e] + 3 <= 512; count += 1 + count / 8)
+            for (offset = 0; offset < 4; offset += 1)
+            {
+                unsigned size = s_elem_sizes[e];
+#ifdef FS_CPU_X86_64
+                s_fs_internal_endian_features = s_endian_features[f];
+#endif /* FS_CPU_X86_64 */
+
+                memcpy(dst, src, sizeof dst);
+                memcpy(expected, src, sizeof expected);
+                for (i = 0; i < count * size; i += size)
+                    fs_endian_bswap(expected + offset + i, size);
+                switch (size)
+                {
+                case 2: fs_endian_host_to_big16(dst + offset, count); break;
+                case 4: fs_endian_host_to_big32(dst + offset, count); break;
+                case 8: fs_endian_host_to_big64(dst + offset, count); break;
+                }
+                if (FS_ENDIAN_IS(FS_ENDIAN_BIG))
+                    memcpy(expected, src, sizeof expected);
+
+                if (memcmp(dst, expected, sizeof dst) != 0)
+                {
+                    printf("  [ERROR]: host to big endian of %u elements of %u at %u, features %x\n", 
+                        count, size, offset, s_endian_features[f]);
+                    exit(1);
+                }
+                fs_endian_host_to_big16(dst + offset, 0);
+                fs_endian_host_to_little32(dst + offset, count * size / 4);
+                fs_endian_host_to_little(dst + offset, count * size / 8, 8);
+                if (FS_ENDIAN_IS(FS_ENDIAN_LITTLE) && memcmp(dst, expected, sizeof dst) != 0)
+                {
+                    printf("  [ERROR]: host to little endian of %u bytes, features %x\n", 
+                        count * size, s_endian_features[f]);
+                    exit(1);
+                }
+            }
+        }
+#ifdef FS_CPU_X86_64
+        s_fs_internal_endian_features = ~0u;
+#endif /* FS_CPU_X86_64 */
+        if (0x3412 != fs_endian_bswap16(0x1234) || 0x78563412 != fs_endian_bswap32(0x12345678)
+#ifdef FS_64BIT_DEFINED
+        || 0xEFCDAB8967452301llu != fs_endian_bswap64(0x0123456789ABCDEFllu)
+#endif /* FS_64BIT_DEFINED */
+        )
+        {
+            printf("  [ERROR]: single value byte swaps\n");
+            exit(1);
+        }
+        printf("  test bulk endian conversions passed\n");
+    }
+
+    {
+        union {
+            fs_u8 bytes[4];
+            fs_u32 u32;
+        } probe = {{0, 1, 2, 3}};
+        fs_fu32 float_probe;
+
+        printf("[INFO]: Now test the byte order detection\n");
+        float_probe.f = 2.0f;
+        if (FS_ENDIANNESS() != probe.u32 || !FS_ENDIAN_IS(probe.u32)
+        || FS_FLOAT_ENDIAN_DIFFER() != (float_probe.u32 < 0x00008000))
+        {
+            printf("  [ERROR]: byte order %08lx, probed %08lx\n", 
+                (unsigned long)FS_ENDIANNESS(), (unsigned long)probe.u32);
+            exit(1);
+        }
+        printf("  test byte order detection passed\n");
+    }
 
+    {
+        static unsigned char src[300], a[320], b[320];
+        fs_size n, off, len;
+        int ok = 1;
+
+        printf("[INFO]: Now test fs_mem.h against libc\n");
+        for (n = 0; n < sizeof src; n += 1)
+            src[n] = (unsigned char)(n * 13 + 1);
+        for (len = 0; ok && len < 200; len += 1)
+        for (off = 0; ok && off < 2 * sizeof(fs_size) + 1; off += 1)
+        {
+            memset(a, '#', sizeof a);
+            memset(b, '#', sizeof b);
+            ok = fs_memcpy(a + off, src + 2 * off % 7, len) == a + off;
+            memcpy(b + off, src + 2 * off % 7, len);
+            ok = ok && fs_memset(a + 220 + off % 5, 'z' + (int)off, len % 90) == a + 220 + off % 5;
+            memset(b + 220 + off % 5, 'z' + (int)off, len % 90);
+            ok = ok && memcmp(a, b, sizeof a) == 0;
+
+            /* src holds no zeros, a terminator is put at len */
+            src[off + len] = 0;
+            ok = ok && fs_strnlen((const char *)src + off, len + off % 3) == len
+                && fs_strnlen((const char *)src + off, len / 2) == len / 2;
+            src[off + len] = (unsigned char)((off + len) * 13 + 1);
+            if (0 == src[off + len])
+                src[off + len] = 1;
+
+            ok = ok && fs_memchr(src + off, src[off + len], len) == memchr(src + off, src[off + len], len)
+                && fs_memchr(src + off, src[off + len], len + 1) == memchr(src + off, src[off + len], len + 1);
+        }
+        if (!ok)
+        {
+            printf("  [ERROR]: fs_mem.h with length %d at offset %d\n", (int)len - 1, (int)off - 1);
+            exit(1);
+        }
+        printf("  test fs_mem.h passed\n");
+    }
 
     printf("All basic tests passed!\n");
     return 0;
@@ -1475,4 +5687,58 @@ int main(void)
 
 
 
+#ifdef SNPRINTF_BENCH
+
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS 2000000L
+
+/** average time of one call, in nanoseconds */
+#define BENCH(label, ...) do { \
+    clock_t start = clock(); \
+    long i; \
+    for (i = 0; i < BENCH_ITERATIONS; i += 1) \
+        sink += fs_snprintf(buf, sizeof buf, __VA_ARGS__); \
+    printf("  %-28s %8.1f ns\n", label, \
+        (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / BENCH_ITERATIONS); \
+} while (0)
+
+
+/** bench program */
+int main(void)
+{
+    static const fs_u8 addr[4] = {192, 168, 100, 254};
+    static char buf[256];
+    volatile long sink = 0;
+    int level = fs_snprintf_dispatch();
+
+    printf("[INFO]: %s profile, kernel level %d%s\n",
+#ifdef FS_PROFILE_SPEED
+        "speed",
+#else
+        "size",
+#endif /* FS_PROFILE_SPEED */
+        level,
+#ifdef FS_FORMAT_CACHE
+        ", format cache"
+#else
+        ""
+#endif /* FS_FORMAT_CACHE */
+        );
+    BENCH("%d", "%d", 1234567);
+    BENCH("%llu", "%llu", 18446744073709551615ull);
+    BENCH("%x", "%x", 0xDEADBEEFu);
+    BENCH("%p", "%p", (void *)buf);
+    BENCH("%I4", "%I4", addr);
+    BENCH("%k", "%k", 1700000000, 123456L);
+    BENCH("%.3f", "%.3f", 3.14159);
+    BENCH("%s", "%s", "a string of some length");
+    BENCH("log line", "%k [%5s] %I4 %d/%d %#x", 
+        1700000000, 123456L, "info", addr, 200, 4096, 0xBEEFu);
+    BENCH("request line", "%-8s %5d %-24s %3d %8.3d %08x %s", 
+        "GET", 80, "/index.html", 200, 512, 0xBEEFu, "-");
+    return sink == 0;
+}
 
+#endif /* SNPRINTF_BENCH */
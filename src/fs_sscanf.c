@@ -0,0 +1,426 @@
+#include <stdarg.h>
+#include "../include/fs_int.h"
+#include "../include/fs_sscanf.h"
+#include "../include/fs_strtoul.h"
+#include "../include/fs_strtod.h"
+#include "../include/fs_standard.h"
+
+
+
+#ifdef DEBUG_TEST
+#  define SSCANF_TEST
+#endif /* DEBUG_TEST */
+
+
+/* a number cut short by a width is copied, longer widths do not matter for numbers */
+#define FIELD_BUFSIZE 128
+
+
+
+/* a parsed conversion specification */
+typedef struct fs_scan_spec
+{
+    int suppress;
+    int width; /* 0 if none */
+    int l_count;
+    int conv;
+} fs_scan_spec;
+
+
+
+static const char *skip_space(const char *s)
+{
+    while (fs_is_space(*s))
+        s += 1;
+    return s;
+}
+
+
+static const char *parse_scan_spec(const char *fmt, fs_scan_spec *spec)
+{
+    spec->suppress = ('*' == *fmt);
+    if (spec->suppress)
+        fmt += 1;
+
+    spec->width = 0;
+    while ('0' <= *fmt && *fmt <= '9')
+    {
+        spec->width = spec->width * 10 + (*fmt - '0');
+        fmt += 1;
+    }
+
+    spec->l_count = 0;
+    if ('l' == *fmt)
+    {
+        fmt += 1;
+        spec->l_count = 1;
+        if ('l' == *fmt)
+        {
+            fmt += 1;
+            spec->l_count = 2;
+        }
+    }
+
+    spec->conv = *fmt;
+    if ('A' <= spec->conv && spec->conv <= 'Z')
+        spec->conv += 'a' - 'A';
+    if (*fmt)
+        fmt += 1;
+    return fmt;
+}
+
+
+/* the text of a numeric field, copied to buf if the width ends it early */
+static const char *field_text(const char *s, int width, char *buf)
+{
+    int i;
+
+    if (0 == width)
+        return s;
+    if (width > FIELD_BUFSIZE - 1)
+        width = FIELD_BUFSIZE - 1;
+    for (i = 0; i < width && s[i]; i += 1)
+        buf[i] = s[i];
+    buf[i] = '\0';
+    return buf;
+}
+
+
+/* an integer conversion, returns the characters read or 0 if there was no number */
+static int scan_integer(const char *s, const fs_scan_spec *spec, va_list *ap)
+{
+    char buf[FIELD_BUFSIZE];
+    const char *text = field_text(s, spec->width, buf);
+    char *end;
+    int base;
+
+    switch (spec->conv)
+    {
+    case 'i': base = 0; break;
+    case 'x': 
+    case 'p': base = 16; break;
+    default: base = 10; break;
+    }
+
+#ifdef FS_64BIT_DEFINED
+    if (2 == spec->l_count || ('p' == spec->conv && sizeof(void *) > sizeof(long)))
+    {
+        unsigned long long n = fs_strtoull(text, &end, base);
+        if (end == text)
+            return 0;
+        if (spec->suppress)
+            return (int)(end - text);
+
+        if ('p' == spec->conv)
+            *va_arg(*ap, void **) = (void *)(uintptr_t)n;
+        else if ('u' == spec->conv || 'x' == spec->conv)
+            *va_arg(*ap, unsigned long long *) = n;
+        else
+            *va_arg(*ap, long long *) = (long long)n;
+        return (int)(end - text);
+    }
+#endif /* FS_64BIT_DEFINED */
+
+    {
+        unsigned long n = fs_strtoul(text, &end, base);
+        if (end == text)
+            return 0;
+        if (spec->suppress)
+            return (int)(end - text);
+
+        if ('p' == spec->conv)
+            *va_arg(*ap, void **) = (void *)(uintptr_t)n;
+        else if ('u' == spec->conv || 'x' == spec->conv)
+        {
+            if (spec->l_count)
+                *va_arg(*ap, unsigned long *) = n;
+            else
+                *va_arg(*ap, unsigned *) = (unsigned)n;
+        }
+        else
+        {
+            if (spec->l_count)
+                *va_arg(*ap, long *) = (long)n;
+            else
+                *va_arg(*ap, int *) = (int)n;
+        }
+        return (int)(end - text);
+    }
+}
+
+
+/* a floating point conversion, returns the characters read or 0 if there was no number */
+static int scan_float(const char *s, const fs_scan_spec *spec, va_list *ap)
+{
+    char buf[FIELD_BUFSIZE];
+    const char *text = field_text(s, spec->width, buf);
+    char *end;
+    double d = fs_strtod(text, &end);
+
+    if (end == text)
+        return 0;
+    if (!spec->suppress)
+    {
+        switch (spec->l_count)
+        {
+        case 0: *va_arg(*ap, float *) = (float)d; break;
+        case 1: *va_arg(*ap, double *) = d; break;
+        default: *va_arg(*ap, long double *) = d; break;
+        }
+    }
+    return (int)(end - text);
+}
+
+
+static void store_count(const fs_scan_spec *spec, long count, va_list *ap)
+{
+    if (spec->suppress)
+        return;
+    switch (spec->l_count)
+    {
+    case 0: *va_arg(*ap, int *) = (int)count; break;
+    case 1: *va_arg(*ap, long *) = count; break;
+#ifdef FS_64BIT_DEFINED
+    default: *va_arg(*ap, long long *) = count; break;
+#else
+    default: *va_arg(*ap, long *) = count; break;
+#endif /* FS_64BIT_DEFINED */
+    }
+}
+
+
+
+int fs_vsscanf(const char *str, const char *fmt, va_list ap)
+{
+    const char *s = str;
+    int assigned = 0;
+    int conversions = 0;
+    int len;
+    char *dst;
+    fs_scan_spec spec;
+    va_list args;
+
+    /* a copy that can be passed on by pointer */
+    FS_VA_COPY(args, ap);
+    while (*fmt)
+    {
+        if (fs_is_space(*fmt))
+        {
+            fmt = skip_space(fmt);
+            s = skip_space(s);
+            continue;
+        }
+        if ('%' != *fmt || '%' == fmt[1])
+        {
+            if ('%' == *fmt)
+            {
+                fmt += 1;
+                s = skip_space(s);
+            }
+            if (*s != *fmt)
+                goto input_end;
+            s += 1;
+            fmt += 1;
+            continue;
+        }
+
+        fmt = parse_scan_spec(fmt + 1, &spec);
+        if ('n' == spec.conv)
+        {
+            store_count(&spec, (long)(s - str), &args);
+            continue;
+        }
+        if ('c' != spec.conv)
+            s = skip_space(s);
+        if ('\0' == *s)
+            goto input_end;
+
+        switch (spec.conv)
+        {
+        case 'd': case 'i': case 'u': case 'x': case 'p':
+            len = scan_integer(s, &spec, &args);
+            break;
+
+        case 'f': case 'g':
+            len = scan_float(s, &spec, &args);
+            break;
+
+        case 's':
+            dst = spec.suppress ? NULL : va_arg(args, char *);
+            for (len = 0; s[len] && !fs_is_space(s[len]) 
+                && (0 == spec.width || len < spec.width); len += 1)
+            {
+                if (NULL != dst)
+                    dst[len] = s[len];
+            }
+            if (NULL != dst)
+                dst[len] = '\0';
+            break;
+
+        case 'c':
+            if (0 == spec.width)
+                spec.width = 1;
+            dst = spec.suppress ? NULL : va_arg(args, char *);
+            for (len = 0; len < spec.width && s[len]; len += 1)
+            {
+                if (NULL != dst)
+                    dst[len] = s[len];
+            }
+            if (len < spec.width)
+                goto input_end;
+            break;
+
+        default: 
+            goto done;
+        }
+        if (0 == len)
+            goto done;
+
+        s += len;
+        conversions += 1;
+        if (!spec.suppress)
+            assigned += 1;
+    }
+    goto done;
+
+input_end:
+    if (0 == conversions && '\0' == *s)
+        assigned = -1;
+done:
+    va_end(args);
+    return assigned;
+}
+
+
+int fs_sscanf(const char *str, const char *fmt, ...)
+{
+    va_list args;
+    int ret;
+
+    va_start(args, fmt);
+    ret = fs_vsscanf(str, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+
+
+
+#ifdef SSCANF_TEST
+
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+
+
+#ifndef FS_C99
+#  error "at least C99 is required for testing code"
+#endif /* FS_C99 */
+
+
+
+/** 
+ * scans str with fs_sscanf and the system sscanf, the arguments point into 
+ * vals, an array of 4 type, and n, an int, which are compared as bytes afterwards
+ */
+#define DOTEST(type, str, fmt, ...) do { \
+    type fs_vals[4]; \
+    type sys_vals[4]; \
+    int fs_n = -1, sys_n = -1; \
+    int fs_r, sys_r; \
+    type *vals = fs_vals; \
+    int *n = &fs_n; \
+    printf("[INFO]: Now test \"%s\" with \"%s\"\n", str, fmt); \
+    memset(fs_vals, 0, sizeof fs_vals); \
+    memset(sys_vals, 0, sizeof sys_vals); \
+    fs_r = fs_sscanf(str, fmt, __VA_ARGS__); \
+    vals = sys_vals; \
+    n = &sys_n; \
+    sys_r = sscanf(str, fmt, __VA_ARGS__); \
+    (void)vals; (void)n; \
+    if (fs_r != sys_r || memcmp(fs_vals, sys_vals, sizeof fs_vals) != 0 || fs_n != sys_n) { \
+        printf("  [ERROR]: returned %d, expected %d\n", fs_r, sys_r); \
+        exit(1); \
+    } \
+    printf("  test(%d) passed\n", fs_r); \
+} while (0)
+
+
+int main(void)
+{
+    DOTEST(int, "12 -34", "%d %d", &vals[0], &vals[1]);
+    DOTEST(int, "12-34", "%d%d", &vals[0], &vals[1]);
+    DOTEST(int, "  0x1f 017", "%i %i", &vals[0], &vals[1]);
+    DOTEST(int, "123456", "%3d%d", &vals[0], &vals[1]);
+    DOTEST(int, "12,34", "%d,%d%n", &vals[0], &vals[1], n);
+    DOTEST(int, "12, 34", "%d , %d%n", &vals[0], &vals[1], n);
+    DOTEST(int, "12;34", "%d,%d", &vals[0], &vals[1]);
+    DOTEST(int, "x", "%d", &vals[0]);
+    DOTEST(int, "", "%d", &vals[0]);
+    DOTEST(int, "   ", "%d", &vals[0]);
+    DOTEST(int, "7", "%d %d", &vals[0], &vals[1]);
+    DOTEST(int, "1 2", "%*d %d", &vals[0]);
+    DOTEST(int, "100% 5", "%d%% %d", &vals[0], &vals[1]);
+    DOTEST(int, "2147483647 -2147483648", "%d %d", &vals[0], &vals[1]);
+    DOTEST(unsigned, "4294967295 ff", "%u %x", &vals[0], &vals[1]);
+    DOTEST(unsigned, "DEADbeef 0x10", "%X %x", &vals[0], &vals[1]);
+    DOTEST(long, "-9223372036854775807 9", "%ld %ld", &vals[0], &vals[1]);
+    DOTEST(long long, "-9223372036854775807 -1", "%lld %lld", &vals[0], &vals[1]);
+    DOTEST(unsigned long long, "18446744073709551615", "%llu", &vals[0]);
+    DOTEST(float, "1.5 -2.25e3", "%f %g", &vals[0], &vals[1]);
+    DOTEST(double, "0.1 1e-300", "%lf %lG", &vals[0], &vals[1]);
+    DOTEST(double, "3.14159 inf", "%4lf%lf", &vals[0], &vals[1]);
+    DOTEST(double, "nan 1.", "%lf%lf%n", &vals[0], &vals[1], n);
+    DOTEST(char, "ab", "%c%c", &vals[0], &vals[1]);
+    DOTEST(char, " a b", "%c%c", &vals[0], &vals[1]);
+    DOTEST(char, " a b", " %c %c%n", &vals[0], &vals[1], n);
+    DOTEST(char, "abcd", "%3c%c", &vals[0], &vals[3]);
+    DOTEST(char, "abc", "%2c%n", &vals[0], n);
+    DOTEST(void *, "0x7ffd1234 deadbeef", "%p %p", &vals[0], &vals[1]);
+
+    {
+        char fs_words[2][16], sys_words[2][16];
+        int fs_n = -1, sys_n = -1;
+        int fs_r, sys_r;
+
+        printf("[INFO]: Now test %%s\n");
+        memset(fs_words, 'x', sizeof fs_words);
+        memset(sys_words, 'x', sizeof sys_words);
+        fs_r = fs_sscanf(" hello\tworld!  ", "%s%5s%n", fs_words[0], fs_words[1], &fs_n);
+        sys_r = sscanf(" hello\tworld!  ", "%s%5s%n", sys_words[0], sys_words[1], &sys_n);
+        if (fs_r != sys_r || fs_n != sys_n || memcmp(fs_words, sys_words, sizeof fs_words) != 0
+        || fs_sscanf("key=value", "key=%s", fs_words[0]) != 1 || strcmp(fs_words[0], "value") != 0
+        || fs_sscanf("", "%s", fs_words[0]) != -1)
+        {
+            printf("  [ERROR]: %%s returned %d, expected %d\n", fs_r, sys_r);
+            exit(1);
+        }
+        printf("  test %%s passed\n");
+    }
+
+    {
+        int year, month, day, n;
+        char name[16];
+        double value;
+        long double ld;
+
+        printf("[INFO]: Now test a record\n");
+        if (fs_sscanf("2024-03-15 temperature 21.5 C", "%d-%d-%d %15s %lf C%n", 
+            &year, &month, &day, name, &value, &n) != 5
+        || 2024 != year || 3 != month || 15 != day || strcmp(name, "temperature") != 0
+        || 21.5 != value || 29 != n
+        || fs_sscanf("0.25", "%llg", &ld) != 1 || 0.25 != ld)
+        {
+            printf("  [ERROR]: record\n");
+            exit(1);
+        }
+        printf("  test record passed\n");
+    }
+
+    printf("All sscanf tests passed!\n");
+    return 0;
+}
+#endif /* SSCANF_TEST */
@@ -0,0 +1,1516 @@
+#include "../include/fs_int.h"
+#include "../include/fs_strtod.h"
+#include "../include/fs_standard.h"
+#include "../include/fs_ieee754.h"
+
+
+
+#ifdef DEBUG_TEST
+#  define STRTOD_TEST
+#endif /* DEBUG_TEST */
+
+
+#define DOUBLE_MANTISSA_BITS 52
+#define DOUBLE_MIN_EXPONENT (-1023)
+#define DOUBLE_INF_EXPONENT 0x7FF
+
+/* digits kept by the slow path, more than the 767 that can matter */
+#define DECIMAL_MAX_DIGITS 800
+#define DECIMAL_POINT_RANGE 2047
+/* shifts of the slow path, its arithmetic stays in 32 bits */
+#define DECIMAL_MAX_SHIFT 28
+
+#define EXPONENT_LIMIT 100000 /* larger exponents are all 0 or inf */
+
+
+
+/* a double as its parts, before it is assembled by fs_double_from_parts() */
+typedef struct fs_double_parts
+{
+    fs_u32 exponent; /* biased */
+    fs_u32 mantissa_hi; /* top 20 bits of the mantissa */
+    fs_u32 mantissa_lo;
+} fs_double_parts;
+
+
+/* 
+ * a decimal number 0.d[0]d[1]... * 10^decimal_point, 
+ * truncated is set if nonzero digits were dropped past DECIMAL_MAX_DIGITS 
+ */
+typedef struct fs_decimal
+{
+    int num_digits;
+    int decimal_point;
+    int truncated;
+    unsigned char d[DECIMAL_MAX_DIGITS];
+} fs_decimal;
+
+
+
+/* matches word at s ignoring case, word is lowercase, returns its length or 0 */
+static int match_word(const char *s, const char *word)
+{
+    int i = 0;
+    for (; word[i]; i += 1)
+    {
+        if (s[i] != word[i] && s[i] != word[i] - 32)
+            return 0;
+    }
+    return i;
+}
+
+
+static void set_parts(fs_double_parts *parts, fs_u32 exponent, fs_u32 hi, fs_u32 lo)
+{
+    parts->exponent = exponent;
+    parts->mantissa_hi = hi;
+    parts->mantissa_lo = lo;
+}
+
+
+
+
+/*
+ * the slow path, simple decimal conversion as in Nigel Tao's writeup 
+ * and the Go and fast_float libraries: the decimal is shifted 
+ * by powers of 2 until it is in [1/2, 1), then its mantissa bits are read off. 
+ * correct for every input, only used when the fast path cannot decide
+ */
+
+/* drops trailing zeros */
+static void decimal_trim(fs_decimal *dec)
+{
+    while (dec->num_digits > 0 && 0 == dec->d[dec->num_digits - 1])
+        dec->num_digits -= 1;
+}
+
+
+/* parses the digits of [s, end), which is a valid mantissa and exponent */
+static void decimal_parse(fs_decimal *dec, const char *s, const char *end)
+{
+    int exponent = 0;
+    int negative_exp = 0;
+    int seen_point = 0;
+
+    dec->num_digits = 0;
+    dec->decimal_point = 0;
+    dec->truncated = 0;
+
+    for (; s < end && 'e' != *s && 'E' != *s; s += 1)
+    {
+        if ('.' == *s)
+        {
+            seen_point = 1;
+            continue;
+        }
+        if (0 == dec->num_digits && '0' == *s)
+        {
+            /* leading zeros only move the point */
+            if (seen_point)
+                dec->decimal_point -= 1;
+            continue;
+        }
+        if (!seen_point)
+            dec->decimal_point += 1;
+        if (dec->num_digits < DECIMAL_MAX_DIGITS)
+        {
+            dec->d[dec->num_digits] = (unsigned char)(*s - '0');
+            dec->num_digits += 1;
+        }
+        else if ('0' != *s)
+            dec->truncated = 1;
+    }
+
+    if (s < end)
+    {
+        s += 1; /* 'e' */
+        if ('-' == *s || '+' == *s)
+        {
+            negative_exp = ('-' == *s);
+            s += 1;
+        }
+        for (; s < end; s += 1)
+        {
+            if (exponent < EXPONENT_LIMIT)
+                exponent = exponent * 10 + (*s - '0');
+        }
+        dec->decimal_point += negative_exp ? -exponent : exponent;
+    }
+    decimal_trim(dec);
+}
+
+
+/* divides by 2^shift */
+static void decimal_right_shift(fs_decimal *dec, int shift)
+{
+    const fs_u32 mask = ((fs_u32)1 << shift) - 1;
+    fs_u32 n = 0;
+    int r = 0, w = 0;
+    unsigned char digit;
+
+    /* the first digits until the quotient is nonzero */
+    for (; 0 == (n >> shift); r += 1)
+    {
+        if (r >= dec->num_digits)
+        {
+            if (0 == n)
+            {
+                dec->num_digits = 0;
+                return;
+            }
+            while (0 == (n >> shift))
+            {
+                n *= 10;
+                r += 1;
+            }
+            break;
+        }
+        n = n * 10 + dec->d[r];
+    }
+    dec->decimal_point -= r - 1;
+
+    for (; r < dec->num_digits; r += 1)
+    {
+        digit = dec->d[r];
+        dec->d[w] = (unsigned char)(n >> shift);
+        w += 1;
+        n = (n & mask) * 10 + digit;
+    }
+    while (n > 0)
+    {
+        digit = (unsigned char)(n >> shift);
+        n = (n & mask) * 10;
+        if (w < DECIMAL_MAX_DIGITS)
+        {
+            dec->d[w] = digit;
+            w += 1;
+        }
+        else if (digit > 0)
+            dec->truncated = 1;
+    }
+    dec->num_digits = w;
+    decimal_trim(dec);
+}
+
+
+/* multiplies by 2^shift, 
+ * the digits are written backwards to a scratch array first */
+static void decimal_left_shift(fs_decimal *dec, int shift)
+{
+    unsigned char scratch[DECIMAL_MAX_DIGITS + 10];
+    fs_u32 n = 0;
+    int i, count = 0;
+
+    for (i = dec->num_digits; i--;)
+    {
+        n += (fs_u32)dec->d[i] << shift;
+        scratch[count] = (unsigned char)(n % 10);
+        count += 1;
+        n /= 10;
+    }
+    for (; n > 0; n /= 10)
+    {
+        scratch[count] = (unsigned char)(n % 10);
+        count += 1;
+    }
+    dec->decimal_point += count - dec->num_digits;
+
+    /* the least significant digits are dropped */
+    if (count > DECIMAL_MAX_DIGITS)
+    {
+        for (i = 0; i < count - DECIMAL_MAX_DIGITS; i += 1)
+        {
+            if (scratch[i])
+                dec->truncated = 1;
+        }
+        dec->num_digits = DECIMAL_MAX_DIGITS;
+    }
+    else dec->num_digits = count;
+
+    for (i = 0; i < dec->num_digits; i += 1)
+        dec->d[i] = scratch[count - 1 - i];
+    decimal_trim(dec);
+}
+
+
+/* takes the integer part out, which must be less than 2^32, leaving the fraction */
+static fs_u32 decimal_take_int(fs_decimal *dec)
+{
+    fs_u32 n = 0;
+    int i, zeros;
+
+    if (dec->decimal_point <= 0)
+        return 0;
+    for (i = 0; i < dec->decimal_point; i += 1)
+        n = n * 10 + (i < dec->num_digits ? dec->d[i] : 0);
+
+    if (dec->num_digits <= dec->decimal_point)
+        dec->num_digits = 0;
+    else
+    {
+        dec->num_digits -= dec->decimal_point;
+        for (i = 0; i < dec->num_digits; i += 1)
+            dec->d[i] = dec->d[i + dec->decimal_point];
+    }
+    dec->decimal_point = 0;
+
+    /* 0.0012 is stored as 0.12 * 10^-2 */
+    for (zeros = 0; zeros < dec->num_digits && 0 == dec->d[zeros]; zeros += 1)
+    {}
+    dec->num_digits -= zeros;
+    dec->decimal_point -= zeros;
+    for (i = 0; i < dec->num_digits; i += 1)
+        dec->d[i] = dec->d[i + zeros];
+    return n;
+}
+
+
+/* whether the fraction left by decimal_take_int() rounds n up, ties to even */
+static int decimal_round_up(const fs_decimal *dec, fs_u32 n)
+{
+    int i;
+
+    if (0 == dec->num_digits || dec->decimal_point < 0 || dec->d[0] < 5)
+        return 0;
+    if (dec->d[0] > 5 || dec->truncated)
+        return 1;
+    for (i = 1; i < dec->num_digits; i += 1)
+    {
+        if (dec->d[i])
+            return 1;
+    }
+    return n & 1;
+}
+
+
+static void decimal_to_parts(fs_decimal *dec, fs_double_parts *parts)
+{
+    /* shifts that keep the decimal point from crossing 0, by its distance from it */
+    static const unsigned char s_shifts[] = { 0, 3, 6, 9, 13, 16, 19, 23, 26 };
+    int exp2 = 0;
+    int shift;
+    fs_u32 hi, lo;
+
+    set_parts(parts, 0, 0, 0);
+    if (0 == dec->num_digits || dec->decimal_point < -324)
+        return;
+    if (dec->decimal_point >= 310)
+        goto infinity;
+
+    while (dec->decimal_point > 0)
+    {
+        shift = dec->decimal_point < (int)sizeof s_shifts 
+            ? s_shifts[dec->decimal_point] : DECIMAL_MAX_SHIFT;
+        decimal_right_shift(dec, shift);
+        exp2 += shift;
+    }
+    /* to [1/2, 1) */
+    while (dec->decimal_point <= 0)
+    {
+        if (0 == dec->decimal_point)
+        {
+            if (dec->d[0] >= 5)
+                break;
+            shift = dec->d[0] < 2 ? 2 : 1;
+        }
+        else shift = -dec->decimal_point < (int)sizeof s_shifts 
+            ? s_shifts[-dec->decimal_point] : DECIMAL_MAX_SHIFT;
+        decimal_left_shift(dec, shift);
+        if (dec->decimal_point > DECIMAL_POINT_RANGE)
+            goto infinity;
+        exp2 -= shift;
+    }
+    /* the mantissa is in [1, 2) */
+    exp2 -= 1;
+
+    /* subnormals */
+    while (DOUBLE_MIN_EXPONENT + 1 > exp2)
+    {
+        shift = DOUBLE_MIN_EXPONENT + 1 - exp2;
+        if (shift > DECIMAL_MAX_SHIFT)
+            shift = DECIMAL_MAX_SHIFT;
+        decimal_right_shift(dec, shift);
+        exp2 += shift;
+    }
+    if (exp2 - DOUBLE_MIN_EXPONENT >= DOUBLE_INF_EXPONENT)
+        goto infinity;
+
+    /* the 53 bits of the mantissa, 21 then 32, then rounded */
+    decimal_left_shift(dec, 21);
+    hi = decimal_take_int(dec);
+    decimal_left_shift(dec, 16);
+    decimal_left_shift(dec, 16);
+    lo = decimal_take_int(dec);
+    if (decimal_round_up(dec, lo))
+    {
+        lo += 1;
+        if (0 == lo)
+            hi += 1;
+    }
+    if (hi >> 21)
+    {
+        /* rounded up to 2^53 */
+        hi >>= 1;
+        exp2 += 1;
+        if (exp2 - DOUBLE_MIN_EXPONENT >= DOUBLE_INF_EXPONENT)
+            goto infinity;
+    }
+
+    parts->exponent = (fs_u32)(exp2 - DOUBLE_MIN_EXPONENT);
+    if (0 == (hi >> 20))
+        parts->exponent -= 1; /* subnormal */
+    parts->mantissa_hi = hi & 0xFFFFF;
+    parts->mantissa_lo = lo;
+    return;
+
+infinity:
+    set_parts(parts, DOUBLE_INF_EXPONENT, 0, 0);
+}
+
+
+
+
+#ifdef FS_64BIT_DEFINED
+
+/*
+ * the fast path, the Eisel-Lemire algorithm as in Daniel Lemire's 
+ * "Number Parsing at a Gigabyte per Second": 
+ * w * 10^q is w * 5^q * 2^q, the 128 bit truncation of 5^q normalized 
+ * gives the product with w to within an error that is almost always too small to 
+ * change the rounding, the rest go to the slow path
+ */
+
+#define POW5_MIN_EXPONENT (-342)
+#define POW5_MAX_EXPONENT 308
+#define ROUND_TO_EVEN_MIN_EXPONENT (-4) /* ties are only possible in this range */
+#define ROUND_TO_EVEN_MAX_EXPONENT 23
+#define MAX_EXACT_DIGITS 19 /* of w */
+
+/* 5^q normalized to [2^127, 2^128), truncated, high then low 64 bits */
+static const fs_u64 s_pow5_128[POW5_MAX_EXPONENT - POW5_MIN_EXPONENT + 1][2] = {
+    {0xeef453d6923bd65allu, 0x113faa2906a13b3fllu},
+    {0x9558b4661b6565f8llu, 0x4ac7ca59a424c507llu},
+    {0xbaaee17fa23ebf76llu, 0x5d79bcf00d2df649llu}, /* 5^-340 */
+    {0xe95a99df8ace6f53llu, 0xf4d82c2c107973dcllu},
+    {0x91d8a02bb6c10594llu, 0x79071b9b8a4be869llu},
+    {0xb64ec836a47146f9llu, 0x9748e2826cdee284llu},
+    {0xe3e27a444d8d98b7llu, 0xfd1b1b2308169b25llu},
+    {0x8e6d8c6ab0787f72llu, 0xfe30f0f5e50e20f7llu},
+    {0xb208ef855c969f4fllu, 0xbdbd2d335e51a935llu},
+    {0xde8b2b66b3bc4723llu, 0xad2c788035e61382llu},
+    {0x8b16fb203055ac76llu, 0x4c3bcb5021afcc31llu},
+    {0xaddcb9e83c6b1793llu, 0xdf4abe242a1bbf3dllu},
+    {0xd953e8624b85dd78llu, 0xd71d6dad34a2af0dllu}, /* 5^-330 */
+    {0x87d4713d6f33aa6bllu, 0x8672648c40e5ad68llu},
+    {0xa9c98d8ccb009506llu, 0x680efdaf511f18c2llu},
+    {0xd43bf0effdc0ba48llu, 0x0212bd1b2566def2llu},
+    {0x84a57695fe98746dllu, 0x014bb630f7604b57llu},
+    {0xa5ced43b7e3e9188llu, 0x419ea3bd35385e2dllu},
+    {0xcf42894a5dce35eallu, 0x52064cac828675b9llu},
+    {0x818995ce7aa0e1b2llu, 0x7343efebd1940993llu},
+    {0xa1ebfb4219491a1fllu, 0x1014ebe6c5f90bf8llu},
+    {0xca66fa129f9b60a6llu, 0xd41a26e077774ef6llu},
+    {0xfd00b897478238d0llu, 0x8920b098955522b4llu}, /* 5^-320 */
+    {0x9e20735e8cb16382llu, 0x55b46e5f5d5535b0llu},
+    {0xc5a890362fddbc62llu, 0xeb2189f734aa831dllu},
+    {0xf712b443bbd52b7bllu, 0xa5e9ec7501d523e4llu},
+    {0x9a6bb0aa55653b2dllu, 0x47b233c92125366ellu},
+    {0xc1069cd4eabe89f8llu, 0x999ec0bb696e840allu},
+    {0xf148440a256e2c76llu, 0xc00670ea43ca250dllu},
+    {0x96cd2a865764dbcallu, 0x380406926a5e5728llu},
+    {0xbc807527ed3e12bcllu, 0xc605083704f5ecf2llu},
+    {0xeba09271e88d976bllu, 0xf7864a44c633682ellu},
+    {0x93445b8731587ea3llu, 0x7ab3ee6afbe0211dllu}, /* 5^-310 */
+    {0xb8157268fdae9e4cllu, 0x5960ea05bad82964llu},
+    {0xe61acf033d1a45dfllu, 0x6fb92487298e33bdllu},
+    {0x8fd0c16206306babllu, 0xa5d3b6d479f8e056llu},
+    {0xb3c4f1ba87bc8696llu, 0x8f48a4899877186cllu},
+    {0xe0b62e2929aba83cllu, 0x331acdabfe94de87llu},
+    {0x8c71dcd9ba0b4925llu, 0x9ff0c08b7f1d0b14llu},
+    {0xaf8e5410288e1b6fllu, 0x07ecf0ae5ee44dd9llu},
+    {0xdb71e91432b1a24allu, 0xc9e82cd9f69d6150llu},
+    {0x892731ac9faf056ellu, 0xbe311c083a225cd2llu},
+    {0xab70fe17c79ac6callu, 0x6dbd630a48aaf406llu}, /* 5^-300 */
+    {0xd64d3d9db981787dllu, 0x092cbbccdad5b108llu},
+    {0x85f0468293f0eb4ellu, 0x25bbf56008c58ea5llu},
+    {0xa76c582338ed2621llu, 0xaf2af2b80af6f24ellu},
+    {0xd1476e2c07286faallu, 0x1af5af660db4aee1llu},
+    {0x82cca4db847945callu, 0x50d98d9fc890ed4dllu},
+    {0xa37fce126597973cllu, 0xe50ff107bab528a0llu},
+    {0xcc5fc196fefd7d0cllu, 0x1e53ed49a96272c8llu},
+    {0xff77b1fcbebcdc4fllu, 0x25e8e89c13bb0f7allu},
+    {0x9faacf3df73609b1llu, 0x77b191618c54e9acllu},
+    {0xc795830d75038c1dllu, 0xd59df5b9ef6a2417llu}, /* 5^-290 */
+    {0xf97ae3d0d2446f25llu, 0x4b0573286b44ad1dllu},
+    {0x9becce62836ac577llu, 0x4ee367f9430aec32llu},
+    {0xc2e801fb244576d5llu, 0x229c41f793cda73fllu},
+    {0xf3a20279ed56d48allu, 0x6b43527578c1110fllu},
+    {0x9845418c345644d6llu, 0x830a13896b78aaa9llu},
+    {0xbe5691ef416bd60cllu, 0x23cc986bc656d553llu},
+    {0xedec366b11c6cb8fllu, 0x2cbfbe86b7ec8aa8llu},
+    {0x94b3a202eb1c3f39llu, 0x7bf7d71432f3d6a9llu},
+    {0xb9e08a83a5e34f07llu, 0xdaf5ccd93fb0cc53llu},
+    {0xe858ad248f5c22c9llu, 0xd1b3400f8f9cff68llu}, /* 5^-280 */
+    {0x91376c36d99995bellu, 0x23100809b9c21fa1llu},
+    {0xb58547448ffffb2dllu, 0xabd40a0c2832a78allu},
+    {0xe2e69915b3fff9f9llu, 0x16c90c8f323f516cllu},
+    {0x8dd01fad907ffc3bllu, 0xae3da7d97f6792e3llu},
+    {0xb1442798f49ffb4allu, 0x99cd11cfdf41779cllu},
+    {0xdd95317f31c7fa1dllu, 0x40405643d711d583llu},
+    {0x8a7d3eef7f1cfc52llu, 0x482835ea666b2572llu},
+    {0xad1c8eab5ee43b66llu, 0xda3243650005eecfllu},
+    {0xd863b256369d4a40llu, 0x90bed43e40076a82llu},
+    {0x873e4f75e2224e68llu, 0x5a7744a6e804a291llu}, /* 5^-270 */
+    {0xa90de3535aaae202llu, 0x711515d0a205cb36llu},
+    {0xd3515c2831559a83llu, 0x0d5a5b44ca873e03llu},
+    {0x8412d9991ed58091llu, 0xe858790afe9486c2llu},
+    {0xa5178fff668ae0b6llu, 0x626e974dbe39a872llu},
+    {0xce5d73ff402d98e3llu, 0xfb0a3d212dc8128fllu},
+    {0x80fa687f881c7f8ellu, 0x7ce66634bc9d0b99llu},
+    {0xa139029f6a239f72llu, 0x1c1fffc1ebc44e80llu},
+    {0xc987434744ac874ellu, 0xa327ffb266b56220llu},
+    {0xfbe9141915d7a922llu, 0x4bf1ff9f0062baa8llu},
+    {0x9d71ac8fada6c9b5llu, 0x6f773fc3603db4a9llu}, /* 5^-260 */
+    {0xc4ce17b399107c22llu, 0xcb550fb4384d21d3llu},
+    {0xf6019da07f549b2bllu, 0x7e2a53a146606a48llu},
+    {0x99c102844f94e0fbllu, 0x2eda7444cbfc426dllu},
+    {0xc0314325637a1939llu, 0xfa911155fefb5308llu},
+    {0xf03d93eebc589f88llu, 0x793555ab7eba27callu},
+    {0x96267c7535b763b5llu, 0x4bc1558b2f3458dellu},
+    {0xbbb01b9283253ca2llu, 0x9eb1aaedfb016f16llu},
+    {0xea9c227723ee8bcbllu, 0x465e15a979c1cadcllu},
+    {0x92a1958a7675175fllu, 0x0bfacd89ec191ec9llu},
+    {0xb749faed14125d36llu, 0xcef980ec671f667bllu}, /* 5^-250 */
+    {0xe51c79a85916f484llu, 0x82b7e12780e7401allu},
+    {0x8f31cc0937ae58d2llu, 0xd1b2ecb8b0908810llu},
+    {0xb2fe3f0b8599ef07llu, 0x861fa7e6dcb4aa15llu},
+    {0xdfbdcece67006ac9llu, 0x67a791e093e1d49allu},
+    {0x8bd6a141006042bdllu, 0xe0c8bb2c5c6d24e0llu},
+    {0xaecc49914078536dllu, 0x58fae9f773886e18llu},
+    {0xda7f5bf590966848llu, 0xaf39a475506a899ellu},
+    {0x888f99797a5e012dllu, 0x6d8406c952429603llu},
+    {0xaab37fd7d8f58178llu, 0xc8e5087ba6d33b83llu},
+    {0xd5605fcdcf32e1d6llu, 0xfb1e4a9a90880a64llu}, /* 5^-240 */
+    {0x855c3be0a17fcd26llu, 0x5cf2eea09a55067fllu},
+    {0xa6b34ad8c9dfc06fllu, 0xf42faa48c0ea481ellu},
+    {0xd0601d8efc57b08bllu, 0xf13b94daf124da26llu},
+    {0x823c12795db6ce57llu, 0x76c53d08d6b70858llu},
+    {0xa2cb1717b52481edllu, 0x54768c4b0c64ca6ellu},
+    {0xcb7ddcdda26da268llu, 0xa9942f5dcf7dfd09llu},
+    {0xfe5d54150b090b02llu, 0xd3f93b35435d7c4cllu},
+    {0x9efa548d26e5a6e1llu, 0xc47bc5014a1a6dafllu},
+    {0xc6b8e9b0709f109allu, 0x359ab6419ca1091bllu},
+    {0xf867241c8cc6d4c0llu, 0xc30163d203c94b62llu}, /* 5^-230 */
+    {0x9b407691d7fc44f8llu, 0x79e0de63425dcf1dllu},
+    {0xc21094364dfb5636llu, 0x985915fc12f542e4llu},
+    {0xf294b943e17a2bc4llu, 0x3e6f5b7b17b2939dllu},
+    {0x979cf3ca6cec5b5allu, 0xa705992ceecf9c42llu},
+    {0xbd8430bd08277231llu, 0x50c6ff782a838353llu},
+    {0xece53cec4a314ebdllu, 0xa4f8bf5635246428llu},
+    {0x940f4613ae5ed136llu, 0x871b7795e136be99llu},
+    {0xb913179899f68584llu, 0x28e2557b59846e3fllu},
+    {0xe757dd7ec07426e5llu, 0x331aeada2fe589cfllu},
+    {0x9096ea6f3848984fllu, 0x3ff0d2c85def7621llu}, /* 5^-220 */
+    {0xb4bca50b065abe63llu, 0x0fed077a756b53a9llu},
+    {0xe1ebce4dc7f16dfbllu, 0xd3e8495912c62894llu},
+    {0x8d3360f09cf6e4bdllu, 0x64712dd7abbbd95cllu},
+    {0xb080392cc4349decllu, 0xbd8d794d96aacfb3llu},
+    {0xdca04777f541c567llu, 0xecf0d7a0fc5583a0llu},
+    {0x89e42caaf9491b60llu, 0xf41686c49db57244llu},
+    {0xac5d37d5b79b6239llu, 0x311c2875c522ced5llu},
+    {0xd77485cb25823ac7llu, 0x7d633293366b828bllu},
+    {0x86a8d39ef77164bcllu, 0xae5dff9c02033197llu},
+    {0xa8530886b54dbdebllu, 0xd9f57f830283fdfcllu}, /* 5^-210 */
+    {0xd267caa862a12d66llu, 0xd072df63c324fd7bllu},
+    {0x8380dea93da4bc60llu, 0x4247cb9e59f71e6dllu},
+    {0xa46116538d0deb78llu, 0x52d9be85f074e608llu},
+    {0xcd795be870516656llu, 0x67902e276c921f8bllu},
+    {0x806bd9714632dff6llu, 0x00ba1cd8a3db53b6llu},
+    {0xa086cfcd97bf97f3llu, 0x80e8a40eccd228a4llu},
+    {0xc8a883c0fdaf7df0llu, 0x6122cd128006b2cdllu},
+    {0xfad2a4b13d1b5d6cllu, 0x796b805720085f81llu},
+    {0x9cc3a6eec6311a63llu, 0xcbe3303674053bb0llu},
+    {0xc3f490aa77bd60fcllu, 0xbedbfc4411068a9cllu}, /* 5^-200 */
+    {0xf4f1b4d515acb93bllu, 0xee92fb5515482d44llu},
+    {0x991711052d8bf3c5llu, 0x751bdd152d4d1c4allu},
+    {0xbf5cd54678eef0b6llu, 0xd262d45a78a0635dllu},
+    {0xef340a98172aace4llu, 0x86fb897116c87c34llu},
+    {0x9580869f0e7aac0ellu, 0xd45d35e6ae3d4da0llu},
+    {0xbae0a846d2195712llu, 0x8974836059cca109llu},
+    {0xe998d258869facd7llu, 0x2bd1a438703fc94bllu},
+    {0x91ff83775423cc06llu, 0x7b6306a34627ddcfllu},
+    {0xb67f6455292cbf08llu, 0x1a3bc84c17b1d542llu},
+    {0xe41f3d6a7377eecallu, 0x20caba5f1d9e4a93llu}, /* 5^-190 */
+    {0x8e938662882af53ellu, 0x547eb47b7282ee9cllu},
+    {0xb23867fb2a35b28dllu, 0xe99e619a4f23aa43llu},
+    {0xdec681f9f4c31f31llu, 0x6405fa00e2ec94d4llu},
+    {0x8b3c113c38f9f37ellu, 0xde83bc408dd3dd04llu},
+    {0xae0b158b4738705ellu, 0x9624ab50b148d445llu},
+    {0xd98ddaee19068c76llu, 0x3badd624dd9b0957llu},
+    {0x87f8a8d4cfa417c9llu, 0xe54ca5d70a80e5d6llu},
+    {0xa9f6d30a038d1dbcllu, 0x5e9fcf4ccd211f4cllu},
+    {0xd47487cc8470652bllu, 0x7647c3200069671fllu},
+    {0x84c8d4dfd2c63f3bllu, 0x29ecd9f40041e073llu}, /* 5^-180 */
+    {0xa5fb0a17c777cf09llu, 0xf468107100525890llu},
+    {0xcf79cc9db955c2ccllu, 0x7182148d4066eeb4llu},
+    {0x81ac1fe293d599bfllu, 0xc6f14cd848405530llu},
+    {0xa21727db38cb002fllu, 0xb8ada00e5a506a7cllu},
+    {0xca9cf1d206fdc03bllu, 0xa6d90811f0e4851cllu},
+    {0xfd442e4688bd304allu, 0x908f4a166d1da663llu},
+    {0x9e4a9cec15763e2ellu, 0x9a598e4e043287fellu},
+    {0xc5dd44271ad3cdballu, 0x40eff1e1853f29fdllu},
+    {0xf7549530e188c128llu, 0xd12bee59e68ef47cllu},
+    {0x9a94dd3e8cf578b9llu, 0x82bb74f8301958cellu}, /* 5^-170 */
+    {0xc13a148e3032d6e7llu, 0xe36a52363c1faf01llu},
+    {0xf18899b1bc3f8ca1llu, 0xdc44e6c3cb279ac1llu},
+    {0x96f5600f15a7b7e5llu, 0x29ab103a5ef8c0b9llu},
+    {0xbcb2b812db11a5dellu, 0x7415d448f6b6f0e7llu},
+    {0xebdf661791d60f56llu, 0x111b495b3464ad21llu},
+    {0x936b9fcebb25c995llu, 0xcab10dd900beec34llu},
+    {0xb84687c269ef3bfbllu, 0x3d5d514f40eea742llu},
+    {0xe65829b3046b0afallu, 0x0cb4a5a3112a5112llu},
+    {0x8ff71a0fe2c2e6dcllu, 0x47f0e785eaba72abllu},
+    {0xb3f4e093db73a093llu, 0x59ed216765690f56llu}, /* 5^-160 */
+    {0xe0f218b8d25088b8llu, 0x306869c13ec3532cllu},
+    {0x8c974f7383725573llu, 0x1e414218c73a13fbllu},
+    {0xafbd2350644eeacfllu, 0xe5d1929ef90898fallu},
+    {0xdbac6c247d62a583llu, 0xdf45f746b74abf39llu},
+    {0x894bc396ce5da772llu, 0x6b8bba8c328eb783llu},
+    {0xab9eb47c81f5114fllu, 0x066ea92f3f326564llu},
+    {0xd686619ba27255a2llu, 0xc80a537b0efefebdllu},
+    {0x8613fd0145877585llu, 0xbd06742ce95f5f36llu},
+    {0xa798fc4196e952e7llu, 0x2c48113823b73704llu},
+    {0xd17f3b51fca3a7a0llu, 0xf75a15862ca504c5llu}, /* 5^-150 */
+    {0x82ef85133de648c4llu, 0x9a984d73dbe722fbllu},
+    {0xa3ab66580d5fdaf5llu, 0xc13e60d0d2e0ebballu},
+    {0xcc963fee10b7d1b3llu, 0x318df905079926a8llu},
+    {0xffbbcfe994e5c61fllu, 0xfdf17746497f7052llu},
+    {0x9fd561f1fd0f9bd3llu, 0xfeb6ea8bedefa633llu},
+    {0xc7caba6e7c5382c8llu, 0xfe64a52ee96b8fc0llu},
+    {0xf9bd690a1b68637bllu, 0x3dfdce7aa3c673b0llu},
+    {0x9c1661a651213e2dllu, 0x06bea10ca65c084ellu},
+    {0xc31bfa0fe5698db8llu, 0x486e494fcff30a62llu},
+    {0xf3e2f893dec3f126llu, 0x5a89dba3c3efccfallu}, /* 5^-140 */
+    {0x986ddb5c6b3a76b7llu, 0xf89629465a75e01cllu},
+    {0xbe89523386091465llu, 0xf6bbb397f1135823llu},
+    {0xee2ba6c0678b597fllu, 0x746aa07ded582e2cllu},
+    {0x94db483840b717efllu, 0xa8c2a44eb4571cdcllu},
+    {0xba121a4650e4ddebllu, 0x92f34d62616ce413llu},
+    {0xe896a0d7e51e1566llu, 0x77b020baf9c81d17llu},
+    {0x915e2486ef32cd60llu, 0x0ace1474dc1d122ellu},
+    {0xb5b5ada8aaff80b8llu, 0x0d819992132456ballu},
+    {0xe3231912d5bf60e6llu, 0x10e1fff697ed6c69llu},
+    {0x8df5efabc5979c8fllu, 0xca8d3ffa1ef463c1llu}, /* 5^-130 */
+    {0xb1736b96b6fd83b3llu, 0xbd308ff8a6b17cb2llu},
+    {0xddd0467c64bce4a0llu, 0xac7cb3f6d05ddbdellu},
+    {0x8aa22c0dbef60ee4llu, 0x6bcdf07a423aa96bllu},
+    {0xad4ab7112eb3929dllu, 0x86c16c98d2c953c6llu},
+    {0xd89d64d57a607744llu, 0xe871c7bf077ba8b7llu},
+    {0x87625f056c7c4a8bllu, 0x11471cd764ad4972llu},
+    {0xa93af6c6c79b5d2dllu, 0xd598e40d3dd89bcfllu},
+    {0xd389b47879823479llu, 0x4aff1d108d4ec2c3llu},
+    {0x843610cb4bf160cbllu, 0xcedf722a585139ballu},
+    {0xa54394fe1eedb8fellu, 0xc2974eb4ee658828llu}, /* 5^-120 */
+    {0xce947a3da6a9273ellu, 0x733d226229feea32llu},
+    {0x811ccc668829b887llu, 0x0806357d5a3f525fllu},
+    {0xa163ff802a3426a8llu, 0xca07c2dcb0cf26f7llu},
+    {0xc9bcff6034c13052llu, 0xfc89b393dd02f0b5llu},
+    {0xfc2c3f3841f17c67llu, 0xbbac2078d443ace2llu},
+    {0x9d9ba7832936edc0llu, 0xd54b944b84aa4c0dllu},
+    {0xc5029163f384a931llu, 0x0a9e795e65d4df11llu},
+    {0xf64335bcf065d37dllu, 0x4d4617b5ff4a16d5llu},
+    {0x99ea0196163fa42ellu, 0x504bced1bf8e4e45llu},
+    {0xc06481fb9bcf8d39llu, 0xe45ec2862f71e1d6llu}, /* 5^-110 */
+    {0xf07da27a82c37088llu, 0x5d767327bb4e5a4cllu},
+    {0x964e858c91ba2655llu, 0x3a6a07f8d510f86fllu},
+    {0xbbe226efb628afeallu, 0x890489f70a55368bllu},
+    {0xeadab0aba3b2dbe5llu, 0x2b45ac74ccea842ellu},
+    {0x92c8ae6b464fc96fllu, 0x3b0b8bc90012929dllu},
+    {0xb77ada0617e3bbcbllu, 0x09ce6ebb40173744llu},
+    {0xe55990879ddcaabdllu, 0xcc420a6a101d0515llu},
+    {0x8f57fa54c2a9eab6llu, 0x9fa946824a12232dllu},
+    {0xb32df8e9f3546564llu, 0x47939822dc96abf9llu},
+    {0xdff9772470297ebdllu, 0x59787e2b93bc56f7llu}, /* 5^-100 */
+    {0x8bfbea76c619ef36llu, 0x57eb4edb3c55b65allu},
+    {0xaefae51477a06b03llu, 0xede622920b6b23f1llu},
+    {0xdab99e59958885c4llu, 0xe95fab368e45ecedllu},
+    {0x88b402f7fd75539bllu, 0x11dbcb0218ebb414llu},
+    {0xaae103b5fcd2a881llu, 0xd652bdc29f26a119llu},
+    {0xd59944a37c0752a2llu, 0x4be76d3346f0495fllu},
+    {0x857fcae62d8493a5llu, 0x6f70a4400c562ddbllu},
+    {0xa6dfbd9fb8e5b88ellu, 0xcb4ccd500f6bb952llu},
+    {0xd097ad07a71f26b2llu, 0x7e2000a41346a7a7llu},
+    {0x825ecc24c873782fllu, 0x8ed400668c0c28c8llu}, /* 5^-90 */
+    {0xa2f67f2dfa90563bllu, 0x728900802f0f32fallu},
+    {0xcbb41ef979346bcallu, 0x4f2b40a03ad2ffb9llu},
+    {0xfea126b7d78186bcllu, 0xe2f610c84987bfa8llu},
+    {0x9f24b832e6b0f436llu, 0x0dd9ca7d2df4d7c9llu},
+    {0xc6ede63fa05d3143llu, 0x91503d1c79720dbbllu},
+    {0xf8a95fcf88747d94llu, 0x75a44c6397ce912allu},
+    {0x9b69dbe1b548ce7cllu, 0xc986afbe3ee11aballu},
+    {0xc24452da229b021bllu, 0xfbe85badce996168llu},
+    {0xf2d56790ab41c2a2llu, 0xfae27299423fb9c3llu},
+    {0x97c560ba6b0919a5llu, 0xdccd879fc967d41allu}, /* 5^-80 */
+    {0xbdb6b8e905cb600fllu, 0x5400e987bbc1c920llu},
+    {0xed246723473e3813llu, 0x290123e9aab23b68llu},
+    {0x9436c0760c86e30bllu, 0xf9a0b6720aaf6521llu},
+    {0xb94470938fa89bcellu, 0xf808e40e8d5b3e69llu},
+    {0xe7958cb87392c2c2llu, 0xb60b1d1230b20e04llu},
+    {0x90bd77f3483bb9b9llu, 0xb1c6f22b5e6f48c2llu},
+    {0xb4ecd5f01a4aa828llu, 0x1e38aeb6360b1af3llu},
+    {0xe2280b6c20dd5232llu, 0x25c6da63c38de1b0llu},
+    {0x8d590723948a535fllu, 0x579c487e5a38ad0ellu},
+    {0xb0af48ec79ace837llu, 0x2d835a9df0c6d851llu}, /* 5^-70 */
+    {0xdcdb1b2798182244llu, 0xf8e431456cf88e65llu},
+    {0x8a08f0f8bf0f156bllu, 0x1b8e9ecb641b58ffllu},
+    {0xac8b2d36eed2dac5llu, 0xe272467e3d222f3fllu},
+    {0xd7adf884aa879177llu, 0x5b0ed81dcc6abb0fllu},
+    {0x86ccbb52ea94baeallu, 0x98e947129fc2b4e9llu},
+    {0xa87fea27a539e9a5llu, 0x3f2398d747b36224llu},
+    {0xd29fe4b18e88640ellu, 0x8eec7f0d19a03aadllu},
+    {0x83a3eeeef9153e89llu, 0x1953cf68300424acllu},
+    {0xa48ceaaab75a8e2bllu, 0x5fa8c3423c052dd7llu},
+    {0xcdb02555653131b6llu, 0x3792f412cb06794dllu}, /* 5^-60 */
+    {0x808e17555f3ebf11llu, 0xe2bbd88bbee40bd0llu},
+    {0xa0b19d2ab70e6ed6llu, 0x5b6aceaeae9d0ec4llu},
+    {0xc8de047564d20a8bllu, 0xf245825a5a445275llu},
+    {0xfb158592be068d2ellu, 0xeed6e2f0f0d56712llu},
+    {0x9ced737bb6c4183dllu, 0x55464dd69685606bllu},
+    {0xc428d05aa4751e4cllu, 0xaa97e14c3c26b886llu},
+    {0xf53304714d9265dfllu, 0xd53dd99f4b3066a8llu},
+    {0x993fe2c6d07b7fabllu, 0xe546a8038efe4029llu},
+    {0xbf8fdb78849a5f96llu, 0xde98520472bdd033llu},
+    {0xef73d256a5c0f77cllu, 0x963e66858f6d4440llu}, /* 5^-50 */
+    {0x95a8637627989aadllu, 0xdde7001379a44aa8llu},
+    {0xbb127c53b17ec159llu, 0x5560c018580d5d52llu},
+    {0xe9d71b689dde71afllu, 0xaab8f01e6e10b4a6llu},
+    {0x9226712162ab070dllu, 0xcab3961304ca70e8llu},
+    {0xb6b00d69bb55c8d1llu, 0x3d607b97c5fd0d22llu},
+    {0xe45c10c42a2b3b05llu, 0x8cb89a7db77c506allu},
+    {0x8eb98a7a9a5b04e3llu, 0x77f3608e92adb242llu},
+    {0xb267ed1940f1c61cllu, 0x55f038b237591ed3llu},
+    {0xdf01e85f912e37a3llu, 0x6b6c46dec52f6688llu},
+    {0x8b61313bbabce2c6llu, 0x2323ac4b3b3da015llu}, /* 5^-40 */
+    {0xae397d8aa96c1b77llu, 0xabec975e0a0d081allu},
+    {0xd9c7dced53c72255llu, 0x96e7bd358c904a21llu},
+    {0x881cea14545c7575llu, 0x7e50d64177da2e54llu},
+    {0xaa242499697392d2llu, 0xdde50bd1d5d0b9e9llu},
+    {0xd4ad2dbfc3d07787llu, 0x955e4ec64b44e864llu},
+    {0x84ec3c97da624ab4llu, 0xbd5af13bef0b113ellu},
+    {0xa6274bbdd0fadd61llu, 0xecb1ad8aeacdd58ellu},
+    {0xcfb11ead453994ballu, 0x67de18eda5814af2llu},
+    {0x81ceb32c4b43fcf4llu, 0x80eacf948770ced7llu},
+    {0xa2425ff75e14fc31llu, 0xa1258379a94d028dllu}, /* 5^-30 */
+    {0xcad2f7f5359a3b3ellu, 0x096ee45813a04330llu},
+    {0xfd87b5f28300ca0dllu, 0x8bca9d6e188853fcllu},
+    {0x9e74d1b791e07e48llu, 0x775ea264cf55347ellu},
+    {0xc612062576589ddallu, 0x95364afe032a819ellu},
+    {0xf79687aed3eec551llu, 0x3a83ddbd83f52205llu},
+    {0x9abe14cd44753b52llu, 0xc4926a9672793543llu},
+    {0xc16d9a0095928a27llu, 0x75b7053c0f178294llu},
+    {0xf1c90080baf72cb1llu, 0x5324c68b12dd6339llu},
+    {0x971da05074da7beellu, 0xd3f6fc16ebca5e04llu},
+    {0xbce5086492111aeallu, 0x88f4bb1ca6bcf585llu}, /* 5^-20 */
+    {0xec1e4a7db69561a5llu, 0x2b31e9e3d06c32e6llu},
+    {0x9392ee8e921d5d07llu, 0x3aff322e62439fd0llu},
+    {0xb877aa3236a4b449llu, 0x09befeb9fad487c3llu},
+    {0xe69594bec44de15bllu, 0x4c2ebe687989a9b4llu},
+    {0x901d7cf73ab0acd9llu, 0x0f9d37014bf60a11llu},
+    {0xb424dc35095cd80fllu, 0x538484c19ef38c95llu},
+    {0xe12e13424bb40e13llu, 0x2865a5f206b06fballu},
+    {0x8cbccc096f5088cbllu, 0xf93f87b7442e45d4llu},
+    {0xafebff0bcb24aafellu, 0xf78f69a51539d749llu},
+    {0xdbe6fecebdedd5bellu, 0xb573440e5a884d1cllu}, /* 5^-10 */
+    {0x89705f4136b4a597llu, 0x31680a88f8953031llu},
+    {0xabcc77118461cefcllu, 0xfdc20d2b36ba7c3ellu},
+    {0xd6bf94d5e57a42bcllu, 0x3d32907604691b4dllu},
+    {0x8637bd05af6c69b5llu, 0xa63f9a49c2c1b110llu},
+    {0xa7c5ac471b478423llu, 0x0fcf80dc33721d54llu},
+    {0xd1b71758e219652bllu, 0xd3c36113404ea4a9llu},
+    {0x83126e978d4fdf3bllu, 0x645a1cac083126eallu},
+    {0xa3d70a3d70a3d70allu, 0x3d70a3d70a3d70a4llu},
+    {0xccccccccccccccccllu, 0xcccccccccccccccdllu},
+    {0x8000000000000000llu, 0x0000000000000000llu}, /* 5^0 */
+    {0xa000000000000000llu, 0x0000000000000000llu},
+    {0xc800000000000000llu, 0x0000000000000000llu},
+    {0xfa00000000000000llu, 0x0000000000000000llu},
+    {0x9c40000000000000llu, 0x0000000000000000llu},
+    {0xc350000000000000llu, 0x0000000000000000llu},
+    {0xf424000000000000llu, 0x0000000000000000llu},
+    {0x9896800000000000llu, 0x0000000000000000llu},
+    {0xbebc200000000000llu, 0x0000000000000000llu},
+    {0xee6b280000000000llu, 0x0000000000000000llu},
+    {0x9502f90000000000llu, 0x0000000000000000llu}, /* 5^10 */
+    {0xba43b74000000000llu, 0x0000000000000000llu},
+    {0xe8d4a51000000000llu, 0x0000000000000000llu},
+    {0x9184e72a00000000llu, 0x0000000000000000llu},
+    {0xb5e620f480000000llu, 0x0000000000000000llu},
+    {0xe35fa931a0000000llu, 0x0000000000000000llu},
+    {0x8e1bc9bf04000000llu, 0x0000000000000000llu},
+    {0xb1a2bc2ec5000000llu, 0x0000000000000000llu},
+    {0xde0b6b3a76400000llu, 0x0000000000000000llu},
+    {0x8ac7230489e80000llu, 0x0000000000000000llu},
+    {0xad78ebc5ac620000llu, 0x0000000000000000llu}, /* 5^20 */
+    {0xd8d726b7177a8000llu, 0x0000000000000000llu},
+    {0x878678326eac9000llu, 0x0000000000000000llu},
+    {0xa968163f0a57b400llu, 0x0000000000000000llu},
+    {0xd3c21bcecceda100llu, 0x0000000000000000llu},
+    {0x84595161401484a0llu, 0x0000000000000000llu},
+    {0xa56fa5b99019a5c8llu, 0x0000000000000000llu},
+    {0xcecb8f27f4200f3allu, 0x0000000000000000llu},
+    {0x813f3978f8940984llu, 0x4000000000000000llu},
+    {0xa18f07d736b90be5llu, 0x5000000000000000llu},
+    {0xc9f2c9cd04674edellu, 0xa400000000000000llu}, /* 5^30 */
+    {0xfc6f7c4045812296llu, 0x4d00000000000000llu},
+    {0x9dc5ada82b70b59dllu, 0xf020000000000000llu},
+    {0xc5371912364ce305llu, 0x6c28000000000000llu},
+    {0xf684df56c3e01bc6llu, 0xc732000000000000llu},
+    {0x9a130b963a6c115cllu, 0x3c7f400000000000llu},
+    {0xc097ce7bc90715b3llu, 0x4b9f100000000000llu},
+    {0xf0bdc21abb48db20llu, 0x1e86d40000000000llu},
+    {0x96769950b50d88f4llu, 0x1314448000000000llu},
+    {0xbc143fa4e250eb31llu, 0x17d955a000000000llu},
+    {0xeb194f8e1ae525fdllu, 0x5dcfab0800000000llu}, /* 5^40 */
+    {0x92efd1b8d0cf37bellu, 0x5aa1cae500000000llu},
+    {0xb7abc627050305adllu, 0xf14a3d9e40000000llu},
+    {0xe596b7b0c643c719llu, 0x6d9ccd05d0000000llu},
+    {0x8f7e32ce7bea5c6fllu, 0xe4820023a2000000llu},
+    {0xb35dbf821ae4f38bllu, 0xdda2802c8a800000llu},
+    {0xe0352f62a19e306ellu, 0xd50b2037ad200000llu},
+    {0x8c213d9da502de45llu, 0x4526f422cc340000llu},
+    {0xaf298d050e4395d6llu, 0x9670b12b7f410000llu},
+    {0xdaf3f04651d47b4cllu, 0x3c0cdd765f114000llu},
+    {0x88d8762bf324cd0fllu, 0xa5880a69fb6ac800llu}, /* 5^50 */
+    {0xab0e93b6efee0053llu, 0x8eea0d047a457a00llu},
+    {0xd5d238a4abe98068llu, 0x72a4904598d6d880llu},
+    {0x85a36366eb71f041llu, 0x47a6da2b7f864750llu},
+    {0xa70c3c40a64e6c51llu, 0x999090b65f67d924llu},
+    {0xd0cf4b50cfe20765llu, 0xfff4b4e3f741cf6dllu},
+    {0x82818f1281ed449fllu, 0xbff8f10e7a8921a4llu},
+    {0xa321f2d7226895c7llu, 0xaff72d52192b6a0dllu},
+    {0xcbea6f8ceb02bb39llu, 0x9bf4f8a69f764490llu},
+    {0xfee50b7025c36a08llu, 0x02f236d04753d5b4llu},
+    {0x9f4f2726179a2245llu, 0x01d762422c946590llu}, /* 5^60 */
+    {0xc722f0ef9d80aad6llu, 0x424d3ad2b7b97ef5llu},
+    {0xf8ebad2b84e0d58bllu, 0xd2e0898765a7deb2llu},
+    {0x9b934c3b330c8577llu, 0x63cc55f49f88eb2fllu},
+    {0xc2781f49ffcfa6d5llu, 0x3cbf6b71c76b25fbllu},
+    {0xf316271c7fc3908allu, 0x8bef464e3945ef7allu},
+    {0x97edd871cfda3a56llu, 0x97758bf0e3cbb5acllu},
+    {0xbde94e8e43d0c8ecllu, 0x3d52eeed1cbea317llu},
+    {0xed63a231d4c4fb27llu, 0x4ca7aaa863ee4bddllu},
+    {0x945e455f24fb1cf8llu, 0x8fe8caa93e74ef6allu},
+    {0xb975d6b6ee39e436llu, 0xb3e2fd538e122b44llu}, /* 5^70 */
+    {0xe7d34c64a9c85d44llu, 0x60dbbca87196b616llu},
+    {0x90e40fbeea1d3a4allu, 0xbc8955e946fe31cdllu},
+    {0xb51d13aea4a488ddllu, 0x6babab6398bdbe41llu},
+    {0xe264589a4dcdab14llu, 0xc696963c7eed2dd1llu},
+    {0x8d7eb76070a08aecllu, 0xfc1e1de5cf543ca2llu},
+    {0xb0de65388cc8ada8llu, 0x3b25a55f43294bcbllu},
+    {0xdd15fe86affad912llu, 0x49ef0eb713f39ebellu},
+    {0x8a2dbf142dfcc7abllu, 0x6e3569326c784337llu},
+    {0xacb92ed9397bf996llu, 0x49c2c37f07965404llu},
+    {0xd7e77a8f87daf7fbllu, 0xdc33745ec97be906llu}, /* 5^80 */
+    {0x86f0ac99b4e8dafdllu, 0x69a028bb3ded71a3llu},
+    {0xa8acd7c0222311bcllu, 0xc40832ea0d68ce0cllu},
+    {0xd2d80db02aabd62bllu, 0xf50a3fa490c30190llu},
+    {0x83c7088e1aab65dbllu, 0x792667c6da79e0fallu},
+    {0xa4b8cab1a1563f52llu, 0x577001b891185938llu},
+    {0xcde6fd5e09abcf26llu, 0xed4c0226b55e6f86llu},
+    {0x80b05e5ac60b6178llu, 0x544f8158315b05b4llu},
+    {0xa0dc75f1778e39d6llu, 0x696361ae3db1c721llu},
+    {0xc913936dd571c84cllu, 0x03bc3a19cd1e38e9llu},
+    {0xfb5878494ace3a5fllu, 0x04ab48a04065c723llu}, /* 5^90 */
+    {0x9d174b2dcec0e47bllu, 0x62eb0d64283f9c76llu},
+    {0xc45d1df942711d9allu, 0x3ba5d0bd324f8394llu},
+    {0xf5746577930d6500llu, 0xca8f44ec7ee36479llu},
+    {0x9968bf6abbe85f20llu, 0x7e998b13cf4e1ecbllu},
+    {0xbfc2ef456ae276e8llu, 0x9e3fedd8c321a67ellu},
+    {0xefb3ab16c59b14a2llu, 0xc5cfe94ef3ea101ellu},
+    {0x95d04aee3b80ece5llu, 0xbba1f1d158724a12llu},
+    {0xbb445da9ca61281fllu, 0x2a8a6e45ae8edc97llu},
+    {0xea1575143cf97226llu, 0xf52d09d71a3293bdllu},
+    {0x924d692ca61be758llu, 0x593c2626705f9c56llu}, /* 5^100 */
+    {0xb6e0c377cfa2e12ellu, 0x6f8b2fb00c77836cllu},
+    {0xe498f455c38b997allu, 0x0b6dfb9c0f956447llu},
+    {0x8edf98b59a373fecllu, 0x4724bd4189bd5eacllu},
+    {0xb2977ee300c50fe7llu, 0x58edec91ec2cb657llu},
+    {0xdf3d5e9bc0f653e1llu, 0x2f2967b66737e3edllu},
+    {0x8b865b215899f46cllu, 0xbd79e0d20082ee74llu},
+    {0xae67f1e9aec07187llu, 0xecd8590680a3aa11llu},
+    {0xda01ee641a708de9llu, 0xe80e6f4820cc9495llu},
+    {0x884134fe908658b2llu, 0x3109058d147fdcddllu},
+    {0xaa51823e34a7eedellu, 0xbd4b46f0599fd415llu}, /* 5^110 */
+    {0xd4e5e2cdc1d1ea96llu, 0x6c9e18ac7007c91allu},
+    {0x850fadc09923329ellu, 0x03e2cf6bc604ddb0llu},
+    {0xa6539930bf6bff45llu, 0x84db8346b786151cllu},
+    {0xcfe87f7cef46ff16llu, 0xe612641865679a63llu},
+    {0x81f14fae158c5f6ellu, 0x4fcb7e8f3f60c07ellu},
+    {0xa26da3999aef7749llu, 0xe3be5e330f38f09dllu},
+    {0xcb090c8001ab551cllu, 0x5cadf5bfd3072cc5llu},
+    {0xfdcb4fa002162a63llu, 0x73d9732fc7c8f7f6llu},
+    {0x9e9f11c4014dda7ellu, 0x2867e7fddcdd9afallu},
+    {0xc646d63501a1511dllu, 0xb281e1fd541501b8llu}, /* 5^120 */
+    {0xf7d88bc24209a565llu, 0x1f225a7ca91a4226llu},
+    {0x9ae757596946075fllu, 0x3375788de9b06958llu},
+    {0xc1a12d2fc3978937llu, 0x0052d6b1641c83aellu},
+    {0xf209787bb47d6b84llu, 0xc0678c5dbd23a49allu},
+    {0x9745eb4d50ce6332llu, 0xf840b7ba963646e0llu},
+    {0xbd176620a501fbffllu, 0xb650e5a93bc3d898llu},
+    {0xec5d3fa8ce427affllu, 0xa3e51f138ab4cebellu},
+    {0x93ba47c980e98cdfllu, 0xc66f336c36b10137llu},
+    {0xb8a8d9bbe123f017llu, 0xb80b0047445d4184llu},
+    {0xe6d3102ad96cec1dllu, 0xa60dc059157491e5llu}, /* 5^130 */
+    {0x9043ea1ac7e41392llu, 0x87c89837ad68db2fllu},
+    {0xb454e4a179dd1877llu, 0x29babe4598c311fbllu},
+    {0xe16a1dc9d8545e94llu, 0xf4296dd6fef3d67allu},
+    {0x8ce2529e2734bb1dllu, 0x1899e4a65f58660cllu},
+    {0xb01ae745b101e9e4llu, 0x5ec05dcff72e7f8fllu},
+    {0xdc21a1171d42645dllu, 0x76707543f4fa1f73llu},
+    {0x899504ae72497eballu, 0x6a06494a791c53a8llu},
+    {0xabfa45da0edbde69llu, 0x0487db9d17636892llu},
+    {0xd6f8d7509292d603llu, 0x45a9d2845d3c42b6llu},
+    {0x865b86925b9bc5c2llu, 0x0b8a2392ba45a9b2llu}, /* 5^140 */
+    {0xa7f26836f282b732llu, 0x8e6cac7768d7141ellu},
+    {0xd1ef0244af2364ffllu, 0x3207d795430cd926llu},
+    {0x8335616aed761f1fllu, 0x7f44e6bd49e807b8llu},
+    {0xa402b9c5a8d3a6e7llu, 0x5f16206c9c6209a6llu},
+    {0xcd036837130890a1llu, 0x36dba887c37a8c0fllu},
+    {0x802221226be55a64llu, 0xc2494954da2c9789llu},
+    {0xa02aa96b06deb0fdllu, 0xf2db9baa10b7bd6cllu},
+    {0xc83553c5c8965d3dllu, 0x6f92829494e5acc7llu},
+    {0xfa42a8b73abbf48cllu, 0xcb772339ba1f17f9llu},
+    {0x9c69a97284b578d7llu, 0xff2a760414536efbllu}, /* 5^150 */
+    {0xc38413cf25e2d70dllu, 0xfef5138519684aballu},
+    {0xf46518c2ef5b8cd1llu, 0x7eb258665fc25d69llu},
+    {0x98bf2f79d5993802llu, 0xef2f773ffbd97a61llu},
+    {0xbeeefb584aff8603llu, 0xaafb550ffacfd8fallu},
+    {0xeeaaba2e5dbf6784llu, 0x95ba2a53f983cf38llu},
+    {0x952ab45cfa97a0b2llu, 0xdd945a747bf26183llu},
+    {0xba756174393d88dfllu, 0x94f971119aeef9e4llu},
+    {0xe912b9d1478ceb17llu, 0x7a37cd5601aab85dllu},
+    {0x91abb422ccb812eellu, 0xac62e055c10ab33allu},
+    {0xb616a12b7fe617aallu, 0x577b986b314d6009llu}, /* 5^160 */
+    {0xe39c49765fdf9d94llu, 0xed5a7e85fda0b80bllu},
+    {0x8e41ade9fbebc27dllu, 0x14588f13be847307llu},
+    {0xb1d219647ae6b31cllu, 0x596eb2d8ae258fc8llu},
+    {0xde469fbd99a05fe3llu, 0x6fca5f8ed9aef3bbllu},
+    {0x8aec23d680043beellu, 0x25de7bb9480d5854llu},
+    {0xada72ccc20054ae9llu, 0xaf561aa79a10ae6allu},
+    {0xd910f7ff28069da4llu, 0x1b2ba1518094da04llu},
+    {0x87aa9aff79042286llu, 0x90fb44d2f05d0842llu},
+    {0xa99541bf57452b28llu, 0x353a1607ac744a53llu},
+    {0xd3fa922f2d1675f2llu, 0x42889b8997915ce8llu}, /* 5^170 */
+    {0x847c9b5d7c2e09b7llu, 0x69956135febada11llu},
+    {0xa59bc234db398c25llu, 0x43fab9837e699095llu},
+    {0xcf02b2c21207ef2ellu, 0x94f967e45e03f4bbllu},
+    {0x8161afb94b44f57dllu, 0x1d1be0eebac278f5llu},
+    {0xa1ba1ba79e1632dcllu, 0x6462d92a69731732llu},
+    {0xca28a291859bbf93llu, 0x7d7b8f7503cfdcfellu},
+    {0xfcb2cb35e702af78llu, 0x5cda735244c3d43ellu},
+    {0x9defbf01b061adabllu, 0x3a0888136afa64a7llu},
+    {0xc56baec21c7a1916llu, 0x088aaa1845b8fdd0llu},
+    {0xf6c69a72a3989f5bllu, 0x8aad549e57273d45llu}, /* 5^180 */
+    {0x9a3c2087a63f6399llu, 0x36ac54e2f678864bllu},
+    {0xc0cb28a98fcf3c7fllu, 0x84576a1bb416a7ddllu},
+    {0xf0fdf2d3f3c30b9fllu, 0x656d44a2a11c51d5llu},
+    {0x969eb7c47859e743llu, 0x9f644ae5a4b1b325llu},
+    {0xbc4665b596706114llu, 0x873d5d9f0dde1feellu},
+    {0xeb57ff22fc0c7959llu, 0xa90cb506d155a7eallu},
+    {0x9316ff75dd87cbd8llu, 0x09a7f12442d588f2llu},
+    {0xb7dcbf5354e9becellu, 0x0c11ed6d538aeb2fllu},
+    {0xe5d3ef282a242e81llu, 0x8f1668c8a86da5fallu},
+    {0x8fa475791a569d10llu, 0xf96e017d694487bcllu}, /* 5^190 */
+    {0xb38d92d760ec4455llu, 0x37c981dcc395a9acllu},
+    {0xe070f78d3927556allu, 0x85bbe253f47b1417llu},
+    {0x8c469ab843b89562llu, 0x93956d7478ccec8ellu},
+    {0xaf58416654a6babbllu, 0x387ac8d1970027b2llu},
+    {0xdb2e51bfe9d0696allu, 0x06997b05fcc0319ellu},
+    {0x88fcf317f22241e2llu, 0x441fece3bdf81f03llu},
+    {0xab3c2fddeeaad25allu, 0xd527e81cad7626c3llu},
+    {0xd60b3bd56a5586f1llu, 0x8a71e223d8d3b074llu},
+    {0x85c7056562757456llu, 0xf6872d5667844e49llu},
+    {0xa738c6bebb12d16cllu, 0xb428f8ac016561dbllu}, /* 5^200 */
+    {0xd106f86e69d785c7llu, 0xe13336d701beba52llu},
+    {0x82a45b450226b39cllu, 0xecc0024661173473llu},
+    {0xa34d721642b06084llu, 0x27f002d7f95d0190llu},
+    {0xcc20ce9bd35c78a5llu, 0x31ec038df7b441f4llu},
+    {0xff290242c83396cellu, 0x7e67047175a15271llu},
+    {0x9f79a169bd203e41llu, 0x0f0062c6e984d386llu},
+    {0xc75809c42c684dd1llu, 0x52c07b78a3e60868llu},
+    {0xf92e0c3537826145llu, 0xa7709a56ccdf8a82llu},
+    {0x9bbcc7a142b17ccbllu, 0x88a66076400bb691llu},
+    {0xc2abf989935ddbfellu, 0x6acff893d00ea435llu}, /* 5^210 */
+    {0xf356f7ebf83552fellu, 0x0583f6b8c4124d43llu},
+    {0x98165af37b2153dellu, 0xc3727a337a8b704allu},
+    {0xbe1bf1b059e9a8d6llu, 0x744f18c0592e4c5cllu},
+    {0xeda2ee1c7064130cllu, 0x1162def06f79df73llu},
+    {0x9485d4d1c63e8be7llu, 0x8addcb5645ac2ba8llu},
+    {0xb9a74a0637ce2ee1llu, 0x6d953e2bd7173692llu},
+    {0xe8111c87c5c1ba99llu, 0xc8fa8db6ccdd0437llu},
+    {0x910ab1d4db9914a0llu, 0x1d9c9892400a22a2llu},
+    {0xb54d5e4a127f59c8llu, 0x2503beb6d00cab4bllu},
+    {0xe2a0b5dc971f303allu, 0x2e44ae64840fd61dllu}, /* 5^220 */
+    {0x8da471a9de737e24llu, 0x5ceaecfed289e5d2llu},
+    {0xb10d8e1456105dadllu, 0x7425a83e872c5f47llu},
+    {0xdd50f1996b947518llu, 0xd12f124e28f77719llu},
+    {0x8a5296ffe33cc92fllu, 0x82bd6b70d99aaa6fllu},
+    {0xace73cbfdc0bfb7bllu, 0x636cc64d1001550bllu},
+    {0xd8210befd30efa5allu, 0x3c47f7e05401aa4ellu},
+    {0x8714a775e3e95c78llu, 0x65acfaec34810a71llu},
+    {0xa8d9d1535ce3b396llu, 0x7f1839a741a14d0dllu},
+    {0xd31045a8341ca07cllu, 0x1ede48111209a050llu},
+    {0x83ea2b892091e44dllu, 0x934aed0aab460432llu}, /* 5^230 */
+    {0xa4e4b66b68b65d60llu, 0xf81da84d5617853fllu},
+    {0xce1de40642e3f4b9llu, 0x36251260ab9d668ellu},
+    {0x80d2ae83e9ce78f3llu, 0xc1d72b7c6b426019llu},
+    {0xa1075a24e4421730llu, 0xb24cf65b8612f81fllu},
+    {0xc94930ae1d529cfcllu, 0xdee033f26797b627llu},
+    {0xfb9b7cd9a4a7443cllu, 0x169840ef017da3b1llu},
+    {0x9d412e0806e88aa5llu, 0x8e1f289560ee864ellu},
+    {0xc491798a08a2ad4ellu, 0xf1a6f2bab92a27e2llu},
+    {0xf5b5d7ec8acb58a2llu, 0xae10af696774b1dbllu},
+    {0x9991a6f3d6bf1765llu, 0xacca6da1e0a8ef29llu}, /* 5^240 */
+    {0xbff610b0cc6edd3fllu, 0x17fd090a58d32af3llu},
+    {0xeff394dcff8a948ellu, 0xddfc4b4cef07f5b0llu},
+    {0x95f83d0a1fb69cd9llu, 0x4abdaf101564f98ellu},
+    {0xbb764c4ca7a4440fllu, 0x9d6d1ad41abe37f1llu},
+    {0xea53df5fd18d5513llu, 0x84c86189216dc5edllu},
+    {0x92746b9be2f8552cllu, 0x32fd3cf5b4e49bb4llu},
+    {0xb7118682dbb66a77llu, 0x3fbc8c33221dc2a1llu},
+    {0xe4d5e82392a40515llu, 0x0fabaf3feaa5334allu},
+    {0x8f05b1163ba6832dllu, 0x29cb4d87f2a7400ellu},
+    {0xb2c71d5bca9023f8llu, 0x743e20e9ef511012llu}, /* 5^250 */
+    {0xdf78e4b2bd342cf6llu, 0x914da9246b255416llu},
+    {0x8bab8eefb6409c1allu, 0x1ad089b6c2f7548ellu},
+    {0xae9672aba3d0c320llu, 0xa184ac2473b529b1llu},
+    {0xda3c0f568cc4f3e8llu, 0xc9e5d72d90a2741ellu},
+    {0x8865899617fb1871llu, 0x7e2fa67c7a658892llu},
+    {0xaa7eebfb9df9de8dllu, 0xddbb901b98feeab7llu},
+    {0xd51ea6fa85785631llu, 0x552a74227f3ea565llu},
+    {0x8533285c936b35dellu, 0xd53a88958f87275fllu},
+    {0xa67ff273b8460356llu, 0x8a892abaf368f137llu},
+    {0xd01fef10a657842cllu, 0x2d2b7569b0432d85llu}, /* 5^260 */
+    {0x8213f56a67f6b29bllu, 0x9c3b29620e29fc73llu},
+    {0xa298f2c501f45f42llu, 0x8349f3ba91b47b8fllu},
+    {0xcb3f2f7642717713llu, 0x241c70a936219a73llu},
+    {0xfe0efb53d30dd4d7llu, 0xed238cd383aa0110llu},
+    {0x9ec95d1463e8a506llu, 0xf4363804324a40aallu},
+    {0xc67bb4597ce2ce48llu, 0xb143c6053edcd0d5llu},
+    {0xf81aa16fdc1b81dallu, 0xdd94b7868e94050allu},
+    {0x9b10a4e5e9913128llu, 0xca7cf2b4191c8326llu},
+    {0xc1d4ce1f63f57d72llu, 0xfd1c2f611f63a3f0llu},
+    {0xf24a01a73cf2dccfllu, 0xbc633b39673c8cecllu}, /* 5^270 */
+    {0x976e41088617ca01llu, 0xd5be0503e085d813llu},
+    {0xbd49d14aa79dbc82llu, 0x4b2d8644d8a74e18llu},
+    {0xec9c459d51852ba2llu, 0xddf8e7d60ed1219ellu},
+    {0x93e1ab8252f33b45llu, 0xcabb90e5c942b503llu},
+    {0xb8da1662e7b00a17llu, 0x3d6a751f3b936243llu},
+    {0xe7109bfba19c0c9dllu, 0x0cc512670a783ad4llu},
+    {0x906a617d450187e2llu, 0x27fb2b80668b24c5llu},
+    {0xb484f9dc9641e9dallu, 0xb1f9f660802dedf6llu},
+    {0xe1a63853bbd26451llu, 0x5e7873f8a0396973llu},
+    {0x8d07e33455637eb2llu, 0xdb0b487b6423e1e8llu}, /* 5^280 */
+    {0xb049dc016abc5e5fllu, 0x91ce1a9a3d2cda62llu},
+    {0xdc5c5301c56b75f7llu, 0x7641a140cc7810fbllu},
+    {0x89b9b3e11b6329ballu, 0xa9e904c87fcb0a9dllu},
+    {0xac2820d9623bf429llu, 0x546345fa9fbdcd44llu},
+    {0xd732290fbacaf133llu, 0xa97c177947ad4095llu},
+    {0x867f59a9d4bed6c0llu, 0x49ed8eabcccc485dllu},
+    {0xa81f301449ee8c70llu, 0x5c68f256bfff5a74llu},
+    {0xd226fc195c6a2f8cllu, 0x73832eec6fff3111llu},
+    {0x83585d8fd9c25db7llu, 0xc831fd53c5ff7eabllu},
+    {0xa42e74f3d032f525llu, 0xba3e7ca8b77f5e55llu}, /* 5^290 */
+    {0xcd3a1230c43fb26fllu, 0x28ce1bd2e55f35ebllu},
+    {0x80444b5e7aa7cf85llu, 0x7980d163cf5b81b3llu},
+    {0xa0555e361951c366llu, 0xd7e105bcc332621fllu},
+    {0xc86ab5c39fa63440llu, 0x8dd9472bf3fefaa7llu},
+    {0xfa856334878fc150llu, 0xb14f98f6f0feb951llu},
+    {0x9c935e00d4b9d8d2llu, 0x6ed1bf9a569f33d3llu},
+    {0xc3b8358109e84f07llu, 0x0a862f80ec4700c8llu},
+    {0xf4a642e14c6262c8llu, 0xcd27bb612758c0fallu},
+    {0x98e7e9cccfbd7dbdllu, 0x8038d51cb897789cllu},
+    {0xbf21e44003acdd2cllu, 0xe0470a63e6bd56c3llu}, /* 5^300 */
+    {0xeeea5d5004981478llu, 0x1858ccfce06cac74llu},
+    {0x95527a5202df0ccbllu, 0x0f37801e0c43ebc8llu},
+    {0xbaa718e68396cffdllu, 0xd30560258f54e6ballu},
+    {0xe950df20247c83fdllu, 0x47c6b82ef32a2069llu},
+    {0x91d28b7416cdd27ellu, 0x4cdc331d57fa5441llu},
+    {0xb6472e511c81471dllu, 0xe0133fe4adf8e952llu},
+    {0xe3d8f9e563a198e5llu, 0x58180fddd97723a6llu},
+    {0x8e679c2f5e44ff8fllu, 0x570f09eaa7ea7648llu},
+};
+
+
+static void mul_64x64(fs_u64 a, fs_u64 b, fs_u64 *hi, fs_u64 *lo)
+{
+    const fs_u64 mask = 0xFFFFFFFF;
+    fs_u64 p0 = (a & mask) * (b & mask);
+    fs_u64 p1 = (a & mask) * (b >> 32);
+    fs_u64 p2 = (a >> 32) * (b & mask);
+    fs_u64 p3 = (a >> 32) * (b >> 32);
+    fs_u64 mid = (p0 >> 32) + (p1 & mask) + (p2 & mask);
+
+    *lo = (mid << 32) | (p0 & mask);
+    *hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+}
+
+
+static int count_leading_zeros64(fs_u64 n)
+{
+#ifdef __GNUC__
+    return __builtin_clzll(n);
+#else
+    int count = 0;
+    for (; 0 == (n >> 63); n <<= 1)
+        count += 1;
+    return count;
+#endif /* __GNUC__ */
+}
+
+
+/* returns 0 when it cannot decide and the slow path has to be taken */
+static int eisel_lemire(fs_u64 w, int q, fs_double_parts *parts)
+{
+    fs_u64 hi, lo, hi2, lo2, mantissa;
+    int lz, upperbit, shift, power2;
+
+    if (0 == w || q < POW5_MIN_EXPONENT)
+    {
+        set_parts(parts, 0, 0, 0);
+        return 1;
+    }
+    if (q > POW5_MAX_EXPONENT)
+    {
+        set_parts(parts, DOUBLE_INF_EXPONENT, 0, 0);
+        return 1;
+    }
+
+    lz = count_leading_zeros64(w);
+    w <<= lz;
+
+    /* 55 bits of the product are needed, the low 64 bits of 5^q 
+     * only matter when the bits below those are all set */
+    mul_64x64(w, s_pow5_128[q - POW5_MIN_EXPONENT][0], &hi, &lo);
+    if ((hi & 0x1FF) == 0x1FF)
+    {
+        mul_64x64(w, s_pow5_128[q - POW5_MIN_EXPONENT][1], &hi2, &lo2);
+        lo += hi2;
+        if (hi2 > lo)
+            hi += 1;
+    }
+    /* the error may have carried into the bits that are kept */
+    if (lo == ~(fs_u64)0 && (q < -27 || q > 55))
+        return 0;
+
+    upperbit = (int)(hi >> 63);
+    shift = upperbit + 64 - DOUBLE_MANTISSA_BITS - 3;
+    mantissa = hi >> shift;
+    /* floor(log2(10^q)) + 63 */
+    power2 = (int)(((152170 + 65536) * (long)q) >> 16) + 63 
+        + upperbit - lz - DOUBLE_MIN_EXPONENT;
+
+    if (power2 <= 0)
+    {
+        /* subnormal, one more bit is kept for rounding */
+        if (-power2 + 1 >= 64)
+        {
+            set_parts(parts, 0, 0, 0);
+            return 1;
+        }
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        /* rounded up to the smallest normal */
+        power2 = (mantissa >> DOUBLE_MANTISSA_BITS) ? 1 : 0;
+        goto done;
+    }
+
+    /* exactly halfway, ties to even */
+    if (lo <= 1 && (mantissa & 3) == 1
+    && ROUND_TO_EVEN_MIN_EXPONENT <= q && q <= ROUND_TO_EVEN_MAX_EXPONENT
+    && (mantissa << shift) == hi)
+        mantissa &= ~(fs_u64)1;
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >> (DOUBLE_MANTISSA_BITS + 1))
+    {
+        mantissa = (fs_u64)1 << DOUBLE_MANTISSA_BITS;
+        power2 += 1;
+    }
+    if (power2 >= DOUBLE_INF_EXPONENT)
+    {
+        set_parts(parts, DOUBLE_INF_EXPONENT, 0, 0);
+        return 1;
+    }
+
+done:
+    set_parts(parts, (fs_u32)power2, 
+        (fs_u32)(mantissa >> 32) & 0xFFFFF, (fs_u32)mantissa);
+    return 1;
+}
+
+#endif /* FS_64BIT_DEFINED */
+
+
+
+
+/* 
+ * the digits from begin up to mantissa_end, 
+ * then an exponent up to end if there is one 
+ */
+typedef struct fs_number
+{
+    const char *begin;
+    const char *end;
+    int negative;
+    int significant_digits;
+#ifdef FS_64BIT_DEFINED
+    fs_u64 w; /* the first MAX_EXACT_DIGITS significant digits */
+    int q; /* the exponent of w */
+#endif /* FS_64BIT_DEFINED */
+} fs_number;
+
+
+/* returns 0 if there are no digits */
+static int parse_number(const char *s, fs_number *num)
+{
+    int digits = 0;
+    int seen_point = 0;
+    long exponent = 0;
+    long point_shift = 0; /* of the first MAX_EXACT_DIGITS significant digits */
+    int negative_exp;
+    const char *exp_digits;
+
+    num->begin = s;
+    num->significant_digits = 0;
+#ifdef FS_64BIT_DEFINED
+    num->w = 0;
+#endif /* FS_64BIT_DEFINED */
+
+    for (;; s += 1)
+    {
+        if ('.' == *s && !seen_point)
+        {
+            seen_point = 1;
+            continue;
+        }
+        if (!fs_is_digit(*s))
+            break;
+
+        digits += 1;
+        if (0 == num->significant_digits && '0' == *s)
+        {
+            if (seen_point)
+                point_shift -= 1;
+            continue;
+        }
+        num->significant_digits += 1;
+#ifdef FS_64BIT_DEFINED
+        if (num->significant_digits <= MAX_EXACT_DIGITS)
+        {
+            num->w = num->w * 10 + (fs_u64)(*s - '0');
+            if (seen_point)
+                point_shift -= 1;
+        }
+        else if (!seen_point)
+            point_shift += 1;
+#endif /* FS_64BIT_DEFINED */
+    }
+    if (0 == digits)
+        return 0;
+
+    /* an exponent without digits is not part of the number */
+    num->end = s;
+    if ('e' == *s || 'E' == *s)
+    {
+        s += 1;
+        negative_exp = ('-' == *s);
+        if ('-' == *s || '+' == *s)
+            s += 1;
+        for (exp_digits = s; fs_is_digit(*s); s += 1)
+        {
+            if (exponent < EXPONENT_LIMIT)
+                exponent = exponent * 10 + (*s - '0');
+        }
+        if (s != exp_digits)
+        {
+            num->end = s;
+            if (negative_exp)
+                exponent = -exponent;
+        }
+        else exponent = 0;
+    }
+
+#ifdef FS_64BIT_DEFINED
+    exponent += point_shift;
+    if (exponent > EXPONENT_LIMIT)
+        exponent = EXPONENT_LIMIT;
+    else if (exponent < -EXPONENT_LIMIT)
+        exponent = -EXPONENT_LIMIT;
+    num->q = (int)exponent;
+#else
+    (void)point_shift;
+    (void)exponent;
+#endif /* FS_64BIT_DEFINED */
+    return 1;
+}
+
+
+static void number_to_parts(const fs_number *num, fs_double_parts *parts)
+{
+    fs_decimal dec;
+#ifdef FS_64BIT_DEFINED
+    fs_double_parts next;
+
+    if (eisel_lemire(num->w, num->q, parts))
+    {
+        if (num->significant_digits <= MAX_EXACT_DIGITS)
+            return;
+        /* the digits that were dropped are between w and w + 1 */
+        if (eisel_lemire(num->w + 1, num->q, &next)
+        && next.exponent == parts->exponent 
+        && next.mantissa_hi == parts->mantissa_hi
+        && next.mantissa_lo == parts->mantissa_lo)
+            return;
+    }
+#endif /* FS_64BIT_DEFINED */
+
+    decimal_parse(&dec, num->begin, num->end);
+    decimal_to_parts(&dec, parts);
+}
+
+
+
+double fs_strtod(const char *str, char **endptr)
+{
+    const char *s = str;
+    fs_number num;
+    fs_double_parts parts;
+    int negative = 0;
+    int len;
+
+    while (fs_is_space(*s))
+        s += 1;
+    if ('-' == *s || '+' == *s)
+    {
+        negative = ('-' == *s);
+        s += 1;
+    }
+
+    if ((len = match_word(s, "inf")))
+    {
+        s += len;
+        s += match_word(s, "inity");
+        set_parts(&parts, DOUBLE_INF_EXPONENT, 0, 0);
+    }
+    else if ((len = match_word(s, "nan")))
+    {
+        s += len;
+        set_parts(&parts, DOUBLE_INF_EXPONENT, 0x80000, 0);
+
+        /* nan(n-char-sequence) */
+        if ('(' == *s)
+        {
+            for (len = 1; fs_is_digit(s[len]) || '_' == s[len]
+                || ('a' <= (s[len] | 32) && (s[len] | 32) <= 'z'); len += 1)
+            {}
+            if (')' == s[len])
+                s += len + 1;
+        }
+    }
+    else if (parse_number(s, &num))
+    {
+        number_to_parts(&num, &parts);
+        s = num.end;
+    }
+    else
+    {
+        if (NULL != endptr)
+            *endptr = (char *)str;
+        return 0;
+    }
+
+    if (NULL != endptr)
+        *endptr = (char *)s;
+    return fs_double_from_parts(negative, parts.exponent, parts.mantissa_hi, parts.mantissa_lo);
+}
+
+
+
+
+#ifdef STRTOD_TEST
+
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+
+
+#ifndef FS_C99
+#  error "at least C99 is required for testing code"
+#endif /* FS_C99 */
+
+
+
+/** parses str with fs_strtod and the system strtod, the results must be the same bits */
+static int compare_strtod(const char *str)
+{
+    char *fs_end, *sys_end;
+    double fs_result = fs_strtod(str, &fs_end);
+    double sys_result = strtod(str, &sys_end);
+
+    if (memcmp(&fs_result, &sys_result, sizeof(double)) != 0 || fs_end != sys_end)
+    {
+        printf("  [ERROR]: fs_strtod(\"%s\") was %.17g, end %d, expected %.17g, end %d\n", 
+            str, fs_result, (int)(fs_end - str), sys_result, (int)(sys_end - str));
+        return 0;
+    }
+    return 1;
+}
+
+
+/** the slow path alone */
+static int compare_slow_path(const char *str)
+{
+    fs_number num;
+    fs_decimal dec;
+    fs_double_parts parts;
+    double fs_result, sys_result;
+
+    if (!parse_number(str, &num))
+        return 1;
+    decimal_parse(&dec, num.begin, num.end);
+    decimal_to_parts(&dec, &parts);
+    fs_result = fs_double_from_parts(0, parts.exponent, parts.mantissa_hi, parts.mantissa_lo);
+    sys_result = strtod(str, NULL);
+    if (memcmp(&fs_result, &sys_result, sizeof(double)) != 0)
+    {
+        printf("  [ERROR]: slow path of \"%s\" was %.17g, expected %.17g\n", 
+            str, fs_result, sys_result);
+        return 0;
+    }
+    return 1;
+}
+
+
+static double random_double(void)
+{
+    unsigned char bytes[sizeof(double)];
+    double d;
+    unsigned i;
+
+    do {
+        for (i = 0; i < sizeof bytes; i += 1)
+            bytes[i] = (unsigned char)rand();
+        memcpy(&d, bytes, sizeof d);
+    } while (d != d || d - d != 0); /* nan or inf */
+    return d < 0 ? -d : d;
+}
+
+
+int main(void)
+{
+    static const char *s_cases[] = {
+        /* what the formatter prints */
+        "0", "0.000000", "1.500000", "-2.500000", "123.456000", "10000000000.000000", 
+        "3.1415", "0.00001", "123.4560000000000", "3.14159265358979", 
+        "0.0000000000000000000", "9223372036854775808.9223372036854775808",
+
+        "1", "-1", "+1", ".5", "5.", "-.5e1", "1e", "1e+", "1e-x", "1.5E3", "1.5e+03", 
+        "  \t\n42", "1..2", "00000000000000000000000000001", "-0", "-0.0e10",
+        "inf", "-INF", "Infinity", "infinit", "nan", "-NaN", "nan(123abc)", "nan(", "in", 
+        ".", "-", "+.e1", "e5", "",
+
+        /* limits */
+        "1.7976931348623157e308", "1.7976931348623158e308", "1.7976931348623159e308", 
+        "2.2250738585072014e-308", "2.2250738585072011e-308", "4.9406564584124654e-324", 
+        "2.4703282292062327e-324", "2.4703282292062328e-324", "1e-400", "1e400", 
+        "1e-99999999999", "1e99999999999", "0e99999999999", "1e-324", "3e-324", 
+        "123456789012345678901234567890e-350", "0.000000000000000000000000000000001e340",
+
+        /* ties and hard cases */
+        "9007199254740993", "9007199254740995", "9007199254740992.5", 
+        "9007199254740993.0000000000000000000000000000001", "4503599627370496.5", 
+        "4503599627370497.5", "2.2250738585072012e-308", "7.038531e-26", 
+        "1.00000000000000011102230246251565404236316680908203125",
+        "1.00000000000000011102230246251565404236316680908203124", 
+        "1.00000000000000011102230246251565404236316680908203126", 
+        "8.988465674311580536566680e307", "9.0071992547409915e15", 
+        "2.47032822920623272088284396434110686182529901307162382212792841250337753635104375932649918180817996189898282347722858865463328355177969898199387398005390939063150356595155702263922908583924491051844359318028499365361525003193704576782492193656236698636584807570015857692699037063119282795585513329278343384093519780155312465972635795746227664652728272200563740064854999770965994704540208281662262378573934507363390079677619305775067401763246736009689513405355374585166611342237666786041621596804619144672918403005300575308490487653917113865916462395249126236538818796362393732804238910186723484976682350898633885879256283027559956575244555072551893136908362547791869486679949683240497058210285131854513962138377228261454376934125320985913276672363281255e-324",
+        "6.631236846766476e-316", "3.2483e-320", "1e23", "8.533e+68", "4.1006e-184", 
+        "9.998e+307", "9.9538452227e-280", "6.47660115e-260", "7.4e+47", "5.92e+48", 
+        "7.35e+66", "8.32116e+55", "358416272e-33", "1.1754943508222875e-38", 
+        "89255.0e-22", "0.500000000000000166533453693773481063544750213623046875", 
+        "3.518437208883201171875e13", "62.5364939768271845828", "8.10109172351e-10", 
+        "1.50000000000000011102230246251565404236316680908203125", 
+        "9007199254740991.4999999999999999999999999999999995", 
+    };
+    char buf[4096];
+    unsigned i, j;
+    double d;
+    const char *seed_env = getenv("FS_TEST_SEED");
+    unsigned seed = NULL != seed_env ? (unsigned)strtoul(seed_env, NULL, 0) : 1;
+    char *end;
+
+    printf("[INFO]: Now test fs_strtod against strtod\n");
+    for (i = 0; i < sizeof s_cases / sizeof s_cases[0]; i += 1)
+    {
+        if (!compare_strtod(s_cases[i]) || !compare_slow_path(s_cases[i]))
+            exit(1);
+    }
+    printf("  test fixed cases passed\n");
+
+    /* the sign of nan and the end of a number followed by text */
+    d = fs_strtod("-nan", &end);
+    if (d == d || (((unsigned char *)&d)[FS_ENDIAN_IS(FS_ENDIAN_LITTLE) ? 7 : 0] & 0x80) == 0
+    || fs_strtod("2.5kg", &end) != 2.5 || strcmp(end, "kg") != 0 
+    || fs_strtod("12", NULL) != 12
+    || fs_strtod("0x10", &end) != 0 || strcmp(end, "x10") != 0)
+    {
+        printf("  [ERROR]: nan, end of number or hex float\n");
+        exit(1);
+    }
+
+    /* a long run of digits past the slow path's limit */
+    memset(buf, '9', 1000);
+    strcpy(buf + 1000, "e-1000");
+    if (!compare_strtod(buf) || !compare_slow_path(buf))
+        exit(1);
+    buf[0] = '0';
+    buf[1] = '.';
+    memset(buf + 2, '0', 790);
+    strcpy(buf + 792, "24703282292062327208828439643411068618252990130716238221279284125033775363510437593264991818081799618989828234772285886546332835517796989819938739800539093906315035659515570226392290858392449105184435931802849936536152500319370457678249219365623669863658480757001585769269903706311928279558551332927834338409351978015531246597263579574622766465272827220056374006485499977096599470454020828166226237857393450736339007967761930577506740176324673600968951340535537458516661134223766678604162159680461914467291840300530057530849048765391711386591646239524912623653881879636239373280423891018672348497668235089863388587925628302755995657524455507255189313690836254779186948667994968324049705821028513185451396213837722826145437693412532098591327667236328125000000000001");
+    if (!compare_strtod(buf) || !compare_slow_path(buf))
+        exit(1);
+    printf("  test long inputs passed\n");
+
+    /* the same numbers every run, FS_TEST_SEED picks others */
+    printf("[INFO]: Now test fs_strtod on random doubles, seed %u\n", seed);
+    srand(seed);
+    for (i = 0; i < 200000; i += 1)
+    {
+        static const char *s_formats[] = { "%.17g", "%.16e", "%.6g", "%.3e" };
+        d = random_double();
+        for (j = 0; j < sizeof s_formats / sizeof s_formats[0]; j += 1)
+        {
+            snprintf(buf, sizeof buf, s_formats[j], d);
+            if (!compare_strtod(buf) || (0 == i % 64 && !compare_slow_path(buf)))
+                exit(1);
+        }
+
+        /* fixed notation, as the formatter prints it */
+        d = (double)rand() / (1 + rand() % 100000) * (1 + rand() % 1000);
+        snprintf(buf, sizeof buf, "%.*f", rand() % 40, d);
+        if (!compare_strtod(buf) || (0 == i % 64 && !compare_slow_path(buf)))
+            exit(1);
+    }
+    printf("  test random doubles passed\n");
+
+    printf("All strtod tests passed!\n");
+    return 0;
+}
+#endif /* STRTOD_TEST */
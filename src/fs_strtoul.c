@@ -0,0 +1,323 @@
+#include "../include/fs_int.h"
+#include "../include/fs_strtoul.h"
+#include "../include/fs_standard.h"
+#include "../include/fs_mem.h"
+
+
+
+#ifdef DEBUG_TEST
+#  define STRTOUL_TEST
+#endif /* DEBUG_TEST */
+
+
+
+/* 
+ * decimal digits are converted a word at a time (SWAR): 
+ * the digits are loaded with the first one in the lowest byte, 
+ * then neighbouring bytes, 16 bit and 32 bit halves are combined by one multiply each 
+ */
+#ifdef FS_64BIT_DEFINED
+typedef fs_u64 fs_uparse;
+typedef fs_u64 fs_swar;
+#  define SWAR_DIGITS 8
+#else
+typedef unsigned long fs_uparse;
+typedef fs_u32 fs_swar;
+#  define SWAR_DIGITS 4
+#endif /* FS_64BIT_DEFINED */
+
+
+static const fs_u32 s_pow10[SWAR_DIGITS + 1] = {
+    1, 10, 100, 1000, 10000, 
+#if SWAR_DIGITS == 8
+    100000, 1000000, 10000000, 100000000,
+#endif /* SWAR_DIGITS */
+};
+
+
+
+/* 0 to 35, 36 if ch is not a digit of any base */
+static int digit_value(char ch)
+{
+    if (fs_is_digit(ch))
+        return ch - '0';
+    ch |= 32; /* to lowercase */
+    if ('a' <= ch && ch <= 'z')
+        return ch - 'a' + 10;
+    return 36;
+}
+
+
+/* the value of SWAR_DIGITS decimal digits */
+static fs_swar swar_digits(const char *s)
+{
+    const unsigned char *p = (const unsigned char *)s;
+#if SWAR_DIGITS == 8
+    fs_swar val = (fs_swar)p[0] | (fs_swar)p[1] << 8 | (fs_swar)p[2] << 16 | (fs_swar)p[3] << 24
+        | (fs_swar)p[4] << 32 | (fs_swar)p[5] << 40 | (fs_swar)p[6] << 48 | (fs_swar)p[7] << 56;
+
+    val = ((val & 0x0F0F0F0F0F0F0F0Fllu) * (10 * 0x100 + 1)) >> 8;
+    val = ((val & 0x00FF00FF00FF00FFllu) * (100 * 0x10000 + 1)) >> 16;
+    return ((val & 0x0000FFFF0000FFFFllu) * (10000 * 0x100000000llu + 1)) >> 32;
+#else
+    fs_swar val = (fs_swar)p[0] | (fs_swar)p[1] << 8 | (fs_swar)p[2] << 16 | (fs_swar)p[3] << 24;
+
+    val &= 0x0F0F0F0F;
+    val = (val * 10 + (val >> 8)) & 0x00FF00FF;
+    return (val * 100 + (val >> 16)) & 0x0000FFFF;
+#endif /* SWAR_DIGITS */
+}
+
+
+/* the value of count decimal digits, count <= SWAR_DIGITS, padded with leading zeros */
+static fs_swar swar_digits_partial(const char *s, int count)
+{
+    char padded[SWAR_DIGITS];
+    int i;
+
+    for (i = 0; i < SWAR_DIGITS - count; i += 1)
+        padded[i] = '0';
+    for (; i < SWAR_DIGITS; i += 1)
+        padded[i] = s[i - (SWAR_DIGITS - count)];
+    return swar_digits(padded);
+}
+
+
+/* 
+ * the decimal digits starting at *s, up to max, sets *overflow if they do not fit. 
+ * the leading partial word is converted first so the rest are whole words
+ */
+static fs_uparse parse_decimal(const char **s, fs_uparse max, int *overflow)
+{
+    const char *digits = *s;
+    const char *end = *s;
+    /* fewer digits than this always fit, unsigned long has at least 32 bits */
+    const int safe_digits = (max >> 16 >> 16) ? 19 : 9;
+    fs_uparse n = 0;
+    fs_uparse value;
+    int chunk;
+
+    while (fs_is_digit(*end))
+        end += 1;
+    *s = end;
+    while (digits < end && '0' == *digits)
+        digits += 1;
+
+    chunk = (int)((end - digits) % SWAR_DIGITS);
+    if (0 == chunk)
+        chunk = SWAR_DIGITS;
+
+    if (end - digits <= safe_digits)
+    {
+        for (; digits < end; digits += chunk, chunk = SWAR_DIGITS)
+        {
+            value = (SWAR_DIGITS == chunk) 
+                ? swar_digits(digits) : swar_digits_partial(digits, chunk);
+            n = n * s_pow10[chunk] + value;
+        }
+        return n;
+    }
+
+    for (; digits < end; digits += chunk, chunk = SWAR_DIGITS)
+    {
+        value = (SWAR_DIGITS == chunk) 
+            ? swar_digits(digits) : swar_digits_partial(digits, chunk);
+        if (n > (max - value) / s_pow10[chunk])
+        {
+            *overflow = 1;
+            return max;
+        }
+        n = n * s_pow10[chunk] + value;
+    }
+    return n;
+}
+
+
+/* the digits of base starting at *s, up to max, sets *overflow if they do not fit */
+static fs_uparse parse_digits(const char **s, int base, fs_uparse max, int *overflow)
+{
+    const char *p = *s;
+    const fs_uparse cutoff = max / (fs_uparse)base;
+    const int cutlim = (int)(max % (fs_uparse)base);
+    fs_uparse n = 0;
+    int digit;
+
+    for (; (digit = digit_value(*p)) < base; p += 1)
+    {
+        if (n > cutoff || (n == cutoff && digit > cutlim))
+            *overflow = 1;
+        n = n * (fs_uparse)base + (fs_uparse)digit;
+    }
+    *s = p;
+    return *overflow ? max : n;
+}
+
+
+/* fs_strtoul() for unsigned types with the maximum max, which is 2^k - 1 */
+static fs_uparse parse_unsigned(const char *str, char **endptr, int base, fs_uparse max)
+{
+    const char *s = str;
+    const char *digits;
+    int negative = 0;
+    int overflow = 0;
+    fs_uparse n;
+
+    if (base < 0 || 1 == base || base > 36)
+    {
+        if (NULL != endptr)
+            *endptr = (char *)str;
+        return 0;
+    }
+
+    while (fs_is_space(*s))
+        s += 1;
+    if ('-' == *s || '+' == *s)
+    {
+        negative = ('-' == *s);
+        s += 1;
+    }
+
+    /* 0x only if a hex digit follows, otherwise the number is the 0 */
+    if ((0 == base || 16 == base) 
+    && '0' == s[0] && 'x' == (s[1] | 32) && digit_value(s[2]) < 16)
+    {
+        s += 2;
+        base = 16;
+    }
+    else if (0 == base)
+        base = ('0' == *s) ? 8 : 10;
+
+    digits = s;
+    if (10 == base)
+        n = parse_decimal(&s, max, &overflow);
+    else n = parse_digits(&s, base, max, &overflow);
+
+    if (s == digits)
+    {
+        if (NULL != endptr)
+            *endptr = (char *)str;
+        return 0;
+    }
+    if (NULL != endptr)
+        *endptr = (char *)s;
+
+    if (negative && !overflow)
+        n = (0 - n) & max;
+    return n;
+}
+
+
+
+unsigned long fs_strtoul(const char *str, char **endptr, int base)
+{
+    return (unsigned long)parse_unsigned(str, endptr, base, ULONG_MAX);
+}
+
+
+#ifdef FS_64BIT_DEFINED
+unsigned long long fs_strtoull(const char *str, char **endptr, int base)
+{
+    return parse_unsigned(str, endptr, base, ULLONG_MAX);
+}
+#endif /* FS_64BIT_DEFINED */
+
+
+
+
+#ifdef STRTOUL_TEST
+
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+
+
+#ifndef FS_C99
+#  error "at least C99 is required for testing code"
+#endif /* FS_C99 */
+
+
+
+/** parses str with fs_strtoul/fs_strtoull and the system's, the results must be the same */
+static int compare_strtoul(const char *str, int base)
+{
+    char *fs_end, *sys_end;
+    unsigned long fs_result = fs_strtoul(str, &fs_end, base);
+    unsigned long sys_result = strtoul(str, &sys_end, base);
+    unsigned long long fs_result_ll = fs_strtoull(str, &fs_end, base);
+    unsigned long long sys_result_ll = strtoull(str, &sys_end, base);
+
+    if (fs_result != sys_result || fs_end != sys_end)
+    {
+        printf("  [ERROR]: fs_strtoul(\"%s\", %d) was %lu, end %d, expected %lu, end %d\n", 
+            str, base, fs_result, (int)(fs_end - str), sys_result, (int)(sys_end - str));
+        return 0;
+    }
+    if (fs_result_ll != sys_result_ll || fs_end != sys_end)
+    {
+        printf("  [ERROR]: fs_strtoull(\"%s\", %d) was %llu, end %d, expected %llu, end %d\n", 
+            str, base, fs_result_ll, (int)(fs_end - str), sys_result_ll, (int)(sys_end - str));
+        return 0;
+    }
+    return 1;
+}
+
+
+int main(void)
+{
+    static const char *s_cases[] = {
+        "0", "1", "-1", "+7", "  \t42abc", "12345678", "123456789", "1234567890123456", 
+        "4294967295", "4294967296", "-4294967295", "-4294967296", "99999999999", 
+        "18446744073709551615", "18446744073709551616", "-18446744073709551615", 
+        "-18446744073709551616", "99999999999999999999", "0000000000000000000000000042", 
+        "000000000000000000000000018446744073709551615", "123456789012345678901234567890", 
+        "0x", "0x1G", "0X7fffFFFF", "0xffffffffffffffff", "0x10000000000000000", "010", 
+        "0777", "08", "z", "Zz", "-", "+", "", " ", "1 2", "0b101", "101",
+    };
+    static const int s_bases[] = { 0, 2, 8, 10, 16, 36 };
+    char buf[64];
+    char *end;
+    unsigned i, j;
+    const char *seed_env = getenv("FS_TEST_SEED");
+    unsigned seed = NULL != seed_env ? (unsigned)strtoul(seed_env, NULL, 0) : 1;
+
+    printf("[INFO]: Now test fs_strtoul against strtoul\n");
+    for (i = 0; i < FS_STATIC_ARRAYSIZE(s_cases); i += 1)
+    {
+        for (j = 0; j < FS_STATIC_ARRAYSIZE(s_bases); j += 1)
+        {
+            if (!compare_strtoul(s_cases[i], s_bases[j]))
+                exit(1);
+        }
+    }
+    if (0 != fs_strtoul("12", &end, 1) || strcmp(end, "12") != 0
+    || 0 != fs_strtoul("12", &end, 37) || strcmp(end, "12") != 0)
+    {
+        printf("  [ERROR]: invalid base\n");
+        exit(1);
+    }
+    printf("  test fixed cases passed\n");
+
+    /* a fixed sequence unless FS_TEST_SEED=<n> is set */
+    printf("[INFO]: Now test fs_strtoul on random numbers, seed %u\n", seed);
+    srand(seed);
+    for (i = 0; i < 1000000; i += 1)
+    {
+        unsigned long long n = 0;
+        for (j = 0; j < 5; j += 1)
+            n = n << 15 ^ (unsigned long long)rand();
+        n >>= rand() % 64;
+        snprintf(buf, sizeof buf, "%s%0*llu%s", 
+            (rand() & 1) ? "-" : "", rand() % 24, n, (rand() & 1) ? "9" : " ");
+        if (!compare_strtoul(buf, 10) || !compare_strtoul(buf, 0) 
+        || (0 == i % 16 && !compare_strtoul(buf, 2 + rand() % 35)))
+            exit(1);
+    }
+    printf("  test random numbers passed\n");
+
+    printf("All strtoul tests passed!\n");
+    return 0;
+}
+#endif /* STRTOUL_TEST */